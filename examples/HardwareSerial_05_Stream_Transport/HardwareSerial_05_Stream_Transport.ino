@@ -0,0 +1,70 @@
+/*
+  HM1X Bluetooth Stream Transport
+  SparkFun Electronics
+  License: This code is public domain but you buy me a beer 
+  if you use this and we meet someday (Beerware license).
+
+  A passthrough over any Stream, with the transport picked
+  at compile time. HM1X_BT_T<HM1X_StreamTransport> works
+  with ports the library doesn't know -- USB CDC, DMA UART
+  drivers -- here Serial1 stands in for one.
+
+  The sketch starts the port itself. Handing begin() a
+  callback lets the library move the port to another baud
+  rate and framing: to find a module that isn't at 9600,
+  and to follow it after a change.
+
+  Works well with a SparkFun SAMD21 Dev Breakout -- 
+  connecting via hardware serial (D0, D1).
+
+  Hardware Connections:
+  Bluetooth Mate 4.0 --------- SparkFun SAMD21 Dev Breakout
+       GND ----------------------------- GND
+       3.3VV -------------------------- 3.3V
+       TX ------------------------------ 0/RX
+       RX ------------------------------ 1/TX
+*/
+
+// Use Library Manager or download here: https://github.com/sparkfun/SparkFun_HM1X_Bluetooth_Arduino_Library
+#include <SparkFun_HM1X_Bluetooth_Arduino_Library.h>
+#include <HM1X_BT_T.h>
+
+HM1X_BT_T<HM1X_StreamTransport> bt;
+
+#define SerialPort SerialUSB // Abstract serial monitor debug port
+
+// Called by the library whenever the module's baud rate
+// or framing changes
+void moveBaud(unsigned long baud, HM1X_Core::HM1X_stop_bits_t stopBits,
+              HM1X_Core::HM1X_parity_t parity, void * context) {
+  HM1X_HardwareSerialTransport::begin(Serial1, baud, stopBits, parity);
+}
+
+void setup() {
+  SerialPort.begin(9600); // Serial debug port @ 9600 bps
+  Serial1.begin(9600);
+
+  // bt.begin --
+  // takes whatever HM1X_StreamTransport::attach() does:
+  // the Stream, the baud it's running at and the
+  // callback that moves it
+  // Returns true on success
+  if (bt.begin(Serial1, 9600, moveBaud) == false) {
+    SerialPort.println(F("Failed to connect to the HM-13."));
+    while (1) ;
+  }
+  SerialPort.println("Ready to Bluetooth!");
+}
+
+void loop() {
+  // If data is available from bt module, 
+  // print it to serial port
+  if (bt.available()) {
+    SerialPort.write((char) bt.read());
+  }
+  // If data is available from serial port,
+  // print it to bt module.
+  if (SerialPort.available()) {
+    bt.write((uint8_t) SerialPort.read());
+  }
+}
@@ -0,0 +1,60 @@
+/*
+  HM1X Bluetooth I2C (Qwiic) Compile-Time Transport
+  SparkFun Electronics
+  License: This code is public domain but you buy me a beer 
+  if you use this and we meet someday (Beerware license).
+
+  The Qwiic passthrough, with the transport picked at
+  compile time. HM1X_BT_T<HM1X_WireTransport> only talks
+  to the Qwiic bridge, so available(), read() and write()
+  go straight to it and the serial transports are left
+  out of the build.
+
+  Works well with a SparkFun Blackboard -- connecting
+  Qwiic connectors together.
+
+  Hardware Connections:
+  Bluetooth Mate 4.0 --------- SparkFun Blackboard
+       GND ----------------------------- GND
+       3.3VV -------------------------- 3.3V
+       SDA -------------------------- (Qwiic) SDA
+       SCL -------------------------- (QWiic) SCL
+*/
+
+// Use Library Manager or download here: https://github.com/sparkfun/SparkFun_HM1X_Bluetooth_Arduino_Library
+#include <SparkFun_HM1X_Bluetooth_Arduino_Library.h>
+#include <HM1X_BT_T.h>
+#include <Wire.h>
+
+HM1X_BT_T<HM1X_WireTransport> bt;
+
+void setup() {
+  Serial.begin(9600); // Serial debug port @ 9600 bps
+
+  // bt.begin --
+  // takes whatever HM1X_WireTransport::attach() does:
+  // a TwoWire (I2C) port and the I2C address
+  // Returns true on success
+  if (bt.begin(Wire, QWIIC_BLUETOOTH_DEFAULT_ADDRESS) == false) {
+    Serial.println("Failed to connect to the HM-13.");
+    while (1) ;
+  }
+  // bt.transport() is the Qwiic bridge itself
+  Serial.print("Bridge moves ");
+  Serial.print(bt.transport().chunkSize());
+  Serial.println(" bytes a transaction");
+  Serial.println("Ready to Bluetooth!");
+}
+
+void loop() {
+  // If data is available from bt module, 
+  // print it to serial port
+  if (bt.available()) {
+    Serial.write((char) bt.read());
+  }
+  // If data is available from serial port,
+  // print it to bt module.
+  if (Serial.available()) {
+    bt.write((uint8_t) Serial.read());
+  }
+}
@@ -0,0 +1,61 @@
+/*
+  HM1X Bluetooth on a Linux host
+
+  Connects to an HM1X module on a USB-UART adapter, prints its BLE
+  address, then passes data between the module and stdin/stdout.
+
+  Build from the library root:
+    g++ -std=gnu++11 -Isrc extras/posix/HM1X_Gateway.cpp src/[A-Z]*.cpp -o hm1x_gateway
+  Run:
+    ./hm1x_gateway /dev/ttyUSB0 9600
+
+  License: This code is public domain but you buy me a beer
+  if you use this and we meet someday (Beerware license).
+*/
+
+#include <SparkFun_HM1X_Bluetooth_Arduino_Library.h>
+#include <HM1X_PosixSerial.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+int main(int argc, char ** argv)
+{
+    HM1X_PosixSerial port;
+    HM1X_BT bt;
+    const char * path = (argc > 1) ? argv[1] : "/dev/ttyUSB0";
+    unsigned long baud = (argc > 2) ? strtoul(argv[2], NULL, 10) : 9600;
+    char address[32] = {0};
+
+    if (port.begin(path, baud) != HM1X_SUCCESS)
+    {
+        fprintf(stderr, "Can't open %s\n", path);
+        return 1;
+    }
+    // Let the library search for the module's baud and follow it
+    if (!bt.begin(port, baud, HM1X_PosixSerial::onBaud, &port))
+    {
+        fprintf(stderr, "No module on %s\n", path);
+        return 1;
+    }
+    if (bt.bleAddress(address) == HM1X_SUCCESS)
+    {
+        printf("Connected to %s\n", address);
+    }
+
+    fcntl(STDIN_FILENO, F_SETFL, fcntl(STDIN_FILENO, F_GETFL) | O_NONBLOCK);
+    while (1)
+    {
+        char c;
+
+        while (bt.available())
+        {
+            putchar(bt.read());
+        }
+        fflush(stdout);
+        while (::read(STDIN_FILENO, &c, 1) == 1)
+        {
+            bt.write((uint8_t) c);
+        }
+        delay(1);
+    }
+}
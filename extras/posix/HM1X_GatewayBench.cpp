@@ -0,0 +1,188 @@
+/*
+  HM1X gateway benchmark
+
+  Runs HM1X_PosixGateway against simulated modules on pseudo-terminals and
+  reports aggregate throughput and round-trip latency. Each module echoes
+  a 20 byte message back to the gateway, which sends the next one as soon
+  as the echo arrives.
+
+  Build from the library root:
+    g++ -std=gnu++11 -O2 -Isrc extras/posix/HM1X_GatewayBench.cpp src/[A-Z]*.cpp -lpthread -o hm1x_bench
+  Run with 1, 4, 16 and 32 modules for 2 seconds each:
+    for n in 1 4 16 32; do ./hm1x_bench $n 2000; done
+
+  Latency includes HM1X_GATEWAY_MESSAGE_GAP -- a message isn't delivered
+  until the port has been quiet that long.
+
+  License: This code is public domain but you buy me a beer
+  if you use this and we meet someday (Beerware license).
+*/
+
+#include <HM1X_PosixGateway.h>
+#include <pthread.h>
+#include <poll.h>
+
+#define MAX_MODULES HM1X_GATEWAY_MAX_MODULES
+#define MESSAGE_SIZE 20
+#define SIM_GAP 2 // ms the simulated module waits for the rest of a message
+
+static const uint8_t message[MESSAGE_SIZE + 1] = "0123456789abcdefghij";
+
+static HM1X_PosixGateway gateway;
+static HM1X_PosixSerial simPorts[MAX_MODULES];
+static int moduleCount;
+static volatile boolean simRunning = true;
+
+static unsigned long sentAt[MAX_MODULES];
+static unsigned long messages;
+static unsigned long bytes;
+static double latencyTotal;
+static int ready;
+
+// Simulated modules -- answer the AT commands the library sends during
+// setup, echo everything else
+static void * simulate(void *)
+{
+    struct pollfd fds[MAX_MODULES];
+    char rx[MAX_MODULES][HM1X_GATEWAY_RX_BUFFER_SIZE];
+    size_t rxCount[MAX_MODULES] = {0};
+    unsigned long lastRx[MAX_MODULES] = {0};
+
+    while (simRunning)
+    {
+        for (int i = 0; i < moduleCount; i++)
+        {
+            fds[i].fd = simPorts[i].fd();
+            fds[i].events = POLLIN;
+        }
+        ::poll(fds, moduleCount, 1);
+
+        for (int i = 0; i < moduleCount; i++)
+        {
+            const char * reply = "ERROR";
+            int c;
+
+            while ((rxCount[i] < sizeof(rx[i]) - 1) && ((c = simPorts[i].read()) >= 0))
+            {
+                rx[i][rxCount[i]++] = c;
+                lastRx[i] = millis();
+            }
+            if ((rxCount[i] == 0) || (millis() - lastRx[i] < SIM_GAP))
+            {
+                continue;
+            }
+            rx[i][rxCount[i]] = 0;
+
+            if (strncmp(rx[i], "AT", 2) != 0)
+            {
+                reply = NULL;
+                simPorts[i].write((const uint8_t *) rx[i], rxCount[i]);
+            }
+            else if (strcmp(rx[i], "AT") == 0)
+            {
+                reply = "OK";
+            }
+            else if ((strncmp(rx[i], "AT+NOTI", 7) == 0) || (strncmp(rx[i], "AT+NOTP", 7) == 0))
+            {
+                reply = (rx[i][7] == '0') ? "OK+Set:0" : "OK+Set:1";
+            }
+            else if (strcmp(rx[i], "AT+ADDB?") == 0)
+            {
+                reply = "OK+Get:001122334455";
+            }
+            if (reply != NULL)
+            {
+                simPorts[i].write((const uint8_t *) reply, strlen(reply));
+            }
+            rxCount[i] = 0;
+        }
+    }
+    return NULL;
+}
+
+static void handleData(uint8_t module, const uint8_t *, size_t size, void *)
+{
+    messages++;
+    bytes += size;
+    latencyTotal += micros() - sentAt[module];
+
+    sentAt[module] = micros();
+    gateway.write(module, message, MESSAGE_SIZE);
+}
+
+static void handleResponse(uint8_t module, HM1X_error_t err, const char * response, void *)
+{
+    if (err == HM1X_SUCCESS)
+    {
+        printf("Module %d: %s\n", module, response);
+    }
+    ready++;
+}
+
+int main(int argc, char ** argv)
+{
+    unsigned long duration = (argc > 2) ? strtoul(argv[2], NULL, 10) : 2000;
+    unsigned long start;
+    double seconds;
+    pthread_t simThread;
+    static char paths[MAX_MODULES][64];
+
+    moduleCount = (argc > 1) ? atoi(argv[1]) : 4;
+    if ((moduleCount < 1) || (moduleCount > MAX_MODULES))
+    {
+        fprintf(stderr, "1 to %d modules\n", MAX_MODULES);
+        return 1;
+    }
+
+    gateway.begin();
+    gateway.onData(handleData);
+
+    // The simulator holds each pty's master, the gateway opens the slave
+    for (int i = 0; i < moduleCount; i++)
+    {
+        if (simPorts[i].beginPty(paths[i], sizeof(paths[i])) != HM1X_SUCCESS)
+        {
+            fprintf(stderr, "Can't open a pseudo-terminal\n");
+            return 1;
+        }
+    }
+    pthread_create(&simThread, NULL, simulate, NULL);
+    for (int i = 0; i < moduleCount; i++)
+    {
+        if (gateway.add(paths[i], 9600) != i)
+        {
+            fprintf(stderr, "Module %d didn't respond on %s\n", i, paths[i]);
+            return 1;
+        }
+    }
+
+    // Commands to every module at once
+    for (int i = 0; i < moduleCount; i++)
+    {
+        gateway.command(i, "ADDB?", handleResponse);
+    }
+    while (ready < moduleCount)
+    {
+        gateway.run(-1);
+    }
+
+    start = millis();
+    for (int i = 0; i < moduleCount; i++)
+    {
+        sentAt[i] = micros();
+        gateway.write(i, message, MESSAGE_SIZE);
+    }
+    while (millis() - start < duration)
+    {
+        gateway.run(duration - (millis() - start));
+    }
+    seconds = (millis() - start) / 1000.0;
+
+    printf("modules=%2d  messages/s=%8.1f  bytes/s=%8.0f  mean latency=%.2f ms\n",
+           moduleCount, messages / seconds, bytes / seconds,
+           (messages > 0) ? latencyTotal / messages / 1000.0 : 0.0);
+
+    simRunning = false;
+    pthread_join(simThread, NULL);
+    return 0;
+}
@@ -0,0 +1,164 @@
+/*
+  Heap allocation tracker for the SparkFun HM1X Bluetooth Arduino Library
+  soak test
+
+  See HM1X_AllocTrack.h.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "HM1X_AllocTrack.h"
+#include <errno.h>
+#include <malloc.h>
+#include <atomic>
+#include <new>
+
+// glibc's own allocator, under the names it exports for wrappers like this
+extern "C" {
+void * __libc_malloc(size_t size);
+void * __libc_calloc(size_t count, size_t size);
+void * __libc_realloc(void * ptr, size_t size);
+void * __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void * ptr);
+}
+
+static std::atomic<uint32_t> trackAllocations(0);
+static std::atomic<uint32_t> trackIgnored(0);
+static std::atomic<long> trackLiveCount(0);
+static std::atomic<long> trackLiveBytes(0);
+static std::atomic<long> trackPeakBytes(0);
+
+static void * tracked(void * ptr)
+{
+    long bytes;
+    long peak;
+
+    if (ptr == NULL)
+    {
+        return NULL;
+    }
+    trackAllocations++;
+    if (HM1X_AllocTrack::Ignore::depth() > 0)
+    {
+        trackIgnored++;
+    }
+    trackLiveCount++;
+    bytes = (trackLiveBytes += malloc_usable_size(ptr));
+    peak = trackPeakBytes;
+    while ((bytes > peak) && !trackPeakBytes.compare_exchange_weak(peak, bytes))
+        ;
+    return ptr;
+}
+
+static void untracked(void * ptr)
+{
+    if (ptr != NULL)
+    {
+        trackLiveCount--;
+        trackLiveBytes -= malloc_usable_size(ptr);
+    }
+}
+
+void HM1X_AllocTrack::snapshot(snapshot_t * snap)
+{
+    snap->allocations = trackAllocations;
+    snap->ignored = trackIgnored;
+    snap->liveCount = trackLiveCount;
+    snap->liveBytes = trackLiveBytes;
+    snap->peakBytes = trackPeakBytes;
+#if (__GLIBC__ > 2) || ((__GLIBC__ == 2) && (__GLIBC_MINOR__ >= 33))
+    snap->heapFree = mallinfo2().fordblks;
+#else
+    snap->heapFree = (size_t) mallinfo().fordblks;
+#endif
+}
+
+void HM1X_AllocTrack::resetPeak(void)
+{
+    trackPeakBytes = (long) trackLiveBytes;
+}
+
+extern "C" {
+
+void * malloc(size_t size)
+{
+    return tracked(__libc_malloc(size));
+}
+
+void * calloc(size_t count, size_t size)
+{
+    return tracked(__libc_calloc(count, size));
+}
+
+void * realloc(void * ptr, size_t size)
+{
+    untracked(ptr);
+    return tracked(__libc_realloc(ptr, size));
+}
+
+void * memalign(size_t alignment, size_t size)
+{
+    return tracked(__libc_memalign(alignment, size));
+}
+
+void * aligned_alloc(size_t alignment, size_t size)
+{
+    return tracked(__libc_memalign(alignment, size));
+}
+
+int posix_memalign(void ** ptr, size_t alignment, size_t size)
+{
+    *ptr = tracked(__libc_memalign(alignment, size));
+    return (*ptr != NULL) ? 0 : ENOMEM;
+}
+
+void free(void * ptr)
+{
+    untracked(ptr);
+    __libc_free(ptr);
+}
+
+}
+
+void * operator new(size_t size)
+{
+    void * ptr = malloc(size);
+
+    if (ptr == NULL)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void * operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void * ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void * ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void * ptr, size_t size) noexcept
+{
+    (void) size;
+    free(ptr);
+}
+
+void operator delete[](void * ptr, size_t size) noexcept
+{
+    (void) size;
+    free(ptr);
+}
@@ -0,0 +1,62 @@
+/*
+  Heap allocation tracker for the SparkFun HM1X Bluetooth Arduino Library
+  soak test
+
+  Linking HM1X_AllocTrack.cpp into a host program replaces malloc, calloc,
+  realloc, free and operator new/delete with versions that count what's
+  live. Take a snapshot, run something many times, take another: if the
+  live count or bytes went up, something leaked.
+
+    HM1X_AllocTrack::snapshot_t before, after;
+    HM1X_AllocTrack::snapshot(&before);
+    ...
+    HM1X_AllocTrack::snapshot(&after);
+
+  Counts are for the whole program -- simulator included -- so compare
+  snapshots after a warm-up call, once the simulator's own buffers have
+  grown to size. Allocations made while an HM1X_AllocTrack::Ignore is in
+  scope on the same thread are also counted in ignored; the simulator
+  holds one in every public call, so allocations - ignored is what the
+  library itself allocated.
+
+  glibc can't report its largest free block, so heapFree (all free bytes
+  the allocator holds) stands in for fragmentation: it climbs while live
+  bytes stay flat when the heap is being chopped up.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+class HM1X_AllocTrack {
+public:
+    typedef struct {
+        uint32_t allocations; // Since the program started
+        uint32_t ignored;     // Of those, made inside an Ignore
+        long liveCount;       // Blocks allocated and not yet freed
+        long liveBytes;
+        long peakBytes;       // Most live bytes since resetPeak()
+        size_t heapFree;      // Free bytes the allocator is holding
+    } snapshot_t;
+
+    static void snapshot(snapshot_t * snap);
+    // Start peakBytes again from what's live now
+    static void resetPeak(void);
+
+    // Marks allocations until the end of the scope as someone else's.
+    // Header-only, so code that uses it builds without the tracker.
+    class Ignore {
+    public:
+        Ignore() { depth()++; };
+        ~Ignore() { depth()--; };
+        static int & depth(void) { static thread_local int count = 0; return count; };
+    };
+};
@@ -0,0 +1,585 @@
+/*
+  HM-13 simulator for the SparkFun HM1X Bluetooth Arduino Library
+
+  See HM1X_Simulator.h.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "HM1X_Simulator.h"
+#include "HM1X_AllocTrack.h"
+
+#define SIM_DEFAULT_LATENCY 5     // ms
+#define SIM_DEFAULT_BOOT_TIME 500 // ms
+#define SIM_DEFAULT_COMMAND_GAP 5 // ms
+
+// Names are matched longest first, so IBEA wins over IBE0 and STOPE over STOP
+const HM1X_Simulator::command_t HM1X_Simulator::_commandTable[] = {
+    { "RESET", SIM_ACTION, NULL },
+    { "RENEW", SIM_ACTION, NULL },
+    { "BONDE", SIM_ACTION, NULL },
+    { "BONDB", SIM_ACTION, NULL },
+    { "CLEAE", SIM_ACTION, NULL },
+    { "CLEAB", SIM_ACTION, NULL },
+    { "STARE", SIM_ACTION, NULL },
+    { "STARB", SIM_ACTION, NULL },
+    { "STOPE", SIM_ACTION, NULL },
+    { "STOPB", SIM_ACTION, NULL },
+    { "VERR", SIM_READ_ONLY, "V112" },
+    { "ADDE", SIM_READ_ONLY, "001122334455" },
+    { "ADDB", SIM_READ_ONLY, "001122334456" },
+    { "RADE", SIM_READ_ONLY, "000000000000" },
+    { "RADB", SIM_READ_ONLY, "000000000000" },
+    { "INIT", SIM_SETTING, "1" },
+    { "NOTI", SIM_SETTING, "0" },
+    { "NOTP", SIM_SETTING, "0" },
+    { "NAME", SIM_SETTING, "HMSoft" },
+    { "NAMB", SIM_SETTING, "HMSoft" },
+    { "ROLE", SIM_SETTING, "0" },
+    { "ROLB", SIM_SETTING, "0" },
+    { "HIGH", SIM_SETTING, "0" },
+    { "DUAL", SIM_SETTING, "0" },
+    { "MODE", SIM_SETTING, "0" },
+    { "ATOB", SIM_SETTING, "0" },
+    { "AUTH", SIM_SETTING, "1" },
+    { "PINE", SIM_SETTING, "1234" },
+    { "PINB", SIM_SETTING, "000000" },
+    { "COFD", SIM_SETTING, "001F00" },
+    { "COUP", SIM_SETTING, "1" },
+    { "IBEA", SIM_SETTING, "0" },
+    { "IBE0", SIM_SETTING, "74278BDA" },
+    { "IBE1", SIM_SETTING, "B6444520" },
+    { "IBE2", SIM_SETTING, "8F0C720E" },
+    { "IBE3", SIM_SETTING, "AF059935" },
+    { "MAJO", SIM_SETTING, "FFE0" },
+    { "MINO", SIM_SETTING, "FFE1" },
+    { "MEAS", SIM_SETTING, "C5" },
+    { "MTUS", SIM_SETTING, "0" },
+    { "SCAN", SIM_SETTING, "0" },
+    { "SAFE", SIM_SETTING, "0" },
+    { "ONEM", SIM_SETTING, "0" },
+    { "PIO0", SIM_SETTING, "0" },
+    { "PIO1", SIM_SETTING, "0" },
+    { "PIO2", SIM_SETTING, "0" },
+    { "PIO3", SIM_SETTING, "0" },
+    { "RESP", SIM_SETTING, "0" },
+    { "IMME", SIM_SETTING, "0" },
+    { "IMMB", SIM_SETTING, "0" },
+    { "BAUD", SIM_SETTING, "2" },
+    { "FIOW", SIM_SETTING, "0" },
+    { "STOP", SIM_SETTING, "0" },
+    { "PARI", SIM_SETTING, "0" },
+    { NULL, SIM_SETTING, NULL }
+};
+
+std::atomic<uint64_t> HM1X_Simulator::_virtualMicros(0);
+unsigned long HM1X_Simulator::_stepMicros = 0;
+
+// AT+BAUD parameter '1'..'7'
+static const unsigned long simBauds[] = { 4800, 9600, 19200, 38400, 57600, 115200, 230400 };
+
+HM1X_Simulator::HM1X_Simulator() :
+    _inputTime(0), _lineFree(0),
+    _moduleBaud(9600), _moduleStopBits(HM1X_Core::HM1X_STOP_BITS_1), _moduleParity(HM1X_Core::HM1X_PARITY_NONE),
+    _hostBaud(9600), _hostStopBits(HM1X_Core::HM1X_STOP_BITS_1), _hostParity(HM1X_Core::HM1X_PARITY_NONE),
+    _latency(SIM_DEFAULT_LATENCY * 1000), _bootTime(SIM_DEFAULT_BOOT_TIME * 1000),
+    _commandGap(SIM_DEFAULT_COMMAND_GAP * 1000), _pacing(true), _bootUntil(0), _booting(false),
+    _seed(1), _dropRate(0), _garbleRate(0), _missingOkRate(0), _resetRate(0),
+    _connectedBle(false), _connectedEdr(false), _commands(0), _faults(0)
+{
+    // Powered and ready -- a sketch's begin() runs long after power-up
+    restoreDefaults();
+}
+
+void HM1X_Simulator::useVirtualTime(unsigned long stepMicros)
+{
+    _stepMicros = (stepMicros > 0) ? stepMicros : 1;
+    HM1X_Clock::setClock(virtualMillis);
+    HM1X_Clock::setYield(virtualYield);
+}
+
+unsigned long HM1X_Simulator::virtualMillis(void * context)
+{
+    (void) context;
+    return (unsigned long) (_virtualMicros.load() / 1000);
+}
+
+void HM1X_Simulator::virtualYield(void * context)
+{
+    (void) context;
+    _virtualMicros += _stepMicros;
+}
+
+int HM1X_Simulator::available(void)
+{
+    HM1X_AllocTrack::Ignore ignore; // The simulator's, not the library's
+    unsigned long now;
+    int count = 0;
+
+    update();
+    now = clockMicros();
+    for (std::deque<output_t>::iterator it = _output.begin(); it != _output.end(); ++it)
+    {
+        if ((long) (now - it->at) < 0)
+        {
+            break;
+        }
+        count++;
+    }
+    return count;
+}
+
+int HM1X_Simulator::read(void)
+{
+    int c = peek();
+
+    if (c >= 0)
+    {
+        _output.pop_front();
+    }
+    return c;
+}
+
+int HM1X_Simulator::peek(void)
+{
+    HM1X_AllocTrack::Ignore ignore;
+    update();
+    if (_output.empty() || ((long) (clockMicros() - _output.front().at) < 0))
+    {
+        return -1;
+    }
+    return _output.front().c;
+}
+
+size_t HM1X_Simulator::write(const uint8_t * buffer, size_t size)
+{
+    HM1X_AllocTrack::Ignore ignore;
+    update();
+    if (_booting)
+    {
+        return size; // Nobody listening yet
+    }
+    for (size_t i = 0; i < size; i++)
+    {
+        // Wrong framing never decodes as ASCII, so it can't form a command
+        _input += (char) (framingMatches() ? buffer[i] : (buffer[i] | 0x80));
+    }
+    _inputTime = clockMicros();
+    return size;
+}
+
+void HM1X_Simulator::setHostFraming(unsigned long baud, HM1X_Core::HM1X_stop_bits_t stopBits,
+                                    HM1X_Core::HM1X_parity_t parity)
+{
+    HM1X_AllocTrack::Ignore ignore;
+    update();
+    _hostBaud = baud;
+    _hostStopBits = stopBits;
+    _hostParity = parity;
+}
+
+void HM1X_Simulator::onBaud(unsigned long baud, HM1X_Core::HM1X_stop_bits_t stopBits,
+                            HM1X_Core::HM1X_parity_t parity, void * context)
+{
+    ((HM1X_Simulator *) context)->setHostFraming(baud, stopBits, parity);
+}
+
+void HM1X_Simulator::powerCycle(void)
+{
+    HM1X_AllocTrack::Ignore ignore;
+    update();
+    restart(clockMicros());
+}
+
+void HM1X_Simulator::connect(boolean ble, const char * address)
+{
+    HM1X_AllocTrack::Ignore ignore;
+    std::string peer(address);
+
+    update();
+    if (ble)
+    {
+        _connectedBle = true;
+        _peerAddressBle = peer;
+        _settings["RADB"] = peer;
+        notify("OK+CONB", peer, clockMicros());
+    }
+    else
+    {
+        _connectedEdr = true;
+        _peerAddressEdr = peer;
+        _settings["RADE"] = peer;
+        notify("OK+CONE", peer, clockMicros());
+    }
+}
+
+void HM1X_Simulator::disconnect(boolean ble)
+{
+    HM1X_AllocTrack::Ignore ignore;
+    update();
+    if (ble && _connectedBle)
+    {
+        _connectedBle = false;
+        notify("OK+LSTB", _peerAddressBle, clockMicros());
+    }
+    else if (!ble && _connectedEdr)
+    {
+        _connectedEdr = false;
+        notify("OK+LSTE", _peerAddressEdr, clockMicros());
+    }
+}
+
+void HM1X_Simulator::addAdvertiser(const char * address, int rssi, const char * name)
+{
+    HM1X_AllocTrack::Ignore ignore;
+    advertiser_t device;
+
+    device.address = address;
+    device.rssi = rssi;
+    device.name = name;
+    _advertisers.push_back(device);
+}
+
+void HM1X_Simulator::peerSend(const char * data)
+{
+    peerSend((const uint8_t *) data, strlen(data));
+}
+
+void HM1X_Simulator::peerSend(const uint8_t * data, size_t length)
+{
+    HM1X_AllocTrack::Ignore ignore;
+    update();
+    if (_connectedBle || _connectedEdr)
+    {
+        send(std::string((const char *) data, length), clockMicros());
+    }
+}
+
+std::string HM1X_Simulator::peerReceived(void)
+{
+    HM1X_AllocTrack::Ignore ignore;
+    std::string received;
+
+    update();
+    received.swap(_peerReceived);
+    return received;
+}
+
+std::string HM1X_Simulator::setting(const char * name)
+{
+    HM1X_AllocTrack::Ignore ignore;
+    std::map<std::string, std::string>::iterator it = _settings.find(name);
+
+    return (it != _settings.end()) ? it->second : std::string();
+}
+
+boolean HM1X_Simulator::booting(void)
+{
+    HM1X_AllocTrack::Ignore ignore;
+    update();
+    return _booting;
+}
+
+// Catch up on everything that should have happened by now. Times are
+// taken from when things happened, not from when we got around to them,
+// so a host that busy-waits without reading sees the same timing as one
+// that polls.
+void HM1X_Simulator::update(void)
+{
+    unsigned long now = clockMicros();
+
+    if (_booting && ((long) (now - _bootUntil) >= 0))
+    {
+        _booting = false;
+        if (setting("INIT") == "1")
+        {
+            send("OK+INIT", _bootUntil);
+        }
+    }
+    if (!_input.empty() && (now - _inputTime >= _commandGap))
+    {
+        std::string text;
+
+        text.swap(_input);
+        process(text, _inputTime + _commandGap);
+    }
+}
+
+// Power-up: anything in flight is lost, the UART comes up with the
+// settings in flash, and OK+INIT follows once booted
+void HM1X_Simulator::restart(unsigned long at)
+{
+    int baud = atoi(setting("BAUD").c_str());
+
+    _input.clear();
+    cancelOutput(at);
+    _connectedBle = false;
+    _connectedEdr = false;
+
+    _moduleBaud = ((baud >= 1) && (baud <= 7)) ? simBauds[baud - 1] : 9600;
+    _moduleStopBits = (setting("STOP") == "1") ? HM1X_Core::HM1X_STOP_BITS_2 : HM1X_Core::HM1X_STOP_BITS_1;
+    if (setting("PARI") == "1")
+    {
+        _moduleParity = HM1X_Core::HM1X_PARITY_EVEN;
+    }
+    else if (setting("PARI") == "2")
+    {
+        _moduleParity = HM1X_Core::HM1X_PARITY_ODD;
+    }
+    else
+    {
+        _moduleParity = HM1X_Core::HM1X_PARITY_NONE;
+    }
+
+    _booting = true;
+    _bootUntil = at + _bootTime;
+}
+
+// Bytes already on the wire make it out, the rest are never sent
+void HM1X_Simulator::cancelOutput(unsigned long at)
+{
+    while (!_output.empty() && ((long) (_output.back().at - at) > 0))
+    {
+        _output.pop_back();
+    }
+    _lineFree = at;
+}
+
+// A round of BLE discovery -- every advertiser in range, in turn
+void HM1X_Simulator::discover(unsigned long at)
+{
+    char rssi[16];
+
+    send("OK+DISCS", at);
+    for (size_t i = 0; i < _advertisers.size(); i++)
+    {
+        const advertiser_t & device = _advertisers[i];
+
+        snprintf(rssi, sizeof(rssi), "%04d", device.rssi);
+        send("OK+DIS0:" + device.address, at);
+        send(std::string("OK+RSSI:") + rssi, at);
+        if (!device.name.empty())
+        {
+            send("OK+NAME:" + device.name + "\r\n", at);
+        }
+    }
+    send("OK+DISCE", at);
+}
+
+// One complete burst of input from the host
+void HM1X_Simulator::process(const std::string & text, unsigned long at)
+{
+    std::string response;
+    boolean restartAfter = false;
+
+    // Connected: everything but a bare AT goes to the peer. AT drops the
+    // link and answers with the peer's address whatever NOTI/NOTP say.
+    if (_connectedBle || _connectedEdr)
+    {
+        if (text == "AT")
+        {
+            if (_connectedBle)
+            {
+                _connectedBle = false;
+                send("OK+LSTB:" + _peerAddressBle, at + _latency);
+            }
+            else
+            {
+                _connectedEdr = false;
+                send("OK+LSTE:" + _peerAddressEdr, at + _latency);
+            }
+        }
+        else
+        {
+            _peerReceived += text;
+        }
+        return;
+    }
+
+    if (text.compare(0, 2, "AT") != 0)
+    {
+        return; // Noise
+    }
+    _commands++;
+
+    if (chance(_resetRate))
+    {
+        _faults++;
+        restart(at);
+        return;
+    }
+
+    if (text == "AT+STOPB")
+    {
+        cancelOutput(at); // Discovery still queued never happens
+    }
+    response = execute(text.substr(2), restartAfter);
+
+    if (chance(_missingOkRate))
+    {
+        _faults++;
+        response.clear(); // Done, but never confirmed
+    }
+    else if (!response.empty() && chance(_garbleRate))
+    {
+        _faults++;
+        response[_seed % response.size()] ^= (char) (1 << (_seed % 7));
+    }
+
+    send(response, at + _latency);
+    if (restartAfter)
+    {
+        restart(_lineFree);
+    }
+    else if ((text == "AT+STARB") && (setting("ROLB") == "1"))
+    {
+        discover(_lineFree);
+    }
+}
+
+std::string HM1X_Simulator::execute(const std::string & command, boolean & restartAfter)
+{
+    const command_t * match = NULL;
+    std::string name;
+    std::string argument;
+
+    if (command.empty())
+    {
+        return "OK";
+    }
+    if (command[0] != '+')
+    {
+        return "ERROR";
+    }
+    for (const command_t * entry = _commandTable; entry->name != NULL; entry++)
+    {
+        size_t length = strlen(entry->name);
+
+        if ((command.compare(1, length, entry->name) == 0) &&
+            ((match == NULL) || (length > strlen(match->name))))
+        {
+            match = entry;
+        }
+    }
+    if (match == NULL)
+    {
+        return "ERROR";
+    }
+    name = match->name;
+    argument = command.substr(1 + name.size());
+
+    if (match->kind == SIM_ACTION)
+    {
+        if (!argument.empty())
+        {
+            return "ERROR";
+        }
+        if (name == "RENEW")
+        {
+            restoreDefaults();
+            restartAfter = true;
+        }
+        else if (name == "RESET")
+        {
+            restartAfter = true;
+        }
+        else if (name == "CLEAE")
+        {
+            _settings["RADE"] = "000000000000";
+        }
+        else if (name == "CLEAB")
+        {
+            _settings["RADB"] = "000000000000";
+        }
+        return "OK+" + name;
+    }
+
+    if (argument == "?")
+    {
+        return "OK+Get:" + _settings[name];
+    }
+    if ((match->kind == SIM_READ_ONLY) || argument.empty())
+    {
+        return "ERROR";
+    }
+    _settings[name] = argument;
+    return "OK+Set:" + argument;
+}
+
+// Queue text for the host, one byte after another at the UART's rate
+void HM1X_Simulator::send(const std::string & text, unsigned long at)
+{
+    boolean garble = !framingMatches();
+
+    if ((long) (_lineFree - at) < 0)
+    {
+        _lineFree = at;
+    }
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        output_t out;
+
+        _lineFree += byteTime();
+        if (chance(_dropRate))
+        {
+            _faults++;
+            continue;
+        }
+        out.c = garble ? (uint8_t) (text[i] | 0x80) : (uint8_t) text[i];
+        out.at = _lineFree;
+        _output.push_back(out);
+    }
+}
+
+void HM1X_Simulator::notify(const char * prefix, const std::string & address, unsigned long at)
+{
+    if (setting("NOTI") != "1")
+    {
+        return;
+    }
+    send((setting("NOTP") == "1") ? std::string(prefix) + ":" + address : std::string(prefix), at);
+}
+
+boolean HM1X_Simulator::framingMatches(void)
+{
+    return (_hostBaud == _moduleBaud) && (_hostStopBits == _moduleStopBits) &&
+           (_hostParity == _moduleParity);
+}
+
+// One start bit, eight data bits, parity, stop bits
+unsigned long HM1X_Simulator::byteTime(void)
+{
+    unsigned long bits = 9 + ((_moduleStopBits == HM1X_Core::HM1X_STOP_BITS_2) ? 2 : 1) +
+                         ((_moduleParity != HM1X_Core::HM1X_PARITY_NONE) ? 1 : 0);
+
+    return _pacing ? (bits * 1000000UL) / _moduleBaud : 0;
+}
+
+// xorshift32 -- the same seed gives the same run
+boolean HM1X_Simulator::chance(float rate)
+{
+    if (rate <= 0)
+    {
+        return false;
+    }
+    _seed ^= _seed << 13;
+    _seed ^= _seed >> 17;
+    _seed ^= _seed << 5;
+    return ((float) (_seed % 10000) < rate * 10000.0);
+}
+
+void HM1X_Simulator::restoreDefaults(void)
+{
+    for (const command_t * entry = _commandTable; entry->name != NULL; entry++)
+    {
+        if (entry->defaultValue != NULL)
+        {
+            _settings[entry->name] = entry->defaultValue;
+        }
+    }
+}
@@ -0,0 +1,202 @@
+/*
+  HM-13 simulator for the SparkFun HM1X Bluetooth Arduino Library
+
+  A software model of the module, for running the library on a Linux
+  host without hardware. It is the module's UART, seen from the host, as
+  a Stream:
+
+    HM1X_Simulator module;
+    HM1X_BT bt;
+    bt.begin(module, 9600, HM1X_Simulator::onBaud, &module);
+
+  For the Qwiic bridge, TwoWire (Wire.h in this directory) wraps a
+  simulator. Build with -DHM1X_I2C_ENABLED -Iextras/simulator.
+
+  Modelled:
+    - Every AT command the library sends. Queries answer OK+Get:<value>,
+      settings answer OK+Set:<value>, actions answer OK+<command>.
+    - Settings persist across RESET. RENEW restores the defaults.
+    - Baud, stop bits and parity take effect when the module restarts.
+      While the host's framing doesn't match, bytes are garbled both ways.
+    - OK+INIT after every restart (unless AT+INIT0). Input is ignored
+      while booting.
+    - Commands end after a quiet gap, as on the real module.
+    - Connect/disconnect notifications (NOTI, NOTP). Data passes through
+      to a simulated peer while connected. "AT" drops the link.
+    - BLE discovery: AT+STARB as a central (ROLB1) reports each
+      advertiser added with addAdvertiser(), between OK+DISCS and
+      OK+DISCE. AT+STOPB cuts the reports short.
+    - Configurable command latency, boot time, and byte pacing at the
+      UART's baud.
+  Faults, each a probability from 0 to 1 drawn from a seeded generator:
+    - dropped bytes
+    - garbled responses
+    - missing responses (the command still takes effect)
+    - resets in the middle of a command
+
+  Time is real time -- micros() -- unless useVirtualTime() is called
+  first. Then HM1X_Clock reads a virtual clock that only moves when the
+  library waits, so a run takes as long as the CPU needs, not as long as
+  its timeouts, and is the same every time for a given seed:
+
+    HM1X_Simulator::useVirtualTime();
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <SparkFun_HM1X_Bluetooth_Arduino_Library.h>
+#include <atomic>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#define SIM_VIRTUAL_STEP 50 // us per HM1X_Clock::idle()
+
+class HM1X_Simulator : public Stream {
+public:
+    HM1X_Simulator();
+
+    // Host side of the module's UART
+    int available(void);
+    int read(void);
+    int peek(void);
+    size_t write(uint8_t c) { return write(&c, 1); };
+    size_t write(const uint8_t * buffer, size_t size);
+    using Print::write;
+
+    // The host UART's framing. Bytes are garbled while it doesn't match
+    // the module's.
+    void setHostFraming(unsigned long baud,
+                        HM1X_Core::HM1X_stop_bits_t stopBits = HM1X_Core::HM1X_STOP_BITS_1,
+                        HM1X_Core::HM1X_parity_t parity = HM1X_Core::HM1X_PARITY_NONE);
+    // HM1X_baud_callback_t for HM1X_BT::begin(Stream &) -- context is the simulator
+    static void onBaud(unsigned long baud, HM1X_Core::HM1X_stop_bits_t stopBits,
+                       HM1X_Core::HM1X_parity_t parity, void * context);
+
+    // Timing (ms)
+    void setLatency(unsigned long ms) { _latency = ms * 1000; };       // End of command to response
+    void setBootTime(unsigned long ms) { _bootTime = ms * 1000; };     // Restart to OK+INIT
+    void setCommandGap(unsigned long ms) { _commandGap = ms * 1000; }; // Silence that ends a command
+    void setPacing(boolean enabled) { _pacing = enabled; };            // Send at the UART's byte rate
+
+    // Virtual time, for every simulator and the whole library. Each
+    // HM1X_Clock::idle() moves it on by stepMicros.
+    static void useVirtualTime(unsigned long stepMicros = SIM_VIRTUAL_STEP);
+    static void advance(unsigned long us) { _virtualMicros += us; };
+    static unsigned long clockMicros(void) { return (_stepMicros > 0) ? (unsigned long) _virtualMicros.load() : micros(); };
+
+    // Faults
+    void setSeed(uint32_t seed) { _seed = (seed != 0) ? seed : 1; };
+    void setDropRate(float rate) { _dropRate = rate; };           // Each byte sent to the host
+    void setGarbleRate(float rate) { _garbleRate = rate; };       // Each response
+    void setMissingOkRate(float rate) { _missingOkRate = rate; }; // Each command
+    void setResetRate(float rate) { _resetRate = rate; };         // Each command
+    // Power-cycle now. Settings persist.
+    void powerCycle(void);
+
+    // Simulated peer
+    void connect(boolean ble, const char * address);
+    void disconnect(boolean ble);
+    void peerSend(const char * data);            // Peer to host
+    void peerSend(const uint8_t * data, size_t length);
+    std::string peerReceived(void);              // Host to peer, since the last call
+    boolean connected(boolean ble) { return ble ? _connectedBle : _connectedEdr; };
+
+    // Simulated BLE devices in range. An empty name isn't reported.
+    void addAdvertiser(const char * address, int rssi, const char * name = "");
+    void clearAdvertisers(void) { _advertisers.clear(); };
+
+    // Inspection
+    std::string setting(const char * name);
+    unsigned long baud(void) { return _moduleBaud; };
+    boolean booting(void);
+    uint32_t commands(void) { return _commands; };
+    uint32_t faults(void) { return _faults; };
+
+private:
+    typedef enum {
+        SIM_SETTING,  // <name>? and <name><value>
+        SIM_READ_ONLY, // <name>? only
+        SIM_ACTION     // <name>, answers OK+<name>
+    } command_kind_t;
+
+    typedef struct {
+        const char * name;
+        command_kind_t kind;
+        const char * defaultValue;
+    } command_t;
+
+    typedef struct {
+        std::string address;
+        int rssi;
+        std::string name;
+    } advertiser_t;
+
+    typedef struct {
+        uint8_t c;
+        unsigned long at; // clockMicros() when it reaches the host
+    } output_t;
+
+    static const command_t _commandTable[];
+    static std::atomic<uint64_t> _virtualMicros; // Threads may share the clock
+    static unsigned long _stepMicros; // 0: real time
+
+    std::map<std::string, std::string> _settings; // "Flash"
+    std::string _input;
+    unsigned long _inputTime;
+    std::deque<output_t> _output;
+    unsigned long _lineFree;
+
+    unsigned long _moduleBaud;
+    HM1X_Core::HM1X_stop_bits_t _moduleStopBits;
+    HM1X_Core::HM1X_parity_t _moduleParity;
+    unsigned long _hostBaud;
+    HM1X_Core::HM1X_stop_bits_t _hostStopBits;
+    HM1X_Core::HM1X_parity_t _hostParity;
+
+    unsigned long _latency;
+    unsigned long _bootTime;
+    unsigned long _commandGap;
+    boolean _pacing;
+    unsigned long _bootUntil;
+    boolean _booting;
+
+    uint32_t _seed;
+    float _dropRate;
+    float _garbleRate;
+    float _missingOkRate;
+    float _resetRate;
+
+    boolean _connectedBle;
+    boolean _connectedEdr;
+    std::string _peerAddressBle;
+    std::string _peerAddressEdr;
+    std::string _peerReceived;
+    std::vector<advertiser_t> _advertisers;
+
+    uint32_t _commands;
+    uint32_t _faults;
+
+    void update(void);
+    void restart(unsigned long at);
+    void cancelOutput(unsigned long at);
+    void discover(unsigned long at);
+    void process(const std::string & text, unsigned long at);
+    std::string execute(const std::string & command, boolean & restartAfter);
+    void send(const std::string & text, unsigned long at);
+    void notify(const char * prefix, const std::string & address, unsigned long at);
+    boolean framingMatches(void);
+    unsigned long byteTime(void);
+    boolean chance(float rate);
+    void restoreDefaults(void);
+    static unsigned long virtualMillis(void * context);
+    static void virtualYield(void * context);
+};
@@ -0,0 +1,1233 @@
+/*
+  Simulator soak test for the SparkFun HM1X Bluetooth Arduino Library
+
+  Runs the unmodified library against HM1X_Simulator, first over a serial
+  Stream and then through the simulated Qwiic bridge:
+    - functional pass: names, PIOs, version, settings surviving RESET,
+      baud switching, connect/disconnect notifications, pass-through data
+      and factory defaults
+    - fault pass: repeated set/get with dropped bytes, garbled and missing
+      responses and resets, checking the library never hangs and always
+      recovers. Over Qwiic, also a stuck bus, checking recovery keeps the
+      bus clock
+    - leak pass (serial only): every public call, iterations times each,
+      under HM1X_AllocTrack, failing if live heap blocks or bytes grow --
+      or, with HM1X_NO_HEAP, if the library allocates at all
+    - the functional pass again through HM1X_BT_T, over
+      HM1X_StreamTransport and HM1X_WireTransport
+    - threaded pass (serial only): HM1X_Threaded on std::thread, with
+      several threads writing and sending commands at once, on a fresh
+      module
+    - framing pass (serial only): HM1X_Framer frames at several MTUs,
+      worst-case stuffing included, round-tripped through the parser;
+      corrupted, truncated and noisy input rejected
+    - bulk pass (serial only): HM1X_BulkTransfer between two modules over
+      a link that corrupts bursts, with the sender's CTS held off part way
+      through, checking the data arrives whole and in order
+    - scheduler pass (Qwiic only): bridge discovery and re-addressing
+      without writing to the bus, then HM1X_QwiicScheduler over a chatty
+      and a quiet module, one on the original bridge firmware, checking no
+      round goes over a module's transaction budget and all data arrives
+    - scan pass (serial only): HM1X_BleScanner over rounds of discovery
+      with hundreds of devices in range, checking every device arrives
+      whole and exactly once
+
+  g++ -std=gnu++11 -pthread -DHM1X_I2C_ENABLED -Isrc -Iextras/simulator
+      extras/simulator/HM1X_SimulatorSoak.cpp extras/simulator/HM1X_Simulator.cpp
+      extras/simulator/Wire.cpp extras/simulator/HM1X_AllocTrack.cpp
+      src/[A-Z]*.cpp -o hm1x_soak
+  ./hm1x_soak [iterations] [seed] [realtime]
+
+  Runs in virtual time (HM1X_Simulator::useVirtualTime()) unless the third
+  argument is "realtime". Times it prints are in the clock it ran on.
+
+  Add -DHM1X_NO_HEAP to soak the allocation-free build.
+
+  Exits non-zero if any functional check fails, the library doesn't
+  recover from a fault, or a call leaks.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "HM1X_Simulator.h"
+#include "HM1X_AllocTrack.h"
+#include <HM1X_Threaded.h>
+#include <HM1X_BleScanner.h>
+#include <HM1X_Framer.h>
+#include <HM1X_BulkTransfer.h>
+#include <HM1X_QwiicScheduler.h>
+#include <HM1X_BT_T.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define SOAK_BOOT_TIME 50 // ms -- short, to keep the run quick
+#define SOAK_PEER_ADDRESS "A1B2C3D4E5F6"
+#define SOAK_THREADS 3
+#define SOAK_THREAD_TIMEOUT 2000 // ms
+#define SOAK_ADVERTISERS 300
+#define SOAK_SCAN_ROUNDS 3
+#define SOAK_BULK_LENGTH 6000
+#define SOAK_BULK_STALL 1500   // ms
+#define SOAK_BULK_CORRUPT 7    // Corrupt every 7th burst on the link
+#define SOAK_BULK_TIMEOUT 120000 // ms
+#define SOAK_SCHED_DEVICES 2
+#define SOAK_SCHED_LENGTH 1500
+#define SOAK_SCHED_TIMEOUT 10000 // ms
+
+static int failures = 0;
+
+#define CHECK(condition) check((condition), #condition, __LINE__)
+
+static void check(boolean passed, const char * what, int line)
+{
+    if (!passed)
+    {
+        printf("  FAIL line %d: %s\n", line, what);
+        failures++;
+    }
+}
+
+// Let the module finish booting and throw away OK+INIT. Once polling is
+// set up, only poll() reads the port.
+static void settle(HM1X_Core & bt)
+{
+    HM1X_Clock::wait(SOAK_BOOT_TIME + 50);
+    bt.poll();
+    while (bt.available() > 0)
+    {
+        bt.read();
+    }
+}
+
+static boolean edrNameIs(HM1X_Core & bt, const char * expected)
+{
+    char name[HM1X_NAME_LENGTH + 1];
+
+    return (bt.getEdrName(name) == HM1X_SUCCESS) && (strcmp(name, expected) == 0);
+}
+
+// Poll until the wanted connection state, or give up
+static boolean waitConnected(HM1X_Core & bt, boolean wanted)
+{
+    unsigned long timeIn = HM1X_Clock::now();
+
+    while (HM1X_Clock::elapsed(timeIn) < 1000)
+    {
+        bt.poll();
+        if (bt.connectedBle() == wanted)
+        {
+            return true;
+        }
+        HM1X_Clock::idle();
+    }
+    return false;
+}
+
+// Over HM1X_BT, or HM1X_BT_T with any transport
+template <class BT>
+static void functional(BT & bt, HM1X_Simulator & module)
+{
+    char text[32];
+    uint8_t value = 0;
+    int length = 0;
+
+    CHECK(bt.setEdrName("Soak") == HM1X_SUCCESS);
+    CHECK(edrNameIs(bt, "Soak"));
+    CHECK(module.setting("NAME") == "Soak");
+    CHECK(bt.setBleName("SoakBle") == HM1X_SUCCESS);
+    CHECK((bt.getBleName(text) == HM1X_SUCCESS) && (strcmp(text, "SoakBle") == 0));
+    CHECK((bt.version(text) == HM1X_SUCCESS) && (strcmp(text, "V112") == 0));
+    CHECK(bt.writePio(2, 1) == HM1X_SUCCESS);
+    CHECK((bt.readPio(2, &value) == HM1X_SUCCESS) && (value == 1));
+    CHECK(bt.setiBeaconMajor(0x1234) == HM1X_SUCCESS);
+    CHECK(module.setting("MAJO") == "1234");
+
+    // Settings live in flash
+    CHECK(bt.reset() == HM1X_SUCCESS);
+    settle(bt);
+    CHECK(edrNameIs(bt, "Soak"));
+
+    // Baud changes take effect at the next restart
+    CHECK(bt.setBaud((uint32_t) 38400) == HM1X_SUCCESS);
+    CHECK(module.baud() == 9600);
+    CHECK(bt.reset() == HM1X_SUCCESS);
+    settle(bt);
+    CHECK(module.baud() == 38400);
+    CHECK(edrNameIs(bt, "Soak"));
+    CHECK(bt.setBaud((uint32_t) 9600) == HM1X_SUCCESS);
+    CHECK(bt.reset() == HM1X_SUCCESS);
+    settle(bt);
+    CHECK(module.baud() == 9600);
+
+    // Connect, pass data both ways, disconnect
+    CHECK(bt.notify(true, true) == HM1X_SUCCESS);
+    CHECK(bt.setupPoll());
+    module.connect(true, SOAK_PEER_ADDRESS);
+    CHECK(waitConnected(bt, true));
+    bt.connectedBleAddress(text);
+    CHECK(strcmp(text, SOAK_PEER_ADDRESS) == 0);
+    bt.write("hello");
+    HM1X_Clock::wait(20);
+    CHECK(module.peerReceived() == "hello");
+    module.peerSend("world");
+    HM1X_Clock::wait(20);
+    CHECK(!bt.poll());
+    while ((bt.available() > 0) && (length < (int) sizeof(text) - 1))
+    {
+        text[length++] = bt.read();
+    }
+    text[length] = '\0';
+    CHECK(strcmp(text, "world") == 0);
+    module.disconnect(true);
+    CHECK(waitConnected(bt, false));
+
+    // "AT" drops a connection
+    module.connect(true, SOAK_PEER_ADDRESS);
+    CHECK(waitConnected(bt, true));
+    CHECK(bt.disconnect() == HM1X_SUCCESS);
+    CHECK(!module.connected(true));
+
+    CHECK(bt.factoryDefaults() == HM1X_SUCCESS);
+    settle(bt);
+    CHECK(edrNameIs(bt, "HMSoft"));
+}
+
+// Hammer set/get with faults on. Individual calls may fail -- that's the
+// point -- but every one must return, and the library must be usable again
+// as soon as the faults stop.
+static void faults(HM1X_BT & bt, HM1X_Simulator & module, int iterations)
+{
+    int passed = 0;
+    unsigned long timeIn;
+    unsigned long longest = 0;
+
+    module.setDropRate(0.002);
+    module.setGarbleRate(0.02);
+    module.setMissingOkRate(0.02);
+    module.setResetRate(0.01);
+
+    for (int i = 0; i < iterations; i++)
+    {
+        char name[8];
+        unsigned long start = HM1X_Clock::now();
+
+        sprintf(name, "N%d", i % 1000);
+        if ((bt.setEdrName(name) == HM1X_SUCCESS) && edrNameIs(bt, name))
+        {
+            passed++;
+        }
+        else
+        {
+            settle(bt); // In case it restarted
+        }
+        if (HM1X_Clock::elapsed(start) > longest)
+        {
+            longest = HM1X_Clock::elapsed(start);
+        }
+    }
+
+    module.setDropRate(0);
+    module.setGarbleRate(0);
+    module.setMissingOkRate(0);
+    module.setResetRate(0);
+    settle(bt);
+
+    timeIn = HM1X_Clock::now();
+    CHECK(bt.setEdrName("Again") == HM1X_SUCCESS);
+    CHECK(edrNameIs(bt, "Again"));
+    printf("  %d/%d passed, %lu faults injected, longest %lu ms, recovered in %lu ms\n",
+           passed, iterations, (unsigned long) module.faults(), longest, HM1X_Clock::elapsed(timeIn));
+}
+
+static uint8_t schedReceived[SOAK_SCHED_DEVICES][SOAK_SCHED_LENGTH];
+static size_t schedLength[SOAK_SCHED_DEVICES];
+static int schedBad;
+
+static uint8_t schedByte(int device, size_t i)
+{
+    return (uint8_t) ((i * 7) + (device * 101));
+}
+
+static void schedData(uint8_t device, const uint8_t * data, uint8_t length, void * context)
+{
+    (void) context;
+    if ((device >= SOAK_SCHED_DEVICES) || (schedLength[device] + length > SOAK_SCHED_LENGTH))
+    {
+        schedBad++;
+        return;
+    }
+    memcpy(schedReceived[device] + schedLength[device], data, length);
+    schedLength[device] += length;
+}
+
+// modules[0] is chatty with a budget of 1, modules[1] sends a little with
+// a budget of 1 too small to refill its cache, and asks its bridge for a
+// byte count on every read. Both bridges fill up before the first round.
+static void scheduler(HM1X_BT * bt, HM1X_Simulator * modules, TwoWire ** wires, HM1X_BT & polled)
+{
+    static const size_t lengths[SOAK_SCHED_DEVICES] = {SOAK_SCHED_LENGTH, 120};
+    HM1X_QwiicScheduler scheduler;
+    HM1X_BT serial;
+    uint8_t data[SOAK_SCHED_LENGTH];
+    uint8_t budget[SOAK_SCHED_DEVICES];
+    uint32_t total[SOAK_SCHED_DEVICES] = {0, 0};
+    uint32_t rounds = 0;
+    uint32_t commands;
+    uint8_t found[4];
+    unsigned long start;
+
+    // Scanning never writes a command. A bridge moved off the jumper
+    // addresses is only found by its firmware's version block; older
+    // firmware is found by address alone.
+    commands = wires[0]->commands() + wires[1]->commands();
+    CHECK((bt[0].scanI2c(*wires[0], found, 4) == 1) && (found[0] == QWIIC_BLUETOOTH_DEFAULT_ADDRESS));
+    CHECK((bt[1].scanI2c(*wires[1], found, 4) == 1) && (found[0] == QWIIC_BLUETOOTH_DEFAULT_ADDRESS));
+    CHECK(wires[0]->commands() + wires[1]->commands() == commands);
+    CHECK(bt[0].changeI2cAddress(0x30) == HM1X_SUCCESS);
+    CHECK((bt[0].scanI2c(*wires[0], found, 4) == 1) && (found[0] == 0x30));
+    CHECK(bt[0].changeI2cAddress(0x80) != HM1X_SUCCESS);
+
+    // Only Qwiic modules that aren't polling can be scheduled
+    CHECK(polled.setupPoll());
+    CHECK(scheduler.add(polled) == -1);
+    CHECK(scheduler.add(serial) == -1);
+
+    memset(schedLength, 0, sizeof(schedLength));
+    schedBad = 0;
+    for (int d = 0; d < SOAK_SCHED_DEVICES; d++)
+    {
+        CHECK(bt[d].notify(true, true) == HM1X_SUCCESS);
+        modules[d].connect(true, SOAK_PEER_ADDRESS);
+        CHECK(waitConnected(bt[d], true));
+        CHECK(scheduler.add(bt[d], 1) == d);
+        budget[d] = bt[d].qwiicBridge().refillTransactions();
+    }
+    CHECK((budget[0] == 1) && (budget[1] == 2));
+    bt[1].setI2cPollInterval(0);
+    scheduler.onData(schedData);
+    scheduler.clearBusTime();
+
+    for (int d = 0; d < SOAK_SCHED_DEVICES; d++)
+    {
+        for (size_t i = 0; i < lengths[d]; i++)
+        {
+            data[i] = schedByte(d, i);
+        }
+        modules[d].peerSend(data, lengths[d]);
+    }
+    HM1X_Clock::wait(100); // Less than the bridge holds
+
+    start = HM1X_Clock::now();
+    while (((schedLength[0] < lengths[0]) || (schedLength[1] < lengths[1])) &&
+           (HM1X_Clock::elapsed(start) < SOAK_SCHED_TIMEOUT))
+    {
+        uint32_t before[SOAK_SCHED_DEVICES];
+
+        for (int d = 0; d < SOAK_SCHED_DEVICES; d++)
+        {
+            before[d] = bt[d].i2cTransactions();
+        }
+        scheduler.service();
+        for (int d = 0; d < SOAK_SCHED_DEVICES; d++)
+        {
+            uint32_t used = bt[d].i2cTransactions() - before[d];
+
+            CHECK(used <= budget[d]);
+            total[d] += used;
+        }
+        rounds++;
+        HM1X_Clock::wait(2);
+    }
+
+    CHECK(schedBad == 0);
+    for (int d = 0; d < SOAK_SCHED_DEVICES; d++)
+    {
+        CHECK(schedLength[d] == lengths[d]);
+        for (size_t i = 0; i < schedLength[d]; i++)
+        {
+            if (schedReceived[d][i] != schedByte(d, i))
+            {
+                CHECK(schedReceived[d][i] == schedByte(d, i));
+                break;
+            }
+        }
+        CHECK(scheduler.busTransactions(d) == total[d]);
+        CHECK(scheduler.busTime(d) > 0);
+        modules[d].disconnect(true);
+    }
+    printf("  %lu rounds, %lu/%lu transactions, %lu/%lu us on the bus\n", (unsigned long) rounds,
+           (unsigned long) total[0], (unsigned long) total[1],
+           (unsigned long) scheduler.busTime(0), (unsigned long) scheduler.busTime(1));
+}
+
+// A bus recovery restarts Wire, which drops it back to 100 kHz. The clock
+// setI2cClock() settled on has to come back with it.
+static void recovery(HM1X_BT & bt, TwoWire & wire)
+{
+    char name[HM1X_NAME_LENGTH + 1];
+
+    CHECK(bt.setI2cClock(HM1X_I2C_CLOCK_FAST) == HM1X_SUCCESS);
+    CHECK(wire.clock() == HM1X_I2C_CLOCK_FAST);
+
+    // The host has no GPIO -- SDA always reads low, so every fault recovers
+    bt.setI2cRecoveryPins(0, 1);
+    wire.setNackRate(0.5);
+    for (int i = 0; (i < 20) && (bt.i2cBusRecoveries() == 0); i++)
+    {
+        bt.getEdrName(name);
+    }
+    wire.setNackRate(0);
+    bt.setI2cRecoveryPins(-1, -1);
+
+    CHECK(bt.i2cBusRecoveries() > 0);
+    CHECK(bt.i2cClock() == HM1X_I2C_CLOCK_FAST);
+    CHECK(wire.clock() == HM1X_I2C_CLOCK_FAST);
+    settle(bt);
+    CHECK(edrNameIs(bt, "Again"));
+    printf("  %lu bus recoveries, clock %lu Hz after\n",
+           (unsigned long) bt.i2cBusRecoveries(), (unsigned long) wire.clock());
+}
+
+// One public call. Returns false if it didn't work.
+typedef boolean (*soak_call_t)(HM1X_BT & bt, HM1X_Simulator & module);
+
+typedef struct {
+    const char * name;
+    boolean connected; // Run with a peer connected
+    soak_call_t call;
+} soak_api_t;
+
+static char soakText[40];
+static uint8_t soakValue;
+static uint16_t soakVersion;
+
+static const soak_api_t soakApis[] = {
+    { "setEdrName", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.setEdrName("Leak") == HM1X_SUCCESS; } },
+    { "getEdrName", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.getEdrName(soakText) == HM1X_SUCCESS; } },
+    { "setBleName", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.setBleName("LeakBle") == HM1X_SUCCESS; } },
+    { "getBleName", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.getBleName(soakText) == HM1X_SUCCESS; } },
+    { "edrAddress", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.edrAddress(soakText) == HM1X_SUCCESS; } },
+    { "bleAddress", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.bleAddress(soakText) == HM1X_SUCCESS; } },
+    { "lastEdrAddress", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.lastEdrAddress(soakText) == HM1X_SUCCESS; } },
+    { "lastBleAddress", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.lastBleAddress(soakText) == HM1X_SUCCESS; } },
+#ifndef HM1X_NO_HEAP
+    { "String setEdrName", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.setEdrName(String("Leak")) == HM1X_SUCCESS; } },
+    { "String getEdrName", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.getEdrName() == "Leak"; } },
+    { "String setBleName", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.setBleName(String("LeakBle")) == HM1X_SUCCESS; } },
+    { "String getBleName", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.getBleName() == "LeakBle"; } },
+    { "String edrAddress", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.edrAddress().length() > 0; } },
+    { "String bleAddress", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.bleAddress().length() > 0; } },
+    { "String getiBeaconUUID", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.getiBeaconUUID().length() == HM1X_UUID_LENGTH; } },
+#endif
+    { "version", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.version(soakText) == HM1X_SUCCESS; } },
+    { "notify", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.notify(true, true) == HM1X_SUCCESS; } },
+    { "clearEdrBond", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.clearEdrBond() == HM1X_SUCCESS; } },
+    { "clearBleConnected", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.clearBleConnected() == HM1X_SUCCESS; } },
+    { "setEdrMode", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.setEdrMode(HM1X_BT::EDR_SLAVE) == HM1X_SUCCESS; } },
+    { "getBleMode", false, [](HM1X_BT & bt, HM1X_Simulator &) {
+        HM1X_BT::HM1X_ble_mode_t mode;
+        return bt.getBleMode(&mode) == HM1X_SUCCESS; } },
+    { "enableDualMode", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.enableDualMode(false) == HM1X_SUCCESS; } },
+    { "enableAuthenticationMode", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.enableAuthenticationMode(true) == HM1X_SUCCESS; } },
+    { "setEdrPin", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.setEdrPin((char *) "1234") == HM1X_SUCCESS; } },
+    { "getBlePin", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.getBlePin(soakText) == HM1X_SUCCESS; } },
+    { "setCod", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.setCod(0x001F00) == HM1X_SUCCESS; } },
+    { "enableiBeacon", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.enableiBeacon(false) == HM1X_SUCCESS; } },
+    { "getiBeaconUUID", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.getiBeaconUUID(soakText) == HM1X_SUCCESS; } },
+    { "setiBeaconUUID", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.setiBeaconUUID((char *) "74278BDA", 0) == HM1X_SUCCESS; } },
+    { "setiBeaconMajor", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.setiBeaconMajor(0x1234) == HM1X_SUCCESS; } },
+    { "getiBeaconMinor", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.getiBeaconMinor(&soakVersion) == HM1X_SUCCESS; } },
+    { "getiBeaconPower", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.getiBeaconPower(&soakValue) == HM1X_SUCCESS; } },
+    { "setMtuSize", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.setMtuSize(HM1X_BT::MTU_SIZE_60) == HM1X_SUCCESS; } },
+    { "getEdrAdvertType", false, [](HM1X_BT & bt, HM1X_Simulator &) {
+        HM1X_BT::HM1X_edr_advert_t type;
+        return bt.getEdrAdvertType(&type) == HM1X_SUCCESS; } },
+    { "enableSafeMode", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.enableSafeMode(false) == HM1X_SUCCESS; } },
+    { "setLedMode", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.setLedMode(HM1X_BT::BLINK_DISCONNECTED) == HM1X_SUCCESS; } },
+    { "writePio", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.writePio(2, 1) == HM1X_SUCCESS; } },
+    { "readPio", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.readPio(2, &soakValue) == HM1X_SUCCESS; } },
+    { "enableFlowControl", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.enableFlowControl(false) == HM1X_SUCCESS; } },
+    { "setStopBits", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.setStopBits(HM1X_BT::HM1X_STOP_BITS_1) == HM1X_SUCCESS; } },
+    { "setParity", false, [](HM1X_BT & bt, HM1X_Simulator &) { return bt.setParity(HM1X_BT::HM1X_PARITY_NONE) == HM1X_SUCCESS; } },
+    { "write", true, [](HM1X_BT & bt, HM1X_Simulator & module) {
+        bt.write("leak");
+        HM1X_Clock::wait(20);
+        return module.peerReceived() == "leak"; } },
+    { "poll/read", true, [](HM1X_BT & bt, HM1X_Simulator & module) {
+        size_t count;
+        module.peerSend("leak");
+        HM1X_Clock::wait(20);
+        bt.poll();
+        count = bt.readBytes(soakText, sizeof(soakText) - 1);
+        soakText[count] = 0;
+        return strcmp(soakText, "leak") == 0; } },
+    { "connect/disconnect", false, [](HM1X_BT & bt, HM1X_Simulator & module) {
+        boolean passed;
+        module.connect(true, SOAK_PEER_ADDRESS);
+        passed = waitConnected(bt, true);
+        bt.connectedBleAddress(soakText);
+        module.disconnect(true);
+        return passed && waitConnected(bt, false) && (strcmp(soakText, SOAK_PEER_ADDRESS) == 0); } },
+    { "reset", false, [](HM1X_BT & bt, HM1X_Simulator &) {
+        boolean passed = (bt.reset() == HM1X_SUCCESS);
+        settle(bt);
+        return passed; } }
+};
+
+// Call every API iterations times. After a warm-up call, nothing it does
+// may leave more live heap behind than it found. Built with HM1X_NO_HEAP,
+// the library may not allocate at all -- only the simulator does.
+static void leaks(HM1X_BT & bt, HM1X_Simulator & module, int iterations)
+{
+    HM1X_AllocTrack::snapshot_t before;
+    HM1X_AllocTrack::snapshot_t after;
+
+    // The stream calls need polling
+    CHECK(bt.notify(true, true) == HM1X_SUCCESS);
+    CHECK(bt.setupPoll());
+
+    printf("  %-26s %8s %8s %8s %8s %8s %8s\n", "", "failed", "allocs", "library", "blocks", "bytes", "peak");
+    for (size_t i = 0; i < sizeof(soakApis) / sizeof(soakApis[0]); i++)
+    {
+        int failed = 0;
+        const soak_api_t * api = &soakApis[i];
+
+        if (api->connected != module.connected(true))
+        {
+            if (api->connected)
+            {
+                module.connect(true, SOAK_PEER_ADDRESS);
+            }
+            else
+            {
+                module.disconnect(true);
+            }
+            CHECK(waitConnected(bt, api->connected));
+        }
+        api->call(bt, module);
+        HM1X_AllocTrack::resetPeak();
+        HM1X_AllocTrack::snapshot(&before);
+        for (int n = 0; n < iterations; n++)
+        {
+            if (!api->call(bt, module))
+            {
+                failed++;
+            }
+        }
+        HM1X_AllocTrack::snapshot(&after);
+
+        // allocs: per call, library and simulator together. library: the
+        // library's own, over the run. blocks, bytes: live growth over the
+        // run. peak: above the starting level.
+        printf("  %-26s %8d %8.1f %8lu %8ld %8ld %8ld%s\n", api->name, failed,
+               (double) (after.allocations - before.allocations) / iterations,
+               (unsigned long) ((after.allocations - after.ignored) - (before.allocations - before.ignored)),
+               after.liveCount - before.liveCount, after.liveBytes - before.liveBytes,
+               after.peakBytes - before.liveBytes,
+               ((after.liveCount > before.liveCount) || (after.liveBytes > before.liveBytes)) ? "  LEAK" : "");
+        CHECK(failed == 0);
+        CHECK(after.liveCount <= before.liveCount);
+        CHECK(after.liveBytes <= before.liveBytes);
+#ifdef HM1X_NO_HEAP
+        CHECK(after.allocations - after.ignored == before.allocations - before.ignored);
+#endif
+    }
+    printf("  heap free %lu bytes\n", (unsigned long) after.heapFree);
+}
+
+// A query per thread, each with its own answer
+static const char * const soakQueries[SOAK_THREADS][2] = {
+    { "ADDE?", "OK+Get:001122334455" },
+    { "ADDB?", "OK+Get:001122334456" },
+    { "VERR?", "OK+Get:V112" }
+};
+
+// SOAK_THREADS threads send commands while as many write, then, with a peer
+// connected, the writers stream numbered records. Every command must get
+// its own answer -- not another thread's, and not one spoiled by data
+// running into it -- and every record must reach the peer whole and in
+// order. The receive thread and this one take turns on the simulator.
+static void threaded(HM1X_BT & bt, HM1X_Simulator & module, int iterations)
+{
+    HM1X_Threaded th(bt);
+    HM1X_Threaded::HM1X_link_event_t event;
+    std::mutex simLock;
+    std::atomic<bool> running(true);
+    std::atomic<int> badAnswers(0);
+    std::vector<std::thread> threads;
+    std::string received;
+    int next[SOAK_THREADS] = { 0 };
+    int records = 0;
+    int broken = 0;
+    char address[HM1X_ADDRESS_LENGTH + 1];
+    char reply[8];
+    unsigned long timeIn;
+
+    CHECK(th.begin() == HM1X_SUCCESS);
+    std::thread receiver([&] {
+        while (running)
+        {
+            {
+                std::lock_guard<std::mutex> guard(simLock);
+                th.service();
+            }
+            HM1X_Clock::wait(1);
+            std::this_thread::yield();
+        }
+    });
+
+    // Commands and data together, no peer -- the module ignores the data
+    for (int k = 0; k < SOAK_THREADS; k++)
+    {
+        threads.push_back(std::thread([&, k] {
+            char response[32];
+
+            for (int n = 0; n < iterations; n++)
+            {
+                if ((th.command(soakQueries[k][0], response, sizeof(response), SOAK_THREAD_TIMEOUT) != HM1X_SUCCESS) ||
+                    (strcmp(response, soakQueries[k][1]) != 0))
+                {
+                    badAnswers++;
+                }
+            }
+        }));
+        threads.push_back(std::thread([&, k] {
+            char record[16];
+
+            for (int n = 0; n < iterations; n++)
+            {
+                sprintf(record, "x%d:%d;", k, n);
+                while (!th.writeAtomic((const uint8_t *) record, strlen(record)))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }));
+    }
+    for (size_t i = 0; i < threads.size(); i++)
+    {
+        threads[i].join();
+    }
+    threads.clear();
+    printf("  %d/%d commands answered\n", SOAK_THREADS * iterations - badAnswers, SOAK_THREADS * iterations);
+    CHECK(badAnswers == 0);
+
+    // Stream records to a peer while the state is read
+    {
+        std::lock_guard<std::mutex> guard(simLock);
+        module.connect(true, SOAK_PEER_ADDRESS);
+    }
+    CHECK(th.waitEvent(event, SOAK_THREAD_TIMEOUT) && (event.type == HM1X_Core::HM1X_NOTIFY_CONNECT_BLE));
+    th.connectedBleAddress(address);
+    CHECK(th.connectedBle() && (strcmp(address, SOAK_PEER_ADDRESS) == 0));
+    {
+        std::lock_guard<std::mutex> guard(simLock);
+        module.peerReceived(); // Drop anything from before
+    }
+    for (int k = 0; k < SOAK_THREADS; k++)
+    {
+        threads.push_back(std::thread([&, k] {
+            char record[16];
+
+            for (int n = 0; n < iterations; n++)
+            {
+                sprintf(record, "%d:%d;", k, n);
+                while (!th.writeAtomic((const uint8_t *) record, strlen(record)))
+                {
+                    std::this_thread::yield();
+                }
+                th.connectedBleAddress(address);
+            }
+        }));
+    }
+    for (size_t i = 0; i < threads.size(); i++)
+    {
+        threads[i].join();
+    }
+    timeIn = millis();
+    while ((records + broken < SOAK_THREADS * iterations) && (millis() - timeIn < SOAK_THREAD_TIMEOUT))
+    {
+        size_t end;
+
+        {
+            std::lock_guard<std::mutex> guard(simLock);
+            received += module.peerReceived();
+        }
+        while ((end = received.find(';')) != std::string::npos)
+        {
+            int k;
+            int n;
+
+            if ((sscanf(received.c_str(), "%d:%d", &k, &n) == 2) && (k >= 0) && (k < SOAK_THREADS) && (n == next[k]))
+            {
+                next[k]++;
+                records++;
+            }
+            else
+            {
+                broken++;
+            }
+            received.erase(0, end + 1);
+        }
+        std::this_thread::yield();
+    }
+    printf("  %d/%d records whole and in order\n", records, SOAK_THREADS * iterations);
+    CHECK(records == SOAK_THREADS * iterations);
+
+    // Peer to a reader sleeping in waitAvailable()
+    {
+        std::lock_guard<std::mutex> guard(simLock);
+        module.peerSend("pong");
+    }
+    memset(reply, 0, sizeof(reply));
+    for (size_t got = 0; (got < 4) && th.waitAvailable(SOAK_THREAD_TIMEOUT); )
+    {
+        got += th.read((uint8_t *) reply + got, 4 - got);
+    }
+    CHECK(strcmp(reply, "pong") == 0);
+
+    {
+        std::lock_guard<std::mutex> guard(simLock);
+        module.disconnect(true);
+    }
+    CHECK(th.waitEvent(event, SOAK_THREAD_TIMEOUT) && (event.type == HM1X_Core::HM1X_NOTIFY_DISCONNECT_BLE));
+    th.connectedBleAddress(address);
+    CHECK(!th.connectedBle() && (address[0] == 0));
+    CHECK(th.overflows() == 0);
+
+    running = false;
+    receiver.join();
+}
+
+static uint8_t frameSeen[HM1X_FRAME_MAX_PAYLOAD];
+static int frameSeenLength;
+static int framesSeen;
+
+static void frameFound(const uint8_t * payload, uint8_t length, void * context)
+{
+    (void) context;
+    memcpy(frameSeen, payload, length);
+    frameSeenLength = length;
+    framesSeen++;
+}
+
+// Feed what the peer received back through a parser, as the peer would
+static void frameParse(HM1X_Framer & framer, const std::string & wire)
+{
+    framesSeen = 0;
+    for (size_t i = 0; i < wire.size(); i++)
+    {
+        framer.process((uint8_t) wire[i]);
+    }
+}
+
+static boolean frameIs(const uint8_t * payload, int length)
+{
+    return (framesSeen == 1) && (frameSeenLength == length) && (memcmp(frameSeen, payload, length) == 0);
+}
+
+static void framing(HM1X_BT & bt, HM1X_Simulator & module)
+{
+    static const uint8_t mtus[] = {23, 60, 120, 255};
+    uint8_t rx[HM1X_FRAME_MAX_PAYLOAD];
+    uint8_t payload[HM1X_FRAME_MAX_PAYLOAD];
+    HM1X_Framer framer(bt, rx, sizeof(rx));
+    std::string wire;
+    std::string last;
+    uint32_t seed = 1;
+    int frames = 0;
+
+    framer.onFrame(frameFound);
+    CHECK(bt.notify(true, true) == HM1X_SUCCESS);
+    module.connect(true, SOAK_PEER_ADDRESS);
+    CHECK(waitConnected(bt, true));
+
+    for (size_t m = 0; m < sizeof(mtus); m++)
+    {
+        framer.setMtu(mtus[m]);
+        CHECK(HM1X_FRAME_ENCODED_MAX(framer.maxPayload()) <= mtus[m] - 3);
+
+        // Every length, as SOF/escape bytes only (worst-case stuffing),
+        // as a ramp through every value, and as noise
+        for (int pattern = 0; pattern < 3; pattern++)
+        {
+            for (int length = 1; length <= framer.maxPayload(); length++)
+            {
+                for (int i = 0; i < length; i++)
+                {
+                    seed = seed * 1103515245 + 12345;
+                    payload[i] = (pattern == 0) ? ((i & 1) ? HM1X_FRAME_ESCAPE : HM1X_FRAME_SOF) :
+                                 (pattern == 1) ? (uint8_t) (i * 37 + length) : (uint8_t) (seed >> 16);
+                }
+                CHECK(framer.send(payload, length) == HM1X_SUCCESS);
+                HM1X_Clock::wait(20);
+                wire = module.peerReceived();
+                CHECK(wire.size() <= (size_t) (mtus[m] - 3));
+                frameParse(framer, wire);
+                CHECK(frameIs(payload, length));
+                frames++;
+            }
+        }
+        CHECK(framer.send(payload, framer.maxPayload() + 1) != HM1X_SUCCESS);
+    }
+    CHECK(framer.crcErrors() == 0);
+    CHECK(framer.framingErrors() == 0);
+
+    memcpy(payload, "hello", 5);
+    CHECK(framer.send(payload, 5) == HM1X_SUCCESS);
+    HM1X_Clock::wait(20);
+    last = module.peerReceived();
+
+    // A flipped payload bit fails the CRC
+    wire = last;
+    wire[3] ^= 0x01;
+    frameParse(framer, wire);
+    CHECK((framesSeen == 0) && (framer.crcErrors() == 1));
+
+    // A frame cut short is dropped at the next start of frame, which
+    // still comes through
+    frameParse(framer, last.substr(0, 4) + last);
+    CHECK(frameIs(payload, 5) && (framer.framingErrors() == 1));
+
+    // Line noise between frames is skipped
+    frameParse(framer, std::string("noise") + last);
+    CHECK(frameIs(payload, 5));
+
+    module.disconnect(true);
+    CHECK(waitConnected(bt, false));
+    printf("  %d frames round-tripped, MTU 60 carries %d bytes a frame\n", frames,
+           (framer.setMtu(60), framer.maxPayload()));
+}
+
+static uint8_t bulkData[SOAK_BULK_LENGTH];
+static uint8_t bulkReceived[SOAK_BULK_LENGTH];
+static uint32_t bulkNextOffset;
+static int bulkBad;
+static unsigned long bulkStallFrom;
+static boolean bulkStalling;
+static unsigned long bulkStalledChecks;
+
+static size_t bulkSource(uint8_t * dest, size_t maxLength, uint32_t offset, void * context)
+{
+    size_t length = SOAK_BULK_LENGTH - offset;
+
+    (void) context;
+    if (length > maxLength)
+    {
+        length = maxLength;
+    }
+    memcpy(dest, bulkData + offset, length);
+    return length;
+}
+
+static void bulkSink(const uint8_t * data, uint8_t length, uint32_t offset, void * context)
+{
+    (void) context;
+    if ((offset != bulkNextOffset) || (offset + length > SOAK_BULK_LENGTH))
+    {
+        bulkBad++;
+        return;
+    }
+    memcpy(bulkReceived + offset, data, length);
+    bulkNextOffset += length;
+}
+
+// The sender's CTS: held off for SOAK_BULK_STALL ms once the stall starts,
+// long enough for a write to give up part way through a frame
+static boolean bulkClearToSend(void * context)
+{
+    (void) context;
+    if (bulkStalling && (HM1X_Clock::elapsed(bulkStallFrom) < SOAK_BULK_STALL))
+    {
+        bulkStalledChecks++;
+        return false;
+    }
+    return true;
+}
+
+// Carry what each host wrote to the other module, corrupting a byte of
+// every SOAK_BULK_CORRUPT-th burst
+static void bulkLink(HM1X_Simulator & from, HM1X_Simulator & to, uint32_t & bursts)
+{
+    std::string data = from.peerReceived();
+
+    if (data.empty())
+    {
+        return;
+    }
+    if ((++bursts % SOAK_BULK_CORRUPT) == 0)
+    {
+        data[data.size() / 2] ^= 0x40;
+    }
+    to.peerSend((const uint8_t *) data.data(), data.size());
+}
+
+static void bulk(HM1X_BT & sendBt, HM1X_Simulator & sendModule,
+                 HM1X_BT & receiveBt, HM1X_Simulator & receiveModule)
+{
+    uint8_t sendRx[HM1X_FRAME_MAX_PAYLOAD];
+    uint8_t receiveRx[HM1X_FRAME_MAX_PAYLOAD];
+    HM1X_Framer sendFramer(sendBt, sendRx, sizeof(sendRx));
+    HM1X_Framer receiveFramer(receiveBt, receiveRx, sizeof(receiveRx));
+    HM1X_BulkTransfer sender(sendFramer);
+    HM1X_BulkTransfer receiver(receiveFramer);
+    uint32_t forward = 0;
+    uint32_t back = 0;
+    unsigned long start;
+
+    for (uint32_t i = 0; i < SOAK_BULK_LENGTH; i++)
+    {
+        bulkData[i] = (uint8_t) ((i * 131) ^ (i >> 8));
+    }
+    memset(bulkReceived, 0, sizeof(bulkReceived));
+    bulkNextOffset = 0;
+    bulkBad = 0;
+    bulkStalling = false;
+    bulkStalledChecks = 0;
+
+    CHECK(sendBt.notify(true, true) == HM1X_SUCCESS);
+    CHECK(receiveBt.notify(true, true) == HM1X_SUCCESS);
+    sendModule.connect(true, SOAK_PEER_ADDRESS);
+    receiveModule.connect(true, SOAK_PEER_ADDRESS);
+    CHECK(waitConnected(sendBt, true));
+    CHECK(waitConnected(receiveBt, true));
+
+    sendBt.setFlowControlCallback(bulkClearToSend);
+    sendFramer.setMtu(60);
+    receiveFramer.setMtu(60);
+    sender.setWindow(4);
+    sender.setRetransmitTimeout(1500);
+    CHECK(receiver.beginReceive(bulkSink) == HM1X_SUCCESS);
+    CHECK(sender.beginSend(SOAK_BULK_LENGTH, bulkSource) == HM1X_SUCCESS);
+
+    start = HM1X_Clock::now();
+    while (!(sender.done() && receiver.done()) &&
+           (HM1X_Clock::elapsed(start) < SOAK_BULK_TIMEOUT))
+    {
+        // Halfway through, stall the sender mid-frame
+        if (!bulkStalling && (bulkNextOffset >= SOAK_BULK_LENGTH / 2))
+        {
+            bulkStalling = true;
+            bulkStallFrom = HM1X_Clock::now();
+        }
+        sender.service();
+        bulkLink(sendModule, receiveModule, forward);
+        receiver.service();
+        bulkLink(receiveModule, sendModule, back);
+        HM1X_Clock::wait(1);
+    }
+
+    CHECK(sender.state() == HM1X_BulkTransfer::BULK_COMPLETE);
+    CHECK(receiver.state() == HM1X_BulkTransfer::BULK_COMPLETE);
+    CHECK((bulkBad == 0) && (bulkNextOffset == SOAK_BULK_LENGTH));
+    CHECK(memcmp(bulkData, bulkReceived, SOAK_BULK_LENGTH) == 0);
+    CHECK(sender.retransmissions() > 0);
+    CHECK(bulkStalledChecks > 0);
+    CHECK(receiveFramer.crcErrors() + receiveFramer.framingErrors() > 0);
+
+    sendBt.setFlowControlCallback(NULL);
+    sendModule.disconnect(true);
+    receiveModule.disconnect(true);
+    CHECK(waitConnected(sendBt, false));
+    CHECK(waitConnected(receiveBt, false));
+    printf("  %lu bytes in %lu ms, %u retransmissions, %lu bad frames\n",
+           (unsigned long) bulkNextOffset, HM1X_Clock::elapsed(start),
+           (unsigned) sender.retransmissions(),
+           (unsigned long) (receiveFramer.crcErrors() + receiveFramer.framingErrors()));
+}
+
+static uint16_t scanSeen[SOAK_ADVERTISERS];
+static int scanBad;
+
+static void scanFound(const HM1X_BleScanner::HM1X_ble_device_t * device, void * context)
+{
+    char name[HM1X_NAME_LENGTH + 1];
+    unsigned long i = strtoul(device->addressText + 6, NULL, 16);
+
+    (void) context;
+    if ((strncmp(device->addressText, "C0FFEE", 6) != 0) || (i >= SOAK_ADVERTISERS))
+    {
+        scanBad++;
+        return;
+    }
+    scanSeen[i]++;
+    sprintf(name, "Ox%lu", i);
+    if (i % 3 == 0)
+    {
+        name[0] = '\0';
+    }
+    if ((device->address[0] != 0xC0) || (device->address[5] != (uint8_t) i) ||
+        (device->rssi != -(int) (30 + i % 60)) || (strcmp(device->name, name) != 0))
+    {
+        scanBad++;
+    }
+}
+
+static boolean scanSeenOnce(void)
+{
+    for (int i = 0; i < SOAK_ADVERTISERS; i++)
+    {
+        if (scanSeen[i] != 1)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void scan(HM1X_BT & bt, HM1X_Simulator & module)
+{
+    HM1X_BleScanner scanner(bt);
+    char address[HM1X_ADDRESS_LENGTH + 1];
+    char name[HM1X_NAME_LENGTH + 1];
+    unsigned long start;
+
+    // Every third device doesn't send its name; the rest have an 'O' in it
+    for (int i = 0; i < SOAK_ADVERTISERS; i++)
+    {
+        sprintf(address, "C0FFEE%06X", i);
+        sprintf(name, "Ox%d", i);
+        if (i % 3 == 0)
+        {
+            name[0] = '\0';
+        }
+        module.addAdvertiser(address, -(30 + i % 60), name);
+    }
+    CHECK(bt.setBleMode(HM1X_Core::BLE_CENTRAL) == HM1X_SUCCESS);
+    scanner.onDevice(scanFound);
+
+    // Continuous: each device once, however many rounds hear it
+    memset(scanSeen, 0, sizeof(scanSeen));
+    scanBad = 0;
+    CHECK(scanner.start() == HM1X_SUCCESS);
+    start = HM1X_Clock::now();
+    while ((scanner.rounds() < SOAK_SCAN_ROUNDS) && (HM1X_Clock::elapsed(start) < 60000))
+    {
+        scanner.poll();
+        HM1X_Clock::wait(1);
+    }
+    CHECK(scanner.stop() == HM1X_SUCCESS);
+    CHECK(scanner.rounds() >= SOAK_SCAN_ROUNDS);
+    CHECK(scanBad == 0);
+    CHECK(scanSeenOnce());
+    CHECK(scanner.devicesReported() == SOAK_ADVERTISERS);
+    CHECK(scanner.duplicates() >= (SOAK_SCAN_ROUNDS - 1) * SOAK_ADVERTISERS);
+    printf("  %d devices, %lu reported over %lu rounds in %lu ms, %lu duplicates held back\n",
+           SOAK_ADVERTISERS, (unsigned long) scanner.devicesReported(), (unsigned long) scanner.rounds(),
+           HM1X_Clock::elapsed(start), (unsigned long) scanner.duplicates());
+
+    // Stopped: whatever the round had left never arrives
+    HM1X_Clock::wait(100);
+    CHECK(scanner.poll() == 0);
+
+    // One round with the cache cleared hears everything again
+    memset(scanSeen, 0, sizeof(scanSeen));
+    scanner.clearCache();
+    scanner.clearCounters();
+    CHECK(scanner.start(false) == HM1X_SUCCESS);
+    start = HM1X_Clock::now();
+    while (scanner.scanning() && (HM1X_Clock::elapsed(start) < 30000))
+    {
+        scanner.poll();
+        HM1X_Clock::wait(1);
+    }
+    HM1X_Clock::wait(HM1X_SCAN_GAP);
+    scanner.poll();
+    CHECK(!scanner.scanning() && (scanner.rounds() == 1));
+    CHECK(scanBad == 0);
+    CHECK(scanSeenOnce());
+
+    // Stopping part way through a round
+    scanner.clearCache();
+    scanner.clearCounters();
+    CHECK(scanner.start(false) == HM1X_SUCCESS);
+    HM1X_Clock::wait(500);
+    scanner.poll();
+    CHECK(scanner.stop() == HM1X_SUCCESS);
+    HM1X_Clock::wait(100);
+    scanner.poll();
+    CHECK((scanner.devicesReported() > 0) && (scanner.devicesReported() < SOAK_ADVERTISERS));
+    CHECK(scanner.rounds() == 0);
+    CHECK(bt.test() == HM1X_SUCCESS);
+}
+
+int main(int argc, char ** argv)
+{
+    int iterations = (argc > 1) ? atoi(argv[1]) : 200;
+    uint32_t seed = (argc > 2) ? strtoul(argv[2], NULL, 0) : 1;
+    boolean realTime = (argc > 3) && (strcmp(argv[3], "realtime") == 0);
+    unsigned long timeIn;
+
+    if (!realTime)
+    {
+        HM1X_Simulator::useVirtualTime();
+    }
+    printf("%s time\n", realTime ? "Real" : "Virtual");
+
+    {
+        HM1X_Simulator module;
+        HM1X_BT bt;
+
+        printf("Serial\n");
+        module.setSeed(seed);
+        module.setBootTime(SOAK_BOOT_TIME);
+        CHECK(bt.begin(module, 9600, HM1X_Simulator::onBaud, &module));
+        timeIn = HM1X_Clock::now();
+        functional(bt, module);
+        printf("  functional pass %lu ms\n", HM1X_Clock::elapsed(timeIn));
+        faults(bt, module, iterations);
+        timeIn = HM1X_Clock::now();
+        leaks(bt, module, iterations);
+        printf("  leak pass %lu ms\n", HM1X_Clock::elapsed(timeIn));
+    }
+
+    {
+        HM1X_Simulator module;
+        HM1X_BT_T<HM1X_StreamTransport> bt;
+
+        printf("Serial, HM1X_BT_T<HM1X_StreamTransport>\n");
+        module.setSeed(seed);
+        module.setBootTime(SOAK_BOOT_TIME);
+        CHECK(bt.begin(module, 9600, HM1X_Simulator::onBaud, &module));
+        timeIn = HM1X_Clock::now();
+        functional(bt, module);
+        printf("  functional pass %lu ms\n", HM1X_Clock::elapsed(timeIn));
+    }
+
+    {
+        HM1X_Simulator module;
+        HM1X_BT bt;
+
+        printf("Serial, threaded\n");
+        module.setSeed(seed);
+        module.setBootTime(SOAK_BOOT_TIME);
+        CHECK(bt.begin(module, 9600, HM1X_Simulator::onBaud, &module));
+        timeIn = HM1X_Clock::now();
+        threaded(bt, module, iterations);
+        printf("  threaded pass %lu ms\n", HM1X_Clock::elapsed(timeIn));
+    }
+
+    {
+        HM1X_Simulator module;
+        HM1X_BT bt;
+
+        printf("Serial, framing\n");
+        module.setSeed(seed);
+        module.setBootTime(SOAK_BOOT_TIME);
+        CHECK(bt.begin(module, 9600, HM1X_Simulator::onBaud, &module));
+        timeIn = HM1X_Clock::now();
+        framing(bt, module);
+        printf("  framing pass %lu ms\n", HM1X_Clock::elapsed(timeIn));
+    }
+
+    {
+        HM1X_Simulator sendModule;
+        HM1X_Simulator receiveModule;
+        HM1X_BT sendBt;
+        HM1X_BT receiveBt;
+
+        printf("Serial, bulk transfer\n");
+        sendModule.setSeed(seed);
+        receiveModule.setSeed(seed + 1);
+        sendModule.setBootTime(SOAK_BOOT_TIME);
+        receiveModule.setBootTime(SOAK_BOOT_TIME);
+        CHECK(sendBt.begin(sendModule, 9600, HM1X_Simulator::onBaud, &sendModule));
+        CHECK(receiveBt.begin(receiveModule, 9600, HM1X_Simulator::onBaud, &receiveModule));
+        timeIn = HM1X_Clock::now();
+        bulk(sendBt, sendModule, receiveBt, receiveModule);
+        printf("  bulk pass %lu ms\n", HM1X_Clock::elapsed(timeIn));
+    }
+
+    {
+        HM1X_Simulator module;
+        HM1X_BT bt;
+
+        printf("Serial, scanning\n");
+        module.setSeed(seed);
+        module.setBootTime(SOAK_BOOT_TIME);
+        CHECK(bt.begin(module, 9600, HM1X_Simulator::onBaud, &module));
+        timeIn = HM1X_Clock::now();
+        scan(bt, module);
+        printf("  scan pass %lu ms\n", HM1X_Clock::elapsed(timeIn));
+    }
+
+    {
+        HM1X_Simulator module;
+        TwoWire wire(module);
+        HM1X_BT bt;
+
+        printf("Qwiic\n");
+        module.setSeed(seed);
+        module.setBootTime(SOAK_BOOT_TIME);
+        CHECK(bt.begin(wire, QWIIC_BLUETOOTH_DEFAULT_ADDRESS));
+        timeIn = HM1X_Clock::now();
+        functional(bt, module);
+        printf("  functional pass %lu ms, %lu transactions\n",
+               HM1X_Clock::elapsed(timeIn), (unsigned long) wire.transactions());
+        wire.setNackRate(0.01);
+        faults(bt, module, iterations);
+        printf("  %lu NACKs injected\n", (unsigned long) wire.nacks());
+        recovery(bt, wire);
+    }
+
+    {
+        HM1X_Simulator module;
+        TwoWire wire(module);
+        HM1X_BT_T<HM1X_WireTransport> bt;
+
+        printf("Qwiic, HM1X_BT_T<HM1X_WireTransport>\n");
+        module.setSeed(seed);
+        module.setBootTime(SOAK_BOOT_TIME);
+        CHECK(bt.begin(wire, QWIIC_BLUETOOTH_DEFAULT_ADDRESS));
+        timeIn = HM1X_Clock::now();
+        functional(bt, module);
+        printf("  functional pass %lu ms, %lu transactions\n",
+               HM1X_Clock::elapsed(timeIn), (unsigned long) wire.transactions());
+    }
+
+    {
+        HM1X_Simulator module;
+        TwoWire wire(module);
+        HM1X_BT bt;
+
+        printf("Qwiic, original bridge firmware\n");
+        wire.setFirmware(0, 0, 0);
+        module.setBootTime(SOAK_BOOT_TIME);
+        CHECK(bt.begin(wire, QWIIC_BLUETOOTH_DEFAULT_ADDRESS));
+        functional(bt, module);
+    }
+
+    {
+        HM1X_Simulator modules[SOAK_SCHED_DEVICES + 1];
+        TwoWire chatty(modules[0]);
+        TwoWire quiet(modules[1]);
+        TwoWire polling(modules[2]);
+        TwoWire * wires[SOAK_SCHED_DEVICES] = {&chatty, &quiet};
+        HM1X_BT bt[SOAK_SCHED_DEVICES + 1];
+
+        printf("Qwiic, scheduler\n");
+        quiet.setFirmware(0, 0, 0);
+        for (int d = 0; d <= SOAK_SCHED_DEVICES; d++)
+        {
+            modules[d].setSeed(seed + d);
+            modules[d].setBootTime(SOAK_BOOT_TIME);
+        }
+        CHECK(bt[0].begin(chatty, QWIIC_BLUETOOTH_DEFAULT_ADDRESS));
+        CHECK(bt[1].begin(quiet, QWIIC_BLUETOOTH_DEFAULT_ADDRESS));
+        CHECK(bt[2].begin(polling, QWIIC_BLUETOOTH_DEFAULT_ADDRESS));
+        timeIn = HM1X_Clock::now();
+        scheduler(bt, modules, wires, bt[2]);
+        printf("  scheduler pass %lu ms\n", HM1X_Clock::elapsed(timeIn));
+    }
+
+    printf("%s\n", (failures == 0) ? "OK" : "FAILED");
+    return (failures == 0) ? 0 : 1;
+}
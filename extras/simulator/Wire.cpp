@@ -0,0 +1,257 @@
+/*
+  Qwiic Bluetooth bridge simulator for the SparkFun HM1X Bluetooth Arduino
+  Library
+
+  See Wire.h.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Wire.h"
+#include "HM1X_Simulator.h"
+
+// Bridge commands, as in HM1X_QwiicBridge.cpp
+enum {
+    SIM_I2C_AVAILABLE,
+    SIM_I2C_READ,
+    SIM_I2C_WRITE,
+    SIM_I2C_SET_BAUD,
+    SIM_I2C_SET_ADDRESS,
+    SIM_I2C_READ_WITH_AVAILABLE,
+    SIM_I2C_VERSION,
+    SIM_I2C_BUFFER_SIZE
+};
+
+// endTransmission() status
+#define SIM_I2C_NACK_ADDRESS 2
+#define SIM_I2C_NACK_DATA 3
+
+const uint8_t SIM_BRIDGE_MAGIC = 0xB7;
+const uint8_t SIM_BRIDGE_DEFAULT_VERSION = 2;
+const uint8_t SIM_BRIDGE_DEFAULT_BUFFER = 32;
+const size_t SIM_BRIDGE_RX_BUFFER = 128; // Bytes held from the module
+
+// HM1X_baud_t order -- index 0 is HM1X_BAUD_INVALID
+static const unsigned long simBridgeBauds[] = { 0, 4800, 9600, 19200, 38400, 57600, 115200, 230400 };
+
+TwoWire::TwoWire(HM1X_Simulator & module, uint8_t address) :
+    _module(module), _address(address), _clock(100000), _maxClock(1000000), _nackRate(0), _seed(1),
+    _version(SIM_BRIDGE_DEFAULT_VERSION),
+    _capabilities(QWIIC_BT_CAP_READ_WITH_AVAILABLE | QWIIC_BT_CAP_BUFFER_SIZE),
+    _bufferSize(SIM_BRIDGE_DEFAULT_BUFFER), _target(0), _command(-1),
+    _transactions(0), _commands(0), _nacks(0)
+{
+    // The bridge talks to the module at 9600 8N1 until told otherwise
+    _module.setHostFraming(9600);
+}
+
+void TwoWire::setFirmware(uint8_t version, uint8_t capabilities, uint8_t bufferSize)
+{
+    _version = version;
+    _capabilities = (version > 0) ? capabilities : 0;
+    _bufferSize = bufferSize;
+}
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+    _target = address;
+    _request.clear();
+}
+
+size_t TwoWire::write(uint8_t c)
+{
+    if (_request.size() >= BUFFER_LENGTH)
+    {
+        return 0;
+    }
+    _request.push_back(c);
+    return 1;
+}
+
+uint8_t TwoWire::endTransmission(uint8_t sendStop)
+{
+    (void) sendStop;
+    _transactions++;
+    receive();
+
+    if (_target != _address)
+    {
+        return SIM_I2C_NACK_ADDRESS;
+    }
+    if (nack())
+    {
+        return SIM_I2C_NACK_DATA;
+    }
+    if (_request.empty())
+    {
+        return 0; // Address probe
+    }
+    _commands++;
+
+    switch (_request[0])
+    {
+    case SIM_I2C_WRITE:
+        _module.write(&_request[1], _request.size() - 1);
+        break;
+    case SIM_I2C_SET_BAUD:
+        if ((_request.size() > 1) && (_request[1] > 0) &&
+            (_request[1] < sizeof(simBridgeBauds) / sizeof(simBridgeBauds[0])))
+        {
+            _module.setHostFraming(simBridgeBauds[_request[1]]);
+        }
+        break;
+    case SIM_I2C_SET_ADDRESS:
+        if (_request.size() > 1)
+        {
+            _address = _request[1];
+        }
+        break;
+    default:
+        _command = _request[0];
+        break;
+    }
+    return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop)
+{
+    size_t held;
+    boolean extended = (_version > 0);
+    int command = _command;
+
+    (void) sendStop;
+    _transactions++;
+    _reply.clear();
+    receive();
+
+    if ((address != _address) || nack())
+    {
+        return 0;
+    }
+    if (quantity > BUFFER_LENGTH)
+    {
+        quantity = BUFFER_LENGTH;
+    }
+
+    held = _fromModule.size();
+    if (held > 255)
+    {
+        held = 255;
+    }
+    // Newer firmware answers a command once. A read with none pending
+    // gets the version block, so a scan can identify it without writing.
+    if (extended)
+    {
+        _command = -1;
+        if (command < 0)
+        {
+            command = SIM_I2C_VERSION;
+        }
+    }
+
+    switch (command)
+    {
+    case SIM_I2C_AVAILABLE:
+        _reply.push_back((uint8_t) held);
+        break;
+    case SIM_I2C_READ:
+        // Reads past the end come back as 0xFF, like the ATtiny's
+        while ((_reply.size() < quantity) && !_fromModule.empty())
+        {
+            _reply.push_back(_fromModule.front());
+            _fromModule.pop_front();
+        }
+        break;
+    case SIM_I2C_READ_WITH_AVAILABLE:
+        if (!extended || !(_capabilities & QWIIC_BT_CAP_READ_WITH_AVAILABLE))
+        {
+            break;
+        }
+        _reply.push_back((uint8_t) held);
+        while ((_reply.size() < quantity) && !_fromModule.empty())
+        {
+            _reply.push_back(_fromModule.front());
+            _fromModule.pop_front();
+        }
+        break;
+    case SIM_I2C_VERSION:
+        if (extended)
+        {
+            _reply.push_back(SIM_BRIDGE_MAGIC);
+            _reply.push_back(_version);
+            _reply.push_back(_capabilities);
+        }
+        break;
+    case SIM_I2C_BUFFER_SIZE:
+        if (extended && (_capabilities & QWIIC_BT_CAP_BUFFER_SIZE))
+        {
+            _reply.push_back(_bufferSize);
+        }
+        break;
+    default:
+        break;
+    }
+
+    // An I2C slave can't refuse a read -- it clocks out filler
+    while (_reply.size() < quantity)
+    {
+        _reply.push_back(0xFF);
+    }
+    while (_reply.size() > quantity)
+    {
+        _reply.pop_back();
+    }
+    return quantity;
+}
+
+int TwoWire::read(void)
+{
+    int c;
+
+    if (_reply.empty())
+    {
+        return -1;
+    }
+    c = _reply.front();
+    _reply.pop_front();
+    return c;
+}
+
+// Move whatever the module has sent into the bridge's buffer. A full
+// buffer drops bytes, as the ATtiny does.
+void TwoWire::receive(void)
+{
+    while (_module.available() > 0)
+    {
+        int c = _module.read();
+
+        if (_fromModule.size() < SIM_BRIDGE_RX_BUFFER)
+        {
+            _fromModule.push_back((uint8_t) c);
+        }
+    }
+}
+
+// Bus faults: clocked faster than the bridge can follow, or just unlucky
+boolean TwoWire::nack(void)
+{
+    boolean fail = (_clock > _maxClock);
+
+    if (!fail && (_nackRate > 0))
+    {
+        _seed ^= _seed << 13;
+        _seed ^= _seed >> 17;
+        _seed ^= _seed << 5;
+        fail = ((float) (_seed % 10000) < _nackRate * 10000.0);
+    }
+    if (fail)
+    {
+        _nacks++;
+    }
+    return fail;
+}
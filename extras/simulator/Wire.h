@@ -0,0 +1,96 @@
+/*
+  Qwiic Bluetooth bridge simulator for the SparkFun HM1X Bluetooth Arduino
+  Library
+
+  Stands in for Arduino's Wire.h on a Linux host. A TwoWire here is an I2C
+  bus with one Qwiic bridge on it, and the bridge's UART is wired to an
+  HM1X_Simulator:
+
+    HM1X_Simulator module;
+    TwoWire wire(module);
+    HM1X_BT bt;
+    bt.begin(wire);
+
+  Build with -DHM1X_I2C_ENABLED -Iextras/simulator so the library picks
+  this file up in place of the real one.
+
+  The bridge answers the same commands as the ATtiny firmware. Firmware
+  version 0 is the original bridge, which doesn't know VERSION,
+  READ_WITH_AVAILABLE or BUFFER_SIZE. Newer firmware answers each command
+  once, and a read with no command pending with its version block.
+  Faults: NACKs at a given rate, and NACKs above a maximum bus clock.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "HM1X_PosixCompat.h"
+#include <deque>
+#include <vector>
+
+#define BUFFER_LENGTH 32
+
+class HM1X_Simulator;
+
+class TwoWire : public Stream {
+public:
+    TwoWire(HM1X_Simulator & module, uint8_t address = 0x1B);
+
+    void begin(void) { _clock = 100000; }; // As Arduino's: back to 100 kHz
+    void end(void) {};
+    void setClock(uint32_t clock) { _clock = clock; };
+    uint32_t clock(void) { return _clock; };
+
+    void beginTransmission(uint8_t address);
+    uint8_t endTransmission(uint8_t sendStop = true);
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, uint8_t sendStop = true);
+    uint8_t requestFrom(int address, int quantity) { return requestFrom((uint8_t) address, (uint8_t) quantity); };
+
+    int available(void) { return _reply.size(); };
+    int read(void);
+    int peek(void) { return _reply.empty() ? -1 : _reply.front(); };
+    size_t write(uint8_t c);
+    using Print::write;
+
+    // Bridge firmware. Capabilities are QWIIC_BT_CAP_* flags; bufferSize
+    // is what BUFFER_SIZE reports.
+    void setFirmware(uint8_t version, uint8_t capabilities, uint8_t bufferSize);
+    void setMaxClock(uint32_t clock) { _maxClock = clock; };
+    void setNackRate(float rate) { _nackRate = rate; };
+
+    uint8_t address(void) { return _address; };
+    uint32_t transactions(void) { return _transactions; };
+    uint32_t commands(void) { return _commands; };   // Writes to the bridge that carried a command
+    uint32_t nacks(void) { return _nacks; };
+
+private:
+    HM1X_Simulator & _module;
+    uint8_t _address;
+    uint32_t _clock;
+    uint32_t _maxClock;
+    float _nackRate;
+    uint32_t _seed;
+
+    uint8_t _version;
+    uint8_t _capabilities;
+    uint8_t _bufferSize;
+
+    uint8_t _target;
+    std::vector<uint8_t> _request;  // Current write transaction
+    int _command;                   // Last command awaiting a read
+    std::deque<uint8_t> _reply;     // Current read transaction
+    std::deque<uint8_t> _fromModule; // Bridge's receive buffer
+
+    uint32_t _transactions;
+    uint32_t _commands;
+    uint32_t _nacks;
+
+    void receive(void);
+    boolean nack(void);
+};
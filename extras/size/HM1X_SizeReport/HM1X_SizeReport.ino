@@ -0,0 +1,55 @@
+/*
+  HM1X Bluetooth library footprint sketch
+
+  Not for running -- size_report.sh builds it once per feature group to
+  measure what each costs. It calls at least one command from every
+  HM1X_CAP_* group, so a group's code is only left out when the group is
+  compiled out.
+
+  The module is on Serial, through begin(Serial) -- the HardwareSerial
+  overload, or begin(Stream &) when HM1X_NO_HARDWARE_SERIAL drops it.
+*/
+
+#include <SparkFun_HM1X_Bluetooth_Arduino_Library.h>
+
+HM1X_BT bt;
+
+char text[HM1X_NAME_LENGTH + 1];
+uint8_t value;
+uint16_t version;
+
+void setup() {
+  bt.begin(Serial, 9600);
+  bt.setupPoll();
+
+  bt.getEdrName(text);                 // HM1X_CAP_DUAL_MODE | HM1X_CAP_EDR
+  bt.setEdrMode(HM1X_BT::EDR_SLAVE);
+  bt.setCod(0x001F00);
+  bt.getBleName(text);                 // HM1X_CAP_DUAL_MODE | HM1X_CAP_BLE
+  bt.setBleMode(HM1X_BT::BLE_PERIPHERAL);
+  bt.enableUpdateConnectionParameter(true);
+  bt.enableDualMode(true);             // HM1X_CAP_DUAL_MODE
+  bt.setEdrPin((char *) "1234");       // HM1X_CAP_BOND
+  bt.clearBleBond();
+  bt.enableAuthenticationMode(true);
+  bt.enableiBeacon(true);              // HM1X_CAP_IBEACON
+  bt.getiBeaconMajor(&version);
+  bt.setiBeaconPower(0xC5);
+  bt.writePio(2, 1);                   // HM1X_CAP_PIO
+  bt.readPio(3, &value);
+  bt.setLedMode(HM1X_BT::BLINK_DISCONNECTED);
+  bt.setMtuSize(HM1X_BT::MTU_SIZE_120); // HM1X_CAP_MTU
+  bt.setStopBits(HM1X_BT::HM1X_STOP_BITS_1); // HM1X_CAP_FRAMING
+  bt.setParity(HM1X_BT::HM1X_PARITY_NONE);
+  bt.enableFlowControl(false);         // HM1X_CAP_FLOW_CONTROL
+}
+
+void loop() {
+  bt.poll();
+  while (bt.available()) {
+    bt.write(bt.read());
+  }
+  if (bt.connected()) {
+    bt.write("connected");
+  }
+}
@@ -0,0 +1,75 @@
+#!/bin/sh
+#
+# Flash and SRAM footprint of the SparkFun HM1X Bluetooth Arduino Library,
+# per feature group
+#
+# Builds HM1X_SizeReport once with everything in, once with each feature
+# group or transport left out, and once as the minimal build (no command
+# groups, begin(Stream &) only). A group's cost is what leaving it out
+# saves. Needs arduino-cli with the board's core installed:
+#
+#   extras/size/size_report.sh [fqbn]      (default arduino:avr:uno)
+#
+# No reference figures ship with the library -- sizes depend on the core
+# and compiler, so run this for the board you build for. The figures are
+# labelled with the board they were measured on.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+# GNU General Public License for more details.
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+FQBN=${1:-arduino:avr:uno}
+ARDUINO_CLI=${ARDUINO_CLI:-arduino-cli}
+DIR=$(cd "$(dirname "$0")" && pwd)
+LIBRARY=$(cd "$DIR/../.." && pwd)
+
+# HM1X_CAP_* values, as in src/HM1X_Config.h
+CAP_ALL=$((0x1FF))
+
+# Prints "<flash> <sram>" for a build with the given flags
+measure()
+{
+    "$ARDUINO_CLI" compile --fqbn "$FQBN" --library "$LIBRARY" \
+        --build-property "compiler.cpp.extra_flags=$1" \
+        "$DIR/HM1X_SizeReport" 2>&1 |
+    awk '/^Sketch uses/ { flash = $3 } /^Global variables use/ { sram = $4 }
+         END { if (flash == "") exit 1; print flash, sram }'
+}
+
+set -- $(measure "") || { echo "Build failed -- is $FQBN installed?" >&2; exit 1; }
+FULL_FLASH=$1
+FULL_SRAM=$2
+
+printf '%s\n' "$FQBN"
+printf '%-22s %8s %8s\n' "" "flash" "SRAM"
+printf '%-22s %8d %8d\n' "everything" "$FULL_FLASH" "$FULL_SRAM"
+
+# Without a group, the difference is the group's cost
+group()
+{
+    set -- "$1" $(measure "$2")
+    if [ -z "$3" ]; then
+        printf '%-22s %8s\n' "$1" "failed"
+    else
+        printf '%-22s %8d %8d\n' "$1" $((FULL_FLASH - $2)) $((FULL_SRAM - $3))
+    fi
+}
+
+group "HM1X_CAP_DUAL_MODE" "-DHM1X_CAPABILITIES=$((CAP_ALL & ~0x01))"
+group "HM1X_CAP_IBEACON" "-DHM1X_CAPABILITIES=$((CAP_ALL & ~0x02))"
+group "HM1X_CAP_MTU" "-DHM1X_CAPABILITIES=$((CAP_ALL & ~0x04))"
+group "HM1X_CAP_FRAMING" "-DHM1X_CAPABILITIES=$((CAP_ALL & ~0x08))"
+group "HM1X_CAP_FLOW_CONTROL" "-DHM1X_CAPABILITIES=$((CAP_ALL & ~0x10))"
+group "HM1X_CAP_EDR" "-DHM1X_CAPABILITIES=$((CAP_ALL & ~0x20))"
+group "HM1X_CAP_BLE" "-DHM1X_CAPABILITIES=$((CAP_ALL & ~0x40))"
+group "HM1X_CAP_PIO" "-DHM1X_CAPABILITIES=$((CAP_ALL & ~0x80))"
+group "HM1X_CAP_BOND" "-DHM1X_CAPABILITIES=$((CAP_ALL & ~0x100))"
+group "SoftwareSerial" "-DHM1X_NO_SOFTWARE_SERIAL"
+group "HardwareSerial" "-DHM1X_NO_HARDWARE_SERIAL"
+group "I2C (Qwiic)" "-DHM1X_NO_I2C"
+
+set -- $(measure "-DHM1X_CAPABILITIES=0 -DHM1X_NO_SOFTWARE_SERIAL -DHM1X_NO_HARDWARE_SERIAL -DHM1X_NO_I2C")
+printf '%-22s %8d %8d\n' "minimal build" "$1" "$2"
@@ -0,0 +1,103 @@
+/*
+  Compile-time transport selection for the SparkFun HM1X Bluetooth Arduino Library
+
+  HM1X_BT decides which port to talk to at run time, so every byte goes
+  through a check of each enabled transport. HM1X_BT_T takes the transport
+  as a template parameter instead (see HM1X_Transport.h):
+
+    HM1X_BT_T<HM1X_HardwareSerialTransport> bt;
+    bt.begin(Serial1, 9600);
+
+    HM1X_BT_T<HM1X_WireTransport> qwiic;
+    qwiic.begin(Wire, QWIIC_BLUETOOTH_DEFAULT_ADDRESS);
+
+  available(), read() and write() inline to a single call on the port, and
+  the other transports are never referenced, so the linker drops them.
+  The AT command set is shared with HM1X_BT through HM1X_Core.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "HM1X_Transport.h"
+
+template <class Transport>
+class HM1X_BT_T : public HM1X_Core {
+public:
+    HM1X_BT_T(HM1X_model_t type = HM13) : HM1X_Core(type) {};
+
+    // Arguments go to Transport::attach() -- e.g. (Serial1, 9600) or (Wire, 0x1B)
+    template <typename... Args>
+    boolean begin(Args &&... args)
+    {
+        _transport.attach(args...);
+        if (_transport.baud() > 0)
+        {
+            hwBegin(_transport.baud());
+        }
+        return connect(_transport.baud());
+    };
+
+    Transport & transport(void) { return _transport; };
+
+    // Data path -- hides the HM1X_Core versions so calls inline
+    int available(void)
+    {
+        if (_polling)
+        {
+            return responseAvailable();
+        }
+        return _transport.available();
+    };
+    char read(void)
+    {
+        if (_polling)
+        {
+            return HM1X_Core::read();
+        }
+        return (char) _transport.read();
+    };
+    size_t readBytes(char * buffer, size_t length)
+    {
+        size_t count = 0;
+
+        while ((count < length) && (available() > 0))
+        {
+            buffer[count++] = read();
+        }
+        return count;
+    };
+
+    size_t write(uint8_t c) final { return hwWrite((const char *) &c, 1); };
+    size_t write(const char *str) final { return hwWrite(str, strlen(str)); };
+    size_t write(const char * buffer, size_t size) final { return hwWrite(buffer, size); };
+
+protected:
+    size_t hwWrite(const char * buffer, size_t size) final
+    {
+        Print * port = _transport.pacedPort();
+
+        if ((port != NULL) && hwPacing())
+        {
+            return hwPacedWrite(port, buffer, size);
+        }
+        return _transport.write((const uint8_t *) buffer, size);
+    };
+    int hwAvailable(void) final { return _transport.available(); };
+    char readChar(void) final { return (char) _transport.read(); };
+    void hwBegin(unsigned long baud) final
+    {
+        _baud = baud;
+        _transport.begin(baud, _stopBits, _parity);
+    };
+    boolean hwFramingSupported(void) final { return _transport.framingSupported(); };
+
+private:
+    Transport _transport;
+};
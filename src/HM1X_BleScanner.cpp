@@ -0,0 +1,338 @@
+/*
+  BLE discovery for the SparkFun HM1X Bluetooth Arduino Library
+
+  See HM1X_BleScanner.h for the report format.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <HM1X_BleScanner.h>
+#include <HM1X_Clock.h>
+
+const char HM1X_SCAN_PREFIX[] HM1X_PROGMEM = "OK+";
+const char HM1X_SCAN_START[] HM1X_PROGMEM = "OK+DISCS";
+const char HM1X_SCAN_END[] HM1X_PROGMEM = "OK+DISCE";
+const char HM1X_SCAN_DEVICE[] HM1X_PROGMEM = "OK+DIS";
+const char HM1X_SCAN_RSSI[] HM1X_PROGMEM = "OK+RSSI:";
+const char HM1X_SCAN_NAME[] HM1X_PROGMEM = "OK+NAME:";
+
+HM1X_BleScanner::HM1X_BleScanner(HM1X_Core & bt)
+{
+    _bt = &bt;
+    _onDevice = NULL;
+    _context = NULL;
+    _scanning = false;
+    _continuous = false;
+    _restart = false;
+
+    _tokenLength = 0;
+    _lastByte = 0;
+    _devicePending = false;
+
+    _reportInterval = 0;
+    clearCache();
+    clearCounters();
+}
+
+void HM1X_BleScanner::onDevice(HM1X_device_callback_t callback, void * context)
+{
+    _onDevice = callback;
+    _context = context;
+}
+
+HM1X_error_t HM1X_BleScanner::start(boolean continuous)
+{
+    HM1X_error_t err;
+
+    _continuous = continuous;
+    _restart = false;
+    _tokenLength = 0;
+    _devicePending = false;
+
+    err = _bt->startBleWork();
+    _scanning = (err == HM1X_SUCCESS);
+    return err;
+}
+
+HM1X_error_t HM1X_BleScanner::stop(void)
+{
+    _scanning = false;
+    _restart = false;
+    _tokenLength = 0;
+    _devicePending = false;
+    return _bt->stopBleWork();
+}
+
+void HM1X_BleScanner::clearCache(void)
+{
+    memset(_cache, 0, sizeof(_cache));
+}
+
+void HM1X_BleScanner::clearCounters(void)
+{
+    _devicesReported = 0;
+    _duplicates = 0;
+    _rounds = 0;
+}
+
+uint16_t HM1X_BleScanner::poll(void)
+{
+    uint16_t delivered = 0;
+
+    while (_bt->available())
+    {
+        if (process((char)_bt->read()))
+        {
+            delivered++;
+        }
+    }
+
+    // The last device of a round may have no name to end it
+    if (((_tokenLength > 0) || _devicePending) &&
+        (HM1X_Clock::elapsed(_lastByte) >= HM1X_SCAN_GAP))
+    {
+        if (endToken())
+        {
+            delivered++;
+        }
+        if (deliver())
+        {
+            delivered++;
+        }
+    }
+
+    // A round ended -- start the next outside the parser, since starting
+    // it reads from the port
+    if (_restart)
+    {
+        _restart = false;
+        if (start(true) != HM1X_SUCCESS)
+        {
+            _scanning = false;
+        }
+    }
+
+    return delivered;
+}
+
+boolean HM1X_BleScanner::process(char c)
+{
+    boolean delivered = false;
+
+    _lastByte = HM1X_Clock::now();
+
+    if ((c == '\r') || (c == '\n'))
+    {
+        return endToken();
+    }
+
+    // Reports aren't separated: "OK+" starts the next one -- except in a
+    // name, which runs to the line end
+    if ((c == 'O') && (_tokenLength > 0) && !inName())
+    {
+        delivered = endToken();
+    }
+    if ((_tokenLength < 3) && (c != pgm_read_byte(&HM1X_SCAN_PREFIX[_tokenLength])))
+    {
+        // Not a report -- resynchronize on the next 'O'
+        _tokenLength = 0;
+        if (c != 'O')
+        {
+            return delivered;
+        }
+    }
+    if (_tokenLength >= HM1X_SCAN_TOKEN_LENGTH)
+    {
+        delivered |= endToken();
+    }
+    _token[_tokenLength++] = c;
+
+    return delivered;
+}
+
+boolean HM1X_BleScanner::endToken(void)
+{
+    boolean delivered = false;
+    uint8_t prefixLength;
+
+    if (_tokenLength == 0)
+    {
+        return false;
+    }
+    _token[_tokenLength] = '\0';
+    _tokenLength = 0;
+
+    prefixLength = strlen_P(HM1X_SCAN_RSSI);
+    if (strncmp_P(_token, HM1X_SCAN_RSSI, prefixLength) == 0)
+    {
+        if (_devicePending)
+        {
+            _device.rssi = (int8_t)atoi(_token + prefixLength);
+        }
+        return false;
+    }
+    prefixLength = strlen_P(HM1X_SCAN_NAME);
+    if (strncmp_P(_token, HM1X_SCAN_NAME, prefixLength) == 0)
+    {
+        if (!_devicePending)
+        {
+            return false;
+        }
+        strncpy(_device.name, _token + prefixLength, HM1X_NAME_LENGTH);
+        _device.name[HM1X_NAME_LENGTH] = '\0';
+        return deliver(); // The name is the last report for a device
+    }
+
+    // Anything else ends the device before it
+    delivered = deliver();
+
+    if (strcmp_P(_token, HM1X_SCAN_START) == 0)
+    {
+        return delivered;
+    }
+    if (strcmp_P(_token, HM1X_SCAN_END) == 0)
+    {
+        _rounds++;
+        if (_scanning)
+        {
+            _scanning = false;
+            _restart = _continuous;
+        }
+        return delivered;
+    }
+    // OK+DIS<c>:<address>
+    prefixLength = strlen_P(HM1X_SCAN_DEVICE);
+    if ((strncmp_P(_token, HM1X_SCAN_DEVICE, prefixLength) == 0) &&
+        (_token[prefixLength + 1] == ':'))
+    {
+        const char * address = _token + prefixLength + 2;
+
+        if ((strlen(address) == HM1X_ADDRESS_LENGTH) && parseAddress(address, _device.address))
+        {
+            strcpy(_device.addressText, address);
+            _device.rssi = 0;
+            _device.name[0] = '\0';
+            _devicePending = true;
+        }
+    }
+    return delivered;
+}
+
+boolean HM1X_BleScanner::inName(void)
+{
+    uint8_t prefixLength = strlen_P(HM1X_SCAN_NAME);
+
+    return (_tokenLength >= prefixLength) && (strncmp_P(_token, HM1X_SCAN_NAME, prefixLength) == 0);
+}
+
+boolean HM1X_BleScanner::deliver(void)
+{
+    if (!_devicePending)
+    {
+        return false;
+    }
+    _devicePending = false;
+
+    if (duplicate(_device.address))
+    {
+        _duplicates++;
+        return false;
+    }
+    _devicesReported++;
+    if (_onDevice != NULL)
+    {
+        _onDevice(&_device, _context);
+    }
+    return true;
+}
+
+// Records the address as reported now, unless it was reported less than
+// _reportInterval ago
+boolean HM1X_BleScanner::duplicate(const uint8_t * address)
+{
+    uint32_t hash = 2166136261UL; // FNV-1a
+    uint16_t slot;
+    cache_entry_t * entry;
+    cache_entry_t * empty = NULL;
+    cache_entry_t * oldest = NULL;
+    unsigned long now = HM1X_Clock::now();
+
+    for (uint8_t i = 0; i < HM1X_BLE_ADDRESS_BYTES; i++)
+    {
+        hash = (hash ^ address[i]) * 16777619UL;
+    }
+
+    for (uint8_t i = 0; i < HM1X_SCAN_CACHE_WAYS; i++)
+    {
+        slot = (uint16_t)((hash + i) & (HM1X_SCAN_CACHE_SIZE - 1));
+        entry = &_cache[slot];
+
+        if (!entry->used)
+        {
+            if (empty == NULL)
+            {
+                empty = entry;
+            }
+            continue;
+        }
+        if (memcmp(entry->address, address, HM1X_BLE_ADDRESS_BYTES) == 0)
+        {
+            if ((_reportInterval == 0) ||
+                (HM1X_Clock::elapsed(entry->reportedAt) < _reportInterval))
+            {
+                return true;
+            }
+            entry->reportedAt = now;
+            return false;
+        }
+        if ((oldest == NULL) ||
+            (HM1X_Clock::elapsed(entry->reportedAt) > HM1X_Clock::elapsed(oldest->reportedAt)))
+        {
+            oldest = entry;
+        }
+    }
+
+    entry = (empty != NULL) ? empty : oldest;
+    memcpy(entry->address, address, HM1X_BLE_ADDRESS_BYTES);
+    entry->used = true;
+    entry->reportedAt = now;
+    return false;
+}
+
+boolean HM1X_BleScanner::parseAddress(const char * text, uint8_t * address)
+{
+    for (uint8_t i = 0; i < HM1X_BLE_ADDRESS_BYTES; i++)
+    {
+        uint8_t value = 0;
+
+        for (uint8_t j = 0; j < 2; j++)
+        {
+            char c = text[(i * 2) + j];
+
+            value <<= 4;
+            if ((c >= '0') && (c <= '9'))
+            {
+                value |= c - '0';
+            }
+            else if ((c >= 'A') && (c <= 'F'))
+            {
+                value |= c - 'A' + 10;
+            }
+            else if ((c >= 'a') && (c <= 'f'))
+            {
+                value |= c - 'a' + 10;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        address[i] = value;
+    }
+    return true;
+}
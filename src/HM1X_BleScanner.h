@@ -0,0 +1,142 @@
+/*
+  BLE discovery for the SparkFun HM1X Bluetooth Arduino Library
+
+  Puts the module to work as a BLE central (AT+STARB) and parses the
+  discovery reports as they arrive, a byte at a time, handing each device
+  to a callback:
+
+    void found(const HM1X_BleScanner::HM1X_ble_device_t * device, void * context)
+    {
+        Serial.println(device->addressText);
+    }
+
+    HM1X_BleScanner scanner(bt);
+    bt.setBleMode(HM1X_BT::BLE_CENTRAL);
+    scanner.onDevice(found);
+    scanner.start();
+    // loop():
+    scanner.poll();
+
+  Reports follow the HM-1X discovery format. Each device is an address,
+  then optionally its RSSI and name:
+    OK+DISCS                      discovery started
+    OK+DIS0:001122334455          device address (the digit varies)
+    OK+RSSI:-067                  dBm
+    OK+NAME:Sensor\r\n
+    OK+DISCE                      discovery finished
+  A device is delivered at its name, the next report, or once the module
+  has been quiet for HM1X_SCAN_GAP ms.
+
+  Devices hear each other advertise many times a second, so reports are
+  checked against a cache of binary addresses, HM1X_SCAN_CACHE_SIZE
+  entries (a power of two) in the scanner. A device already delivered is
+  held back until setReportInterval() has passed (never, by default). The
+  cache is bounded: once it fills, the device reported longest ago (of the
+  few its address could occupy) is forgotten and may be delivered again.
+
+  Like HM1X_Framer, poll() reads through bt.available()/read(). With
+  setupPoll(), call bt.poll() first -- but poll() waits HM1X_POLL_DELAY
+  between characters, too slow for a room full of devices.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "SparkFun_HM1X_Bluetooth_Arduino_Library.h"
+
+#ifndef HM1X_SCAN_CACHE_SIZE
+#if defined(__AVR__)
+#define HM1X_SCAN_CACHE_SIZE 16   // Power of two
+#elif defined(HM1X_POSIX_ENABLED)
+#define HM1X_SCAN_CACHE_SIZE 1024 // Power of two -- gateways
+#else
+#define HM1X_SCAN_CACHE_SIZE 256  // Power of two
+#endif
+#endif
+#define HM1X_SCAN_CACHE_WAYS 4    // Entries an address can occupy
+#define HM1X_SCAN_GAP 20          // ms of silence that ends a report
+#define HM1X_BLE_ADDRESS_BYTES 6
+#define HM1X_SCAN_TOKEN_LENGTH (8 + HM1X_NAME_LENGTH + 2) // "OK+NAME:" + name + CR LF
+
+class HM1X_BleScanner {
+    static_assert((HM1X_SCAN_CACHE_SIZE & (HM1X_SCAN_CACHE_SIZE - 1)) == 0, "HM1X_SCAN_CACHE_SIZE must be a power of two");
+
+public:
+    typedef struct {
+        uint8_t address[HM1X_BLE_ADDRESS_BYTES];   // As printed, most significant first
+        char addressText[HM1X_ADDRESS_LENGTH + 1];
+        int8_t rssi;                               // dBm, 0 if not reported
+        char name[HM1X_NAME_LENGTH + 1];           // Empty if not reported
+    } HM1X_ble_device_t;
+
+    // device is only valid until the callback returns
+    typedef void (*HM1X_device_callback_t)(const HM1X_ble_device_t * device, void * context);
+
+    HM1X_BleScanner(HM1X_Core & bt);
+
+    void onDevice(HM1X_device_callback_t callback, void * context = NULL);
+
+    // Start discovery -- the module must be in the BLE central role.
+    // continuous: start another round each time one finishes.
+    HM1X_error_t start(boolean continuous = true);
+    HM1X_error_t stop(void);
+    boolean scanning(void) { return _scanning; };
+
+    // Feed bytes from the module through the parser. Returns the number of
+    // devices delivered to the callback.
+    uint16_t poll(void);
+    // Feed a single byte. Returns true if it delivered a device.
+    boolean process(char c);
+
+    // Deliver a device again once ms have passed since it last was. 0:
+    // only once, until clearCache().
+    void setReportInterval(unsigned long ms) { _reportInterval = ms; };
+    void clearCache(void);
+
+    uint32_t devicesReported(void) { return _devicesReported; };
+    uint32_t duplicates(void) { return _duplicates; };      // Held back by the cache
+    uint32_t rounds(void) { return _rounds; };              // OK+DISCE seen
+    void clearCounters(void);
+
+private:
+    typedef struct {
+        uint8_t address[HM1X_BLE_ADDRESS_BYTES];
+        boolean used;
+        unsigned long reportedAt;
+    } cache_entry_t;
+
+    HM1X_Core * _bt;
+    HM1X_device_callback_t _onDevice;
+    void * _context;
+    boolean _scanning;
+    boolean _continuous;
+    boolean _restart;
+
+    // Report being parsed: "OK+..." up to the next "OK+" or line end
+    char _token[HM1X_SCAN_TOKEN_LENGTH + 1];
+    uint8_t _tokenLength;
+    unsigned long _lastByte;
+
+    // Device being built from its reports
+    HM1X_ble_device_t _device;
+    boolean _devicePending;
+
+    cache_entry_t _cache[HM1X_SCAN_CACHE_SIZE];
+    unsigned long _reportInterval;
+
+    uint32_t _devicesReported;
+    uint32_t _duplicates;
+    uint32_t _rounds;
+
+    boolean endToken(void);
+    boolean inName(void);
+    boolean deliver(void);
+    boolean duplicate(const uint8_t * address);
+    static boolean parseAddress(const char * text, uint8_t * address);
+};
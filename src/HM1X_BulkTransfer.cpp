@@ -0,0 +1,336 @@
+/*
+  Windowed reliable bulk transfer for the SparkFun HM1X Bluetooth Arduino Library
+
+  See HM1X_BulkTransfer.h for the protocol.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <HM1X_BulkTransfer.h>
+
+const uint8_t HM1X_BULK_DEFAULT_WINDOW = 8;
+const uint16_t HM1X_BULK_DEFAULT_RTO = 500;
+const uint8_t HM1X_BULK_DEFAULT_RETRIES = 10;
+
+HM1X_BulkTransfer::HM1X_BulkTransfer(HM1X_Framer & framer)
+{
+    _framer = &framer;
+
+    _state = BULK_IDLE;
+
+    _window = HM1X_BULK_DEFAULT_WINDOW;
+    _rto = HM1X_BULK_DEFAULT_RTO;
+    _maxRetries = HM1X_BULK_DEFAULT_RETRIES;
+    _retries = 0;
+    _chunkSize = 0;
+
+    _source = NULL;
+    _sourceContext = NULL;
+    _length = 0;
+    _finSeq = 0;
+    _base = 0;
+    _next = 0;
+    _timerStart = 0;
+
+    _sink = NULL;
+    _sinkContext = NULL;
+    _expected = 0;
+
+    _bytesDone = 0;
+    _retransmissions = 0;
+    _startTime = 0;
+    _endTime = 0;
+}
+
+void HM1X_BulkTransfer::setWindow(uint8_t frames)
+{
+    if (frames < 1) frames = 1;
+    if (frames > HM1X_BULK_MAX_WINDOW) frames = HM1X_BULK_MAX_WINDOW;
+    _window = frames;
+}
+
+void HM1X_BulkTransfer::setRetransmitTimeout(uint16_t ms)
+{
+    _rto = ms;
+}
+
+void HM1X_BulkTransfer::setMaxRetries(uint8_t retries)
+{
+    _maxRetries = retries;
+}
+
+HM1X_error_t HM1X_BulkTransfer::beginSend(uint32_t length, HM1X_bulk_source_t source, void * context)
+{
+    uint8_t maxFrame;
+
+    if (source == NULL)
+    {
+        return HM1X_UNEXPECTED_RESPONSE;
+    }
+
+    maxFrame = _framer->maxPayload();
+    if (maxFrame > HM1X_BULK_MAX_FRAME) maxFrame = HM1X_BULK_MAX_FRAME;
+    if (maxFrame <= HM1X_BULK_HEADER)
+    {
+        return HM1X_UNEXPECTED_RESPONSE;
+    }
+    _chunkSize = maxFrame - HM1X_BULK_HEADER;
+
+    _source = source;
+    _sourceContext = context;
+    _sink = NULL;
+    _length = length;
+    _finSeq = (length + _chunkSize - 1) / _chunkSize;
+    _base = 0;
+    _next = 0;
+    _retries = 0;
+
+    _bytesDone = 0;
+    _retransmissions = 0;
+    _startTime = HM1X_Clock::now();
+    _timerStart = _startTime;
+
+    _framer->onFrame(frameHandler, this);
+    _state = BULK_SENDING;
+
+    return HM1X_SUCCESS;
+}
+
+HM1X_error_t HM1X_BulkTransfer::beginReceive(HM1X_bulk_sink_t sink, void * context)
+{
+    if (sink == NULL)
+    {
+        return HM1X_UNEXPECTED_RESPONSE;
+    }
+
+    _sink = sink;
+    _sinkContext = context;
+    _source = NULL;
+    _expected = 0;
+
+    _bytesDone = 0;
+    _retransmissions = 0;
+    _startTime = HM1X_Clock::now();
+
+    _framer->onFrame(frameHandler, this);
+    _state = BULK_RECEIVING;
+
+    return HM1X_SUCCESS;
+}
+
+HM1X_BulkTransfer::HM1X_bulk_state_t HM1X_BulkTransfer::service(void)
+{
+    if (_state == BULK_IDLE)
+    {
+        return _state;
+    }
+
+    // Keep draining after completion -- a receiver may still need to
+    // re-ACK a FIN whose ACK was lost.
+    _framer->poll();
+
+    if (_state != BULK_SENDING)
+    {
+        return _state;
+    }
+
+    // Retransmit timeout: go back to the oldest unacknowledged chunk
+    if ((_base < _next) && (HM1X_Clock::elapsed(_timerStart) > _rto))
+    {
+        if (++_retries > _maxRetries)
+        {
+            finish(BULK_FAILED);
+            return _state;
+        }
+        _retransmissions += _next - _base;
+        _next = _base;
+    }
+
+    // Fill the window
+    while ((_next <= _finSeq) && (_next < _base + _window))
+    {
+        HM1X_error_t err = sendChunk(_next);
+
+        if (err == HM1X_ERROR_TRY_LATER)
+        {
+            // The link took only part of the frame, which the peer will
+            // drop. Send it again next time. With nothing in flight the
+            // retransmit timeout can't fire, so count the stall here.
+            if ((_next == _base) && (HM1X_Clock::elapsed(_timerStart) > _rto))
+            {
+                _timerStart = HM1X_Clock::now();
+                if (++_retries > _maxRetries)
+                {
+                    finish(BULK_FAILED);
+                }
+            }
+            break;
+        }
+        if (err != HM1X_SUCCESS)
+        {
+            finish(BULK_FAILED);
+            break;
+        }
+        if (_next == _base)
+        {
+            _timerStart = HM1X_Clock::now();
+        }
+        _next++;
+    }
+
+    return _state;
+}
+
+uint32_t HM1X_BulkTransfer::elapsedMs(void)
+{
+    if (done())
+    {
+        return _endTime - _startTime;
+    }
+    return HM1X_Clock::elapsed(_startTime);
+}
+
+uint32_t HM1X_BulkTransfer::goodput(void)
+{
+    uint32_t ms = elapsedMs();
+
+    if (ms == 0)
+    {
+        return 0;
+    }
+    // 64 bits: bytes * 1000 overflows 32 on multi-megabyte transfers
+    return (uint32_t)(((uint64_t)_bytesDone * 1000) / ms);
+}
+
+/////////////
+// Private //
+/////////////
+
+void HM1X_BulkTransfer::frameHandler(const uint8_t * payload, uint8_t length, void * context)
+{
+    ((HM1X_BulkTransfer *) context)->handleFrame(payload, length);
+}
+
+void HM1X_BulkTransfer::handleFrame(const uint8_t * payload, uint8_t length)
+{
+    if (length < HM1X_BULK_HEADER)
+    {
+        return;
+    }
+
+    switch (payload[0])
+    {
+    case BULK_FRAME_ACK:
+        if (_state == BULK_SENDING)
+        {
+            handleAck(payload[1]);
+        }
+        break;
+    case BULK_FRAME_DATA:
+    case BULK_FRAME_FIN:
+        if (_sink != NULL)
+        {
+            handleData(payload[0], payload[1], payload + HM1X_BULK_HEADER, length - HM1X_BULK_HEADER);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void HM1X_BulkTransfer::handleAck(uint8_t seq)
+{
+    // Expand the 8-bit ACK to an absolute sequence number near _base.
+    // Stale or bogus ACKs land beyond _next and are ignored.
+    uint32_t ackSeq = _base + (uint8_t)(seq - (uint8_t)_base);
+
+    if ((ackSeq <= _base) || (ackSeq > _next))
+    {
+        return;
+    }
+
+    _base = ackSeq;
+    _retries = 0;
+    _timerStart = HM1X_Clock::now();
+
+    if (_base > _finSeq)
+    {
+        _bytesDone = _length;
+        finish(BULK_COMPLETE);
+    }
+    else
+    {
+        _bytesDone = _base * _chunkSize;
+    }
+}
+
+void HM1X_BulkTransfer::handleData(uint8_t type, uint8_t seq, const uint8_t * data, uint8_t length)
+{
+    if ((_state == BULK_RECEIVING) && (seq == (uint8_t)_expected))
+    {
+        if (type == BULK_FRAME_DATA)
+        {
+            _sink(data, length, _bytesDone, _sinkContext);
+            _bytesDone += length;
+            _expected++;
+        }
+        else
+        {
+            _expected++;
+            finish(BULK_COMPLETE);
+        }
+    }
+    // Out of order chunks are dropped. Either way, tell the sender where
+    // we are -- a duplicate ACK is what lets it recover quickly.
+    sendAck();
+}
+
+HM1X_error_t HM1X_BulkTransfer::sendChunk(uint32_t seq)
+{
+    uint8_t len = HM1X_BULK_HEADER;
+
+    _txBuffer[1] = (uint8_t) seq;
+
+    if (seq == _finSeq)
+    {
+        _txBuffer[0] = BULK_FRAME_FIN;
+    }
+    else
+    {
+        uint32_t offset = seq * _chunkSize;
+        size_t toRead = _length - offset;
+        size_t readLen;
+
+        if (toRead > _chunkSize) toRead = _chunkSize;
+
+        readLen = _source(_txBuffer + HM1X_BULK_HEADER, toRead, offset, _sourceContext);
+        if (readLen != toRead)
+        {
+            return HM1X_ERROR_READ_ERROR; // Source couldn't supply the chunk
+        }
+        _txBuffer[0] = BULK_FRAME_DATA;
+        len += readLen;
+    }
+
+    return _framer->send(_txBuffer, len);
+}
+
+void HM1X_BulkTransfer::sendAck(void)
+{
+    uint8_t ack[HM1X_BULK_HEADER];
+
+    ack[0] = BULK_FRAME_ACK;
+    ack[1] = (uint8_t) _expected;
+    _framer->send(ack, sizeof(ack));
+}
+
+void HM1X_BulkTransfer::finish(HM1X_bulk_state_t state)
+{
+    _state = state;
+    _endTime = HM1X_Clock::now();
+}
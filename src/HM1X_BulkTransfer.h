@@ -0,0 +1,128 @@
+/*
+  Windowed reliable bulk transfer for the SparkFun HM1X Bluetooth Arduino Library
+
+  Moves large blobs (firmware images, log files) over an HM1X link without
+  stop-and-wait round trips. Runs on top of HM1X_Framer:
+    - Data is cut into numbered chunks, one chunk per frame
+    - Up to "window" chunks are in flight before an acknowledgement
+    - The receiver acknowledges cumulatively (next sequence it expects)
+    - On a retransmit timeout the sender goes back to the oldest
+      unacknowledged chunk (go-back-N). A frame the link only partly took
+      is lost like any other and sent again.
+
+  The sender pulls data through a source callback by byte offset, so no
+  retransmit buffer is kept -- chunks are re-read from the source when
+  they need to go out again. The receiver hands in-order data to a sink
+  callback. Both ends use the same class and only depend on the HM1X_BT
+  read/write path, so the receiver can run on a host build of the library.
+
+  Frame payloads:
+    DATA: 0x01 | SEQ | chunk bytes
+    FIN:  0x02 | SEQ              (end of transfer, occupies a sequence number)
+    ACK:  0x03 | SEQ              (next sequence expected by the receiver)
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "HM1X_Framer.h"
+
+#define HM1X_BULK_MAX_WINDOW 64     // Must stay below half the 8-bit sequence space
+#define HM1X_BULK_MAX_FRAME 120     // Largest frame payload we'll build
+#define HM1X_BULK_HEADER 2          // Type + sequence
+
+class HM1X_BulkTransfer {
+public:
+    // Fill dest with up to maxLength bytes of the blob, starting at offset.
+    // Return the number of bytes written.
+    typedef size_t (*HM1X_bulk_source_t)(uint8_t * dest, size_t maxLength, uint32_t offset, void * context);
+    // Receive length bytes of the blob, starting at offset. Always in order.
+    typedef void (*HM1X_bulk_sink_t)(const uint8_t * data, uint8_t length, uint32_t offset, void * context);
+
+    typedef enum {
+        BULK_IDLE,
+        BULK_SENDING,
+        BULK_RECEIVING,
+        BULK_COMPLETE,
+        BULK_FAILED
+    } HM1X_bulk_state_t;
+
+    HM1X_BulkTransfer(HM1X_Framer & framer);
+
+    // Frames in flight before waiting on an ACK (1 to HM1X_BULK_MAX_WINDOW)
+    void setWindow(uint8_t frames);
+    // Time to wait on an ACK before resending from the oldest unacked chunk
+    void setRetransmitTimeout(uint16_t ms);
+    // Consecutive timeouts without progress before giving up
+    void setMaxRetries(uint8_t retries);
+
+    HM1X_error_t beginSend(uint32_t length, HM1X_bulk_source_t source, void * context = NULL);
+    HM1X_error_t beginReceive(HM1X_bulk_sink_t sink, void * context = NULL);
+
+    // Call from loop() -- pumps received frames, sends, and handles timeouts.
+    // Returns the current transfer state.
+    HM1X_bulk_state_t service(void);
+    HM1X_bulk_state_t state(void) { return _state; };
+    boolean done(void) { return (_state == BULK_COMPLETE) || (_state == BULK_FAILED); };
+    void abort(void) { _state = BULK_IDLE; };
+
+    // Transfer statistics
+    uint32_t bytesTransferred(void) { return _bytesDone; };
+    uint32_t elapsedMs(void);
+    uint32_t goodput(void); // Payload bytes per second
+    uint16_t retransmissions(void) { return _retransmissions; };
+    uint16_t chunkSize(void) { return _chunkSize; };
+
+private:
+    typedef enum {
+        BULK_FRAME_DATA = 0x01,
+        BULK_FRAME_FIN  = 0x02,
+        BULK_FRAME_ACK  = 0x03
+    } HM1X_bulk_frame_t;
+
+    HM1X_Framer * _framer;
+
+    HM1X_bulk_state_t _state;
+
+    uint8_t _window;
+    uint16_t _rto;
+    uint8_t _maxRetries;
+    uint8_t _retries;
+    uint8_t _chunkSize;
+
+    // Sender -- absolute sequence numbers, wire carries the low 8 bits
+    HM1X_bulk_source_t _source;
+    void * _sourceContext;
+    uint32_t _length;
+    uint32_t _finSeq;     // Sequence number of the FIN frame
+    uint32_t _base;       // Oldest unacknowledged
+    uint32_t _next;       // Next to transmit
+    unsigned long _timerStart;
+
+    // Receiver
+    HM1X_bulk_sink_t _sink;
+    void * _sinkContext;
+    uint32_t _expected;
+
+    uint32_t _bytesDone;
+    uint16_t _retransmissions;
+    unsigned long _startTime;
+    unsigned long _endTime;
+
+    uint8_t _txBuffer[HM1X_BULK_MAX_FRAME];
+
+    static void frameHandler(const uint8_t * payload, uint8_t length, void * context);
+    void handleFrame(const uint8_t * payload, uint8_t length);
+    void handleAck(uint8_t seq);
+    void handleData(uint8_t type, uint8_t seq, const uint8_t * data, uint8_t length);
+
+    HM1X_error_t sendChunk(uint32_t seq);
+    void sendAck(void);
+    void finish(HM1X_bulk_state_t state);
+};
@@ -0,0 +1,47 @@
+/*
+  Time and waiting for the SparkFun HM1X Bluetooth Arduino Library
+
+  See HM1X_Clock.h.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <HM1X_Clock.h>
+
+HM1X_Clock::HM1X_clock_callback_t HM1X_Clock::_clock = NULL;
+void * HM1X_Clock::_clockContext = NULL;
+HM1X_Clock::HM1X_yield_callback_t HM1X_Clock::_onYield = NULL;
+void * HM1X_Clock::_yieldContext = NULL;
+
+void HM1X_Clock::setClock(HM1X_clock_callback_t clock, void * context)
+{
+    _clock = clock;
+    _clockContext = context;
+}
+
+void HM1X_Clock::setYield(HM1X_yield_callback_t onYield, void * context)
+{
+    _onYield = onYield;
+    _yieldContext = context;
+}
+
+void HM1X_Clock::wait(unsigned long ms)
+{
+    unsigned long start;
+
+    if ((_clock == NULL) && (_onYield == NULL))
+    {
+        delay(ms);
+        return;
+    }
+    start = now();
+    while (elapsed(start) < ms)
+    {
+        idle();
+    }
+}
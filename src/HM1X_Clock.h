@@ -0,0 +1,64 @@
+/*
+  Time and waiting for the SparkFun HM1X Bluetooth Arduino Library
+
+  Every wait in the library -- command timeouts, the module's reset time,
+  poll()'s inter-character gap, CTS holds, Qwiic bridge timing -- goes
+  through here, so an application can keep working while the library
+  waits, and a host test can run the library in virtual time.
+
+    void idle(void * context) { wdt_reset(); motors.update(); }
+    HM1X_Clock::setYield(idle);
+
+  With a yield callback, waits spin on the clock calling it instead of
+  sleeping in delay(). With setClock(), the library reads the time from
+  the callback instead of millis() -- a virtual clock's yield callback
+  would normally move it along.
+
+  Timeouts are measured as now() - start, so they work across millis()
+  rolling over.
+
+  Hooks are shared by every module, and set once at start-up. With
+  HM1X_Threaded, the yield callback is also called from the receive
+  thread.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "HM1X_Config.h"
+
+class HM1X_Clock {
+public:
+    typedef unsigned long (*HM1X_clock_callback_t)(void * context); // Milliseconds
+    typedef void (*HM1X_yield_callback_t)(void * context);
+
+    // NULL restores millis()
+    static void setClock(HM1X_clock_callback_t clock, void * context = NULL);
+    // Called while the library waits. NULL: waits sleep in delay().
+    static void setYield(HM1X_yield_callback_t onYield, void * context = NULL);
+
+    static unsigned long now(void) { return (_clock != NULL) ? _clock(_clockContext) : millis(); };
+    static unsigned long elapsed(unsigned long start) { return now() - start; };
+    // Give the application a turn, e.g. once round a spin-wait
+    static void idle(void)
+    {
+        if (_onYield != NULL)
+        {
+            _onYield(_yieldContext);
+        }
+    };
+    // delay(), unless there are hooks to call
+    static void wait(unsigned long ms);
+
+private:
+    static HM1X_clock_callback_t _clock;
+    static void * _clockContext;
+    static HM1X_yield_callback_t _onYield;
+    static void * _yieldContext;
+};
@@ -0,0 +1,142 @@
+/*
+  Build configuration for the SparkFun HM1X Bluetooth Arduino Library
+
+  Selects the transports available on each architecture and defines the
+  types shared by every part of the library.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#if defined(__linux__) && !defined(ARDUINO)
+// Native Linux build -- talk to the module through HM1X_PosixSerial and
+// begin(Stream &). There are no GPIO, UART or I2C drivers to enable.
+#define HM1X_POSIX_ENABLED
+#include "HM1X_PosixCompat.h"
+#elif (ARDUINO >= 100)
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#ifdef __AVR__
+// Keep the AT command and response strings in flash. HM1X_PGM is the
+// printf conversion for a string in flash. By the size of the strings
+// moved, that's an estimated 380 bytes of SRAM on an ATmega328P -- an
+// estimate, not an avr-size measurement; extras/size measures your build.
+#include <avr/pgmspace.h>
+#define HM1X_PROGMEM PROGMEM
+#define HM1X_PGM "%S"
+#else
+// The *_P functions come from the core's pgmspace.h (HM1X_PosixCompat.h on
+// Linux); flash is either memory mapped or the same as RAM.
+#define HM1X_PROGMEM
+#define HM1X_PGM "%s"
+#endif
+
+#ifdef ARDUINO_ARCH_AVR               // Arduino AVR boards (Uno, Pro Micro, etc.)
+#define HM1X_SOFTWARE_SERIAL_ENABLED // Enable software serial
+#define HM1X_HARDWARE_SERIAL_ENABLED // Enable hardware serial
+#define HM1X_I2C_ENABLED
+#endif
+
+#ifdef ARDUINO_ARCH_SAMD              // Arduino SAMD boards (SAMD21, etc.)
+#define HM1X_SOFTWARE_SERIAL_ENABLEDx // Disable software serial
+#define HM1X_HARDWARE_SERIAL_ENABLED
+#define HM1X_I2C_ENABLED
+#endif
+
+#if defined(ARDUINO) && !defined(ARDUINO_ARCH_AVR) && !defined(ARDUINO_ARCH_SAMD)
+// Other Arduino cores (ESP32, STM32, RP2040, ...) -- every core ships
+// HardwareSerial and Wire. Anything else can use begin(Stream &).
+#define HM1X_HARDWARE_SERIAL_ENABLED
+#define HM1X_I2C_ENABLED
+#endif
+
+// Drop transports the board doesn't use. Each one links its driver
+// (SoftwareSerial's interrupt handler, Wire) into every HM1X_BT, used or
+// not. begin(Stream &) is always there.
+//   -DHM1X_NO_SOFTWARE_SERIAL -DHM1X_NO_HARDWARE_SERIAL -DHM1X_NO_I2C
+#ifdef HM1X_NO_SOFTWARE_SERIAL
+#undef HM1X_SOFTWARE_SERIAL_ENABLED
+#endif
+#ifdef HM1X_NO_HARDWARE_SERIAL
+#undef HM1X_HARDWARE_SERIAL_ENABLED
+#endif
+#ifdef HM1X_NO_I2C
+#undef HM1X_I2C_ENABLED
+#endif
+
+// FreeRTOS -- built into the ESP32 core. On other boards (SAMD51 with
+// FreeRTOS_SAMD51, ...) include the port's header in the sketch and
+// build with -DHM1X_FREERTOS.
+#if defined(ARDUINO_ARCH_ESP32) || defined(HM1X_FREERTOS)
+#define HM1X_FREERTOS_ENABLED
+#endif
+
+#if defined(HM1X_POSIX_ENABLED) || defined(HM1X_FREERTOS_ENABLED)
+// Targets with threads and C++11 atomics -- enables HM1X_Threaded
+#define HM1X_THREADS_ENABLED
+#endif
+
+#ifdef HM1X_I2C_ENABLED
+#include <Wire.h>
+#endif
+#ifdef HM1X_SOFTWARE_SERIAL_ENABLED
+#include <SoftwareSerial.h>
+#endif
+
+typedef enum {
+    HM1X_ERROR_INVALID       = -10,
+    HM1X_ERROR_UNSUPPORTED   = -9,
+    HM1X_OUT_OF_MEMORY       = -8,
+    HM1X_RX_OVERFLOW         = -7,
+    HM1X_UNEXPECTED_RESPONSE = -6,
+    HM1X_ERROR_NO_CONNECTION = -5,
+    HM1X_ERROR_TRY_LATER     = -4,
+    HM1X_ERROR_READ_ERROR    = -3,
+    HM1X_ERROR_TIMEOUT       = -2,
+    HM1X_ERROR_ER            = -1,
+    HM1X_SUCCESS             = 0
+} HM1X_error_t;
+
+// Command groups. Commands in a group the model (or the build)
+// lacks return HM1X_ERROR_UNSUPPORTED without going to the radio.
+#define HM1X_CAP_DUAL_MODE    0x01 // EDR + BLE (HM-12/13): AT+NAMB, AT+ADDE, AT+ROLE, ...
+#define HM1X_CAP_IBEACON      0x02 // AT+IBEA, AT+MAJO, AT+MINO, AT+MEAS, ...
+#define HM1X_CAP_MTU          0x04 // AT+MTUS
+#define HM1X_CAP_FRAMING      0x08 // AT+STOP, AT+PARI
+#define HM1X_CAP_FLOW_CONTROL 0x10 // AT+FIOW
+#define HM1X_CAP_EDR          0x20 // EDR side: AT+NAME, AT+ADDE, AT+ROLE, AT+COFD, AT+SCAN, ...
+#define HM1X_CAP_BLE          0x40 // BLE side: AT+NAMB, AT+ADDB, AT+ROLB, AT+COUP, AT+ONEM, ...
+#define HM1X_CAP_PIO          0x80 // AT+PIO
+#define HM1X_CAP_BOND         0x100 // Bonding and PINs: AT+BONDE/B, AT+PINE/B, AT+AUTH
+#define HM1X_CAP_ALL          0x1FF
+
+// Set HM1X_CAPABILITIES in the build flags (or here) to compile out
+// command groups the board will never use, e.g.
+//   -DHM1X_CAPABILITIES="(HM1X_CAP_FRAMING|HM1X_CAP_FLOW_CONTROL)"
+// A command needs every group it belongs to: AT+PINB is DUAL_MODE, BLE and
+// BOND. 0 leaves begin(), poll(), read(), write(), connection tracking and
+// the few commands every module has (AT, RESET, RENEW, VERR, NOTI, BAUD).
+// extras/size reports what each group costs.
+#ifndef HM1X_CAPABILITIES
+#define HM1X_CAPABILITIES HM1X_CAP_ALL
+#endif
+
+// Define HM1X_NO_HEAP in the build flags to drop the String overloads
+// (getEdrName(), connectedBleAddress(), ...). What's left fills buffers the
+// caller provides and never allocates, so a long-running board can't
+// fragment its heap.
+//   -DHM1X_NO_HEAP
+
+// Received data poll() holds for available()/read()
+#ifndef HM1X_POLL_BUFFER_LENGTH
+#define HM1X_POLL_BUFFER_LENGTH 64
+#endif
@@ -0,0 +1,253 @@
+/*
+  Framed datagram layer for the SparkFun HM1X Bluetooth Arduino Library
+
+  See HM1X_Framer.h for the frame format.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <HM1X_Framer.h>
+
+const uint8_t HM1X_ATT_OVERHEAD = 3; // ATT opcode + handle in each BLE packet
+
+HM1X_Framer::HM1X_Framer(HM1X_Core & bt, uint8_t * rxBuffer, uint8_t rxBufferSize)
+{
+    _bt = &bt;
+    _rxBuffer = rxBuffer;
+    _rxBufferSize = rxBufferSize;
+
+    _state = FRAME_WAIT_SOF;
+    _escaped = false;
+    _rxLength = 0;
+    _rxIndex = 0;
+    _rxCrc = 0xFFFF;
+    _rxCrcReceived = 0;
+
+    _callback = NULL;
+    _callbackContext = NULL;
+
+    _txChunkLen = 0;
+    _txShort = false;
+
+    clearCounters();
+    setMtu(HM1X_Core::MTU_SIZE_60);
+}
+
+void HM1X_Framer::onFrame(HM1X_frame_callback_t callback, void * context)
+{
+    _callback = callback;
+    _callbackContext = context;
+}
+
+void HM1X_Framer::setMtu(uint8_t mtu)
+{
+    uint16_t payload;
+
+    if (mtu < HM1X_ATT_OVERHEAD + HM1X_FRAME_ENCODED_MAX(1))
+    {
+        _maxPayload = 1;
+        return;
+    }
+    // Largest payload whose fully stuffed frame still fits the packet
+    payload = ((mtu - HM1X_ATT_OVERHEAD - 1) / 2) - (HM1X_FRAME_OVERHEAD - 1);
+    _maxPayload = (payload > HM1X_FRAME_MAX_PAYLOAD) ? HM1X_FRAME_MAX_PAYLOAD : (uint8_t)payload;
+}
+
+void HM1X_Framer::setMtu(HM1X_Core::HM1X_mtu_size_t mtuSize)
+{
+    setMtu((uint8_t)((mtuSize == HM1X_Core::MTU_SIZE_120) ? 120 : 60));
+}
+
+void HM1X_Framer::clearCounters(void)
+{
+    _framesReceived = 0;
+    _crcErrors = 0;
+    _framingErrors = 0;
+}
+
+HM1X_error_t HM1X_Framer::send(const uint8_t * payload, uint8_t length)
+{
+    uint16_t crc;
+
+    if (length > _maxPayload)
+    {
+        return HM1X_UNEXPECTED_RESPONSE;
+    }
+
+    crc = crc16(length, 0xFFFF);
+    crc = crc16(payload, length, crc);
+
+    // Start of frame is never escaped
+    _txChunkLen = 0;
+    _txShort = false;
+    _txChunk[_txChunkLen++] = HM1X_FRAME_SOF;
+
+    txByte(length);
+    for (uint8_t i = 0; i < length; i++)
+    {
+        txByte(payload[i]);
+    }
+    txByte((uint8_t)(crc >> 8));
+    txByte((uint8_t)(crc & 0xFF));
+    txFlush();
+
+    // Part of the frame never went out -- the peer will drop what did
+    if (_txShort)
+    {
+        return HM1X_ERROR_TRY_LATER;
+    }
+    return HM1X_SUCCESS;
+}
+
+uint8_t HM1X_Framer::poll(void)
+{
+    uint8_t frames = 0;
+
+    while (_bt->available() > 0)
+    {
+        if (process((uint8_t)_bt->read()))
+        {
+            frames++;
+        }
+    }
+    return frames;
+}
+
+boolean HM1X_Framer::process(uint8_t c)
+{
+    // A start of frame always begins a new frame. If one was in progress
+    // it was truncated -- drop it and resynchronize here.
+    if (c == HM1X_FRAME_SOF)
+    {
+        if ((_state != FRAME_WAIT_SOF) && (_state != FRAME_LENGTH))
+        {
+            _framingErrors++;
+        }
+        _state = FRAME_LENGTH;
+        _escaped = false;
+        return false;
+    }
+
+    if (_state == FRAME_WAIT_SOF)
+    {
+        return false; // Discard line noise between frames
+    }
+
+    if (c == HM1X_FRAME_ESCAPE)
+    {
+        _escaped = true;
+        return false;
+    }
+    if (_escaped)
+    {
+        c ^= HM1X_FRAME_ESCAPE_XOR;
+        _escaped = false;
+    }
+
+    switch (_state)
+    {
+    case FRAME_LENGTH:
+        if (c > _rxBufferSize)
+        {
+            // Corrupt length, or a frame we have no room for
+            _framingErrors++;
+            _state = FRAME_WAIT_SOF;
+            break;
+        }
+        _rxLength = c;
+        _rxIndex = 0;
+        _rxCrc = crc16(c, 0xFFFF);
+        _state = (_rxLength > 0) ? FRAME_PAYLOAD : FRAME_CRC_HIGH;
+        break;
+    case FRAME_PAYLOAD:
+        _rxBuffer[_rxIndex++] = c;
+        _rxCrc = crc16(c, _rxCrc);
+        if (_rxIndex >= _rxLength)
+        {
+            _state = FRAME_CRC_HIGH;
+        }
+        break;
+    case FRAME_CRC_HIGH:
+        _rxCrcReceived = ((uint16_t) c) << 8;
+        _state = FRAME_CRC_LOW;
+        break;
+    case FRAME_CRC_LOW:
+        _rxCrcReceived |= c;
+        _state = FRAME_WAIT_SOF;
+        if (_rxCrcReceived != _rxCrc)
+        {
+            _crcErrors++;
+            break;
+        }
+        _framesReceived++;
+        if (_callback != NULL)
+        {
+            _callback(_rxBuffer, _rxLength, _callbackContext);
+        }
+        return true;
+    default:
+        _state = FRAME_WAIT_SOF;
+        break;
+    }
+    return false;
+}
+
+// CRC-16/CCITT (poly 0x1021)
+uint16_t HM1X_Framer::crc16(uint8_t c, uint16_t crc)
+{
+    crc ^= ((uint16_t) c) << 8;
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        if (crc & 0x8000)
+        {
+            crc = (crc << 1) ^ 0x1021;
+        }
+        else
+        {
+            crc <<= 1;
+        }
+    }
+    return crc;
+}
+
+uint16_t HM1X_Framer::crc16(const uint8_t * data, size_t length, uint16_t crc)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        crc = crc16(data[i], crc);
+    }
+    return crc;
+}
+
+void HM1X_Framer::txByte(uint8_t c)
+{
+    // Leave room for an escaped pair
+    if (_txChunkLen > sizeof(_txChunk) - 2)
+    {
+        txFlush();
+    }
+    if ((c == HM1X_FRAME_SOF) || (c == HM1X_FRAME_ESCAPE))
+    {
+        _txChunk[_txChunkLen++] = HM1X_FRAME_ESCAPE;
+        _txChunk[_txChunkLen++] = c ^ HM1X_FRAME_ESCAPE_XOR;
+    }
+    else
+    {
+        _txChunk[_txChunkLen++] = c;
+    }
+}
+
+// Once a write falls short the frame is lost, so the rest isn't sent
+void HM1X_Framer::txFlush(void)
+{
+    if ((_txChunkLen > 0) && !_txShort)
+    {
+        _txShort = (_bt->write((const char *) _txChunk, _txChunkLen) < _txChunkLen);
+    }
+    _txChunkLen = 0;
+}
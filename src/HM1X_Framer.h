@@ -0,0 +1,109 @@
+/*
+  Framed datagram layer for the SparkFun HM1X Bluetooth Arduino Library
+
+  The HM1X modules expose a raw byte stream. BLE splits and merges that
+  stream at MTU boundaries, so discrete messages need framing to survive
+  the link. HM1X_Framer wraps an HM1X_BT (or HM1X_BT_T) and adds:
+    - Length-prefixed frames with a CRC-16/CCITT trailer
+    - HDLC-style byte stuffing, so a start-of-frame byte always marks a
+      frame boundary and the receiver resynchronizes after corruption
+    - A receive callback pointing straight into the caller's buffer
+
+  Frame format (before stuffing):
+    0x7E | LEN | PAYLOAD[LEN] | CRC_HI | CRC_LO
+  CRC covers LEN and PAYLOAD. 0x7E and 0x7D inside a frame are sent as
+  0x7D followed by the byte XOR 0x20.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "SparkFun_HM1X_Bluetooth_Arduino_Library.h"
+
+#define HM1X_FRAME_SOF 0x7E
+#define HM1X_FRAME_ESCAPE 0x7D
+#define HM1X_FRAME_ESCAPE_XOR 0x20
+#define HM1X_FRAME_OVERHEAD 4 // SOF, LEN, CRC x2
+#define HM1X_FRAME_MAX_PAYLOAD 255
+// Bytes on the wire if every byte after the SOF needs stuffing
+#define HM1X_FRAME_ENCODED_MAX(payload) (1 + 2 * ((payload) + HM1X_FRAME_OVERHEAD - 1))
+
+class HM1X_Framer {
+public:
+    // Called once per valid frame. payload points into the receive buffer
+    // passed to the constructor, and is only valid until the callback returns.
+    typedef void (*HM1X_frame_callback_t)(const uint8_t * payload, uint8_t length, void * context);
+
+    // rxBuffer must hold the largest payload that will be received
+    HM1X_Framer(HM1X_Core & bt, uint8_t * rxBuffer, uint8_t rxBufferSize);
+
+    void onFrame(HM1X_frame_callback_t callback, void * context = NULL);
+
+    // Size frames to fit the link's MTU. ATT costs 3 bytes of each packet,
+    // the rest must hold the frame even if every byte of it is stuffed --
+    // HM1X_FRAME_ENCODED_MAX(maxPayload()) -- so payloads are a little
+    // under half the packet.
+    void setMtu(uint8_t mtu);
+    void setMtu(HM1X_Core::HM1X_mtu_size_t mtuSize);
+    uint8_t maxPayload(void) { return _maxPayload; };
+
+    // Send one frame. Payload can't exceed maxPayload(). Returns
+    // HM1X_ERROR_TRY_LATER if the module took only part of it.
+    HM1X_error_t send(const uint8_t * payload, uint8_t length);
+
+    // Feed bytes from the module through the frame parser.
+    // Returns the number of frames delivered to the callback.
+    uint8_t poll(void);
+    // Feed a single byte. Returns true if it completed a valid frame.
+    boolean process(uint8_t c);
+
+    uint16_t framesReceived(void) { return _framesReceived; };
+    uint16_t crcErrors(void) { return _crcErrors; };
+    uint16_t framingErrors(void) { return _framingErrors; };
+    void clearCounters(void);
+
+    static uint16_t crc16(const uint8_t * data, size_t length, uint16_t crc = 0xFFFF);
+    static uint16_t crc16(uint8_t c, uint16_t crc);
+
+private:
+    typedef enum {
+        FRAME_WAIT_SOF,
+        FRAME_LENGTH,
+        FRAME_PAYLOAD,
+        FRAME_CRC_HIGH,
+        FRAME_CRC_LOW
+    } HM1X_frame_state_t;
+
+    HM1X_Core * _bt;
+
+    uint8_t * _rxBuffer;
+    uint8_t _rxBufferSize;
+    uint8_t _maxPayload;
+
+    HM1X_frame_state_t _state;
+    boolean _escaped;
+    uint8_t _rxLength;
+    uint8_t _rxIndex;
+    uint16_t _rxCrc;
+    uint16_t _rxCrcReceived;
+
+    HM1X_frame_callback_t _callback;
+    void * _callbackContext;
+
+    uint16_t _framesReceived;
+    uint16_t _crcErrors;
+    uint16_t _framingErrors;
+
+    uint8_t _txChunk[16];
+    uint8_t _txChunkLen;
+    boolean _txShort; // A write fell short -- the frame is lost
+
+    void txByte(uint8_t c);
+    void txFlush(void);
+};
@@ -0,0 +1,196 @@
+/*
+  Host (Linux) build support for the SparkFun HM1X Bluetooth Arduino Library
+
+  See HM1X_PosixCompat.h.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <HM1X_PosixCompat.h>
+
+#if defined(__linux__) && !defined(ARDUINO)
+
+#include <time.h>
+#include <errno.h>
+#include <HM1X_Clock.h>
+
+static uint64_t clockMicros(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000ULL + now.tv_nsec / 1000;
+}
+
+static uint64_t monotonicMicros(void)
+{
+    // Initialized once, thread-safely, on the first call
+    static const uint64_t start = clockMicros();
+
+    return clockMicros() - start;
+}
+
+// Truncated to unsigned long, so these wrap like their Arduino counterparts
+unsigned long millis(void)
+{
+    return (unsigned long) (monotonicMicros() / 1000);
+}
+
+unsigned long micros(void)
+{
+    return (unsigned long) monotonicMicros();
+}
+
+void delay(unsigned long ms)
+{
+    struct timespec request;
+
+    request.tv_sec = ms / 1000;
+    request.tv_nsec = (ms % 1000) * 1000000L;
+    while ((nanosleep(&request, &request) != 0) && (errno == EINTR))
+        ;
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    struct timespec request;
+
+    request.tv_sec = us / 1000000;
+    request.tv_nsec = (us % 1000000) * 1000L;
+    while ((nanosleep(&request, &request) != 0) && (errno == EINTR))
+        ;
+}
+
+String String::substring(unsigned int from) const
+{
+    return substring(from, _s.size());
+}
+
+String String::substring(unsigned int from, unsigned int to) const
+{
+    if (from > to)
+    {
+        unsigned int swap = from;
+        from = to;
+        to = swap;
+    }
+    if (from >= _s.size())
+    {
+        return String();
+    }
+    if (to > _s.size())
+    {
+        to = _s.size();
+    }
+    return String(_s.substr(from, to - from));
+}
+
+int String::indexOf(char c) const
+{
+    size_t pos = _s.find(c);
+    return (pos == std::string::npos) ? -1 : (int) pos;
+}
+
+int String::indexOf(const String & str) const
+{
+    size_t pos = _s.find(str._s);
+    return (pos == std::string::npos) ? -1 : (int) pos;
+}
+
+void String::toCharArray(char * buffer, unsigned int size) const
+{
+    if (size == 0)
+    {
+        return;
+    }
+    strncpy(buffer, _s.c_str(), size - 1);
+    buffer[size - 1] = 0;
+}
+
+void String::remove(unsigned int index, unsigned int count)
+{
+    if (index < _s.size())
+    {
+        _s.erase(index, count);
+    }
+}
+
+String operator+(const String & a, const String & b)
+{
+    String sum(a);
+    sum += b;
+    return sum;
+}
+
+size_t Print::write(const uint8_t * buffer, size_t size)
+{
+    size_t n = 0;
+
+    while (size--)
+    {
+        if (write(*buffer++) == 0)
+        {
+            break;
+        }
+        n++;
+    }
+    return n;
+}
+
+size_t Print::print(long value, int base)
+{
+    char buffer[24];
+
+    if (base == 16)
+    {
+        snprintf(buffer, sizeof(buffer), "%lX", value);
+    }
+    else
+    {
+        snprintf(buffer, sizeof(buffer), "%ld", value);
+    }
+    return write(buffer);
+}
+
+size_t Print::print(unsigned long value, int base)
+{
+    char buffer[24];
+
+    if (base == 16)
+    {
+        snprintf(buffer, sizeof(buffer), "%lX", value);
+    }
+    else
+    {
+        snprintf(buffer, sizeof(buffer), "%lu", value);
+    }
+    return write(buffer);
+}
+
+size_t Stream::readBytes(char * buffer, size_t length)
+{
+    unsigned long timeIn = HM1X_Clock::now();
+    size_t count = 0;
+
+    while ((count < length) && (HM1X_Clock::elapsed(timeIn) < _timeout))
+    {
+        int c = read();
+        if (c >= 0)
+        {
+            buffer[count++] = (char) c;
+            timeIn = HM1X_Clock::now();
+        }
+        else
+        {
+            HM1X_Clock::idle();
+        }
+    }
+    return count;
+}
+
+#endif
@@ -0,0 +1,136 @@
+/*
+  Host (Linux) build support for the SparkFun HM1X Bluetooth Arduino Library
+
+  The subset of the Arduino core the library uses -- Print, Stream, String,
+  millis()/delay() -- implemented on POSIX, so the command and notification
+  logic can run on a Linux gateway. Pair it with HM1X_PosixSerial for a
+  /dev/tty* port.
+
+  Only used when building without an Arduino core (ARDUINO undefined).
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#if defined(__linux__) && !defined(ARDUINO)
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <string>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+// Monotonic time since the first call
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+// There's no GPIO on the host. Pins read LOW, which leaves an active-low
+// CTS line permanently asserted.
+inline void pinMode(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t) { return LOW; }
+inline void digitalWrite(uint8_t, uint8_t) {}
+
+// No separate program memory -- flash strings are ordinary strings
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(addr) (*(const uint8_t *) (addr))
+#define strlen_P strlen
+#define strcpy_P strcpy
+#define strcat_P strcat
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define sprintf_P sprintf
+
+class String {
+public:
+    String(const char * str = "") : _s(str ? str : "") {};
+    String(const std::string & str) : _s(str) {};
+    String(char c) : _s(1, c) {};
+    String(int value) : _s(std::to_string(value)) {};
+    String(unsigned int value) : _s(std::to_string(value)) {};
+    String(long value) : _s(std::to_string(value)) {};
+    String(unsigned long value) : _s(std::to_string(value)) {};
+
+    unsigned int length(void) const { return _s.size(); };
+    const char * c_str(void) const { return _s.c_str(); };
+    char charAt(unsigned int index) const { return (index < _s.size()) ? _s[index] : 0; };
+    char operator[](unsigned int index) const { return charAt(index); };
+    String substring(unsigned int from) const;
+    String substring(unsigned int from, unsigned int to) const;
+    int indexOf(char c) const;
+    int indexOf(const String & str) const;
+    boolean startsWith(const String & prefix) const { return _s.compare(0, prefix._s.size(), prefix._s) == 0; };
+    void toCharArray(char * buffer, unsigned int size) const;
+    long toInt(void) const { return strtol(_s.c_str(), NULL, 10); };
+    void reserve(unsigned int size) { _s.reserve(size); };
+    void remove(unsigned int index, unsigned int count = (unsigned int) -1);
+    boolean concat(char c) { _s += c; return true; };
+    boolean concat(const String & str) { _s += str._s; return true; };
+
+    String & operator+=(const String & str) { _s += str._s; return *this; };
+    String & operator+=(const char * str) { _s += str; return *this; };
+    String & operator+=(char c) { _s += c; return *this; };
+    boolean operator==(const String & str) const { return _s == str._s; };
+    boolean operator==(const char * str) const { return _s == str; };
+    boolean operator!=(const String & str) const { return _s != str._s; };
+
+private:
+    std::string _s;
+};
+
+String operator+(const String & a, const String & b);
+
+class Print {
+public:
+    virtual ~Print() {};
+
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t * buffer, size_t size);
+    size_t write(const char * str) { return (str == NULL) ? 0 : write((const uint8_t *) str, strlen(str)); };
+    size_t write(const char * buffer, size_t size) { return write((const uint8_t *) buffer, size); };
+    virtual int availableForWrite(void) { return 0; };
+    virtual void flush(void) {};
+
+    size_t print(const char * str) { return write(str); };
+    size_t print(const String & str) { return write(str.c_str()); };
+    size_t print(char c) { return write((uint8_t) c); };
+    size_t print(long value, int base = 10);
+    size_t print(unsigned long value, int base = 10);
+    size_t print(int value, int base = 10) { return print((long) value, base); };
+    size_t print(unsigned int value, int base = 10) { return print((unsigned long) value, base); };
+    size_t println(void) { return write("\r\n"); };
+    template <typename T> size_t println(T value) { size_t n = print(value); return n + println(); };
+};
+
+class Stream : public Print {
+public:
+    virtual int available(void) = 0;
+    virtual int read(void) = 0;
+    virtual int peek(void) = 0;
+
+    void setTimeout(unsigned long timeout) { _timeout = timeout; };
+    size_t readBytes(char * buffer, size_t length);
+
+protected:
+    unsigned long _timeout = 1000;
+};
+
+#endif
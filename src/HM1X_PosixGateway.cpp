@@ -0,0 +1,302 @@
+/*
+  epoll gateway for the SparkFun HM1X Bluetooth Arduino Library
+
+  See HM1X_PosixGateway.h.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <HM1X_PosixGateway.h>
+
+#ifdef HM1X_POSIX_ENABLED
+
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <new>
+
+HM1X_PosixGateway::HM1X_PosixGateway() :
+    _epoll(-1), _count(0), _onData(NULL), _dataContext(NULL), _onEvent(NULL), _eventContext(NULL)
+{
+}
+
+HM1X_error_t HM1X_PosixGateway::begin(void)
+{
+    if (_epoll >= 0)
+    {
+        return HM1X_SUCCESS;
+    }
+    _epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (_epoll < 0)
+    {
+        return HM1X_ERROR_NO_CONNECTION;
+    }
+    return HM1X_SUCCESS;
+}
+
+void HM1X_PosixGateway::end(void)
+{
+    while (_count > 0)
+    {
+        delete _modules[--_count];
+    }
+    if (_epoll >= 0)
+    {
+        close(_epoll);
+        _epoll = -1;
+    }
+}
+
+int HM1X_PosixGateway::add(const char * path, unsigned long baud)
+{
+    module_t * module;
+    struct epoll_event event;
+
+    if (_epoll < 0)
+    {
+        return HM1X_ERROR_NO_CONNECTION;
+    }
+    if (_count >= HM1X_GATEWAY_MAX_MODULES)
+    {
+        return HM1X_OUT_OF_MEMORY;
+    }
+    module = new (std::nothrow) module_t();
+    if (module == NULL)
+    {
+        return HM1X_OUT_OF_MEMORY;
+    }
+    if ((module->port.begin(path, baud) != HM1X_SUCCESS) ||
+        !module->bt.begin(module->port, baud, HM1X_PosixSerial::onBaud, &module->port) ||
+        !module->bt.setupPoll())
+    {
+        delete module;
+        return HM1X_ERROR_NO_CONNECTION;
+    }
+
+    event.events = EPOLLIN;
+    event.data.u32 = _count;
+    if (epoll_ctl(_epoll, EPOLL_CTL_ADD, module->port.fd(), &event) != 0)
+    {
+        delete module;
+        return HM1X_ERROR_NO_CONNECTION;
+    }
+    _modules[_count] = module;
+    return _count++;
+}
+
+boolean HM1X_PosixGateway::attached(uint8_t index)
+{
+    return (index < _count) && (_modules[index]->port.fd() >= 0);
+}
+
+void HM1X_PosixGateway::onData(HM1X_data_callback_t callback, void * context)
+{
+    _onData = callback;
+    _dataContext = context;
+}
+
+void HM1X_PosixGateway::onEvent(HM1X_event_callback_t callback, void * context)
+{
+    _onEvent = callback;
+    _eventContext = context;
+}
+
+HM1X_error_t HM1X_PosixGateway::command(uint8_t index, const char * command,
+    HM1X_response_callback_t callback, void * context, uint16_t timeout)
+{
+    module_t * module;
+
+    if (!attached(index))
+    {
+        return HM1X_ERROR_NO_CONNECTION;
+    }
+    module = _modules[index];
+    // Don't let a reply run into data that's still being collected
+    if (module->commandPending || (module->rxCount > 0))
+    {
+        return HM1X_ERROR_TRY_LATER;
+    }
+
+    module->bt.print("AT");
+    if (strlen(command) > 0)
+    {
+        module->bt.print("+");
+        module->bt.print(command);
+    }
+    module->commandPending = true;
+    module->commandSent = millis();
+    module->commandTimeout = timeout;
+    module->commandCallback = callback;
+    module->commandContext = context;
+    return HM1X_SUCCESS;
+}
+
+size_t HM1X_PosixGateway::write(uint8_t index, const uint8_t * data, size_t size)
+{
+    if (!attached(index))
+    {
+        return 0;
+    }
+    return _modules[index]->bt.write((const char *) data, size);
+}
+
+int HM1X_PosixGateway::run(int timeout)
+{
+    struct epoll_event events[HM1X_GATEWAY_MAX_MODULES];
+    int ready;
+    int callbacks = 0;
+    unsigned long now;
+
+    if (_epoll < 0)
+    {
+        return -1;
+    }
+    ready = epoll_wait(_epoll, events, HM1X_GATEWAY_MAX_MODULES, nextTimeout(timeout));
+    if (ready < 0)
+    {
+        return (errno == EINTR) ? 0 : -1;
+    }
+
+    for (int i = 0; i < ready; i++)
+    {
+        uint8_t index = events[i].data.u32;
+
+        if (events[i].events & EPOLLIN)
+        {
+            receive(index);
+            if (_modules[index]->rxCount >= HM1X_GATEWAY_RX_BUFFER_SIZE)
+            {
+                callbacks += dispatch(index);
+            }
+        }
+        if ((events[i].events & (EPOLLHUP | EPOLLERR)) && (_modules[index]->port.available() == 0))
+        {
+            // Port is gone -- stop waiting on it
+            epoll_ctl(_epoll, EPOLL_CTL_DEL, _modules[index]->port.fd(), NULL);
+            _modules[index]->port.end();
+        }
+    }
+
+    // Deliver messages that have gone quiet and commands that timed out
+    now = millis();
+    for (uint8_t index = 0; index < _count; index++)
+    {
+        module_t * module = _modules[index];
+
+        if ((module->rxCount > 0) && (now - module->lastRx >= HM1X_GATEWAY_MESSAGE_GAP))
+        {
+            callbacks += dispatch(index);
+        }
+        else if (module->commandPending && (module->rxCount == 0) &&
+                 (now - module->commandSent >= module->commandTimeout))
+        {
+            module->commandPending = false;
+            if (module->commandCallback != NULL)
+            {
+                module->commandCallback(index, HM1X_ERROR_TIMEOUT, "", module->commandContext);
+                callbacks++;
+            }
+        }
+    }
+    return callbacks;
+}
+
+void HM1X_PosixGateway::receive(uint8_t index)
+{
+    module_t * module = _modules[index];
+    int c;
+
+    while ((module->rxCount < HM1X_GATEWAY_RX_BUFFER_SIZE) && ((c = module->port.read()) >= 0))
+    {
+        module->rx[module->rxCount++] = c;
+    }
+    module->lastRx = millis();
+}
+
+int HM1X_PosixGateway::dispatch(uint8_t index)
+{
+    module_t * module = _modules[index];
+    HM1X_Core::HM1X_notification_t event;
+    char address[HM1X_ADDRESS_LENGTH + 1] = "";
+    size_t size = module->rxCount;
+
+    module->rx[size] = 0;
+    module->rxCount = 0;
+
+    event = module->bt.handleNotification((const char *) module->rx);
+    if (event != HM1X_Core::HM1X_NOTIFY_NONE)
+    {
+        if (_onEvent == NULL)
+        {
+            return 0;
+        }
+        if ((event == HM1X_Core::HM1X_NOTIFY_CONNECT_EDR) || (event == HM1X_Core::HM1X_NOTIFY_DISCONNECT_EDR))
+        {
+            module->bt.connectedEdrAddress(address);
+        }
+        else if ((event == HM1X_Core::HM1X_NOTIFY_CONNECT_BLE) || (event == HM1X_Core::HM1X_NOTIFY_DISCONNECT_BLE))
+        {
+            module->bt.connectedBleAddress(address);
+        }
+        _onEvent(index, event, address, _eventContext);
+        return 1;
+    }
+
+    if (module->commandPending)
+    {
+        module->commandPending = false;
+        if (module->commandCallback == NULL)
+        {
+            return 0;
+        }
+        module->commandCallback(index, HM1X_SUCCESS, (const char *) module->rx, module->commandContext);
+        return 1;
+    }
+
+    if (_onData == NULL)
+    {
+        return 0;
+    }
+    _onData(index, module->rx, size, _dataContext);
+    return 1;
+}
+
+// Wake in time for the earliest message gap or command deadline
+int HM1X_PosixGateway::nextTimeout(int timeout)
+{
+    unsigned long now = millis();
+
+    for (uint8_t index = 0; index < _count; index++)
+    {
+        module_t * module = _modules[index];
+        unsigned long elapsed;
+        int remaining;
+
+        if (module->rxCount > 0)
+        {
+            elapsed = now - module->lastRx;
+            remaining = (elapsed >= HM1X_GATEWAY_MESSAGE_GAP) ? 0 : (HM1X_GATEWAY_MESSAGE_GAP - elapsed);
+        }
+        else if (module->commandPending)
+        {
+            elapsed = now - module->commandSent;
+            remaining = (elapsed >= module->commandTimeout) ? 0 : (module->commandTimeout - elapsed);
+        }
+        else
+        {
+            continue;
+        }
+        if ((timeout < 0) || (remaining < timeout))
+        {
+            timeout = remaining;
+        }
+    }
+    return timeout;
+}
+
+#endif
@@ -0,0 +1,106 @@
+/*
+  epoll gateway for the SparkFun HM1X Bluetooth Arduino Library
+
+  Runs many HM1X modules from one thread on a Linux host. Each module gets
+  an HM1X_PosixSerial and an HM1X_BT, and the gateway waits on all of their
+  ports at once:
+
+    HM1X_PosixGateway gateway;
+    gateway.begin();
+    gateway.onData(handleData, NULL);
+    gateway.onEvent(handleConnect, NULL);
+    gateway.add("/dev/ttyUSB0", 9600);
+    gateway.add("/dev/ttyUSB1", 9600);
+    while (1) gateway.run(1000);
+
+  Received bytes are split into messages on a quiet gap, the same way
+  HM1X_Core::poll() does. A message is first checked for a connect or
+  disconnect notification. Otherwise it completes the module's pending
+  command() or is delivered as data. Only add() blocks, while it sets the
+  module up.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "HM1X_PosixSerial.h"
+
+#ifdef HM1X_POSIX_ENABLED
+
+#define HM1X_GATEWAY_MAX_MODULES 32
+#define HM1X_GATEWAY_RX_BUFFER_SIZE 256
+#define HM1X_GATEWAY_MESSAGE_GAP 10      // ms of silence that ends a message
+#define HM1X_GATEWAY_COMMAND_TIMEOUT 100 // ms to wait for the first byte of a response
+
+class HM1X_PosixGateway {
+public:
+    typedef void (*HM1X_data_callback_t)(uint8_t module, const uint8_t * data, size_t size, void * context);
+    typedef void (*HM1X_event_callback_t)(uint8_t module, HM1X_Core::HM1X_notification_t event,
+                                          const char * address, void * context);
+    typedef void (*HM1X_response_callback_t)(uint8_t module, HM1X_error_t err, const char * response, void * context);
+
+    HM1X_PosixGateway();
+    ~HM1X_PosixGateway() { end(); };
+
+    HM1X_error_t begin(void);
+    void end(void);
+
+    // Open a port, connect to its module and enable notifications. Returns
+    // the module's index, or a negative HM1X_error_t.
+    int add(const char * path, unsigned long baud = 9600);
+    uint8_t modules(void) { return _count; };
+    // False once the module's port has hung up (e.g. adapter unplugged)
+    boolean attached(uint8_t index);
+    HM1X_BT & module(uint8_t index) { return _modules[index]->bt; };
+    HM1X_PosixSerial & port(uint8_t index) { return _modules[index]->port; };
+
+    void onData(HM1X_data_callback_t callback, void * context = NULL);
+    void onEvent(HM1X_event_callback_t callback, void * context = NULL);
+
+    // Send "AT+<command>" ("AT" if empty). The callback gets the response,
+    // or HM1X_ERROR_TIMEOUT. One command per module at a time -- returns
+    // HM1X_ERROR_TRY_LATER while one is outstanding.
+    HM1X_error_t command(uint8_t index, const char * command, HM1X_response_callback_t callback,
+                         void * context = NULL, uint16_t timeout = HM1X_GATEWAY_COMMAND_TIMEOUT);
+    size_t write(uint8_t index, const uint8_t * data, size_t size);
+
+    // Wait up to timeout ms (-1 forever) and dispatch whatever is ready.
+    // Returns the number of callbacks made, or -1 if epoll fails.
+    int run(int timeout);
+    // epoll descriptor, to nest the gateway in another event loop
+    int fd(void) { return _epoll; };
+
+private:
+    typedef struct {
+        HM1X_PosixSerial port;
+        HM1X_BT bt;
+        uint8_t rx[HM1X_GATEWAY_RX_BUFFER_SIZE + 1];
+        size_t rxCount;
+        unsigned long lastRx;
+        boolean commandPending;
+        unsigned long commandSent;
+        uint16_t commandTimeout;
+        HM1X_response_callback_t commandCallback;
+        void * commandContext;
+    } module_t;
+
+    int _epoll;
+    module_t * _modules[HM1X_GATEWAY_MAX_MODULES];
+    uint8_t _count;
+    HM1X_data_callback_t _onData;
+    void * _dataContext;
+    HM1X_event_callback_t _onEvent;
+    void * _eventContext;
+
+    void receive(uint8_t index);
+    int dispatch(uint8_t index);
+    int nextTimeout(int timeout);
+};
+
+#endif
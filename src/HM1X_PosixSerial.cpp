@@ -0,0 +1,231 @@
+/*
+  POSIX serial port for the SparkFun HM1X Bluetooth Arduino Library
+
+  See HM1X_PosixSerial.h.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <HM1X_PosixSerial.h>
+
+#ifdef HM1X_POSIX_ENABLED
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <termios.h>
+
+// How long write() waits for room in the kernel's transmit queue
+#define HM1X_POSIX_WRITE_TIMEOUT 1000
+
+static speed_t posixSpeed(unsigned long baud)
+{
+    switch (baud)
+    {
+    case 1200: return B1200;
+    case 2400: return B2400;
+    case 4800: return B4800;
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    default: return B0;
+    }
+}
+
+HM1X_error_t HM1X_PosixSerial::begin(const char * path, unsigned long baud)
+{
+    HM1X_error_t err;
+
+    end();
+    _fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (_fd < 0)
+    {
+        return HM1X_ERROR_NO_CONNECTION;
+    }
+    err = configure(baud, HM1X_Core::HM1X_STOP_BITS_1, HM1X_Core::HM1X_PARITY_NONE);
+    if (err != HM1X_SUCCESS)
+    {
+        end();
+        return err;
+    }
+    tcflush(_fd, TCIOFLUSH);
+    return HM1X_SUCCESS;
+}
+
+HM1X_error_t HM1X_PosixSerial::beginPty(char * slavePath, size_t size)
+{
+    end();
+    _fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if ((_fd < 0) || (grantpt(_fd) != 0) || (unlockpt(_fd) != 0) ||
+        (ptsname_r(_fd, slavePath, size) != 0))
+    {
+        end();
+        return HM1X_ERROR_NO_CONNECTION;
+    }
+    return HM1X_SUCCESS;
+}
+
+void HM1X_PosixSerial::end(void)
+{
+    if (_fd >= 0)
+    {
+        close(_fd);
+        _fd = -1;
+    }
+    _rxHead = _rxTail = 0;
+}
+
+HM1X_error_t HM1X_PosixSerial::setBaud(unsigned long baud,
+    HM1X_Core::HM1X_stop_bits_t stopBits, HM1X_Core::HM1X_parity_t parity)
+{
+    if (_fd < 0)
+    {
+        return HM1X_ERROR_NO_CONNECTION;
+    }
+    tcdrain(_fd);
+    return configure(baud, stopBits, parity);
+}
+
+void HM1X_PosixSerial::onBaud(unsigned long baud, HM1X_Core::HM1X_stop_bits_t stopBits,
+    HM1X_Core::HM1X_parity_t parity, void * context)
+{
+    ((HM1X_PosixSerial *) context)->setBaud(baud, stopBits, parity);
+}
+
+HM1X_error_t HM1X_PosixSerial::configure(unsigned long baud,
+    HM1X_Core::HM1X_stop_bits_t stopBits, HM1X_Core::HM1X_parity_t parity)
+{
+    struct termios tio;
+    speed_t speed = posixSpeed(baud);
+
+    if (speed == B0)
+    {
+        return HM1X_ERROR_ER;
+    }
+    if (tcgetattr(_fd, &tio) != 0)
+    {
+        return HM1X_ERROR_NO_CONNECTION;
+    }
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cflag &= ~(CSTOPB | PARENB | PARODD | CRTSCTS);
+    if (stopBits == HM1X_Core::HM1X_STOP_BITS_2)
+    {
+        tio.c_cflag |= CSTOPB;
+    }
+    if (parity == HM1X_Core::HM1X_PARITY_EVEN)
+    {
+        tio.c_cflag |= PARENB;
+    }
+    else if (parity == HM1X_Core::HM1X_PARITY_ODD)
+    {
+        tio.c_cflag |= PARENB | PARODD;
+    }
+    // Non-blocking: read() returns whatever has arrived
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    if (tcsetattr(_fd, TCSANOW, &tio) != 0)
+    {
+        return HM1X_ERROR_NO_CONNECTION;
+    }
+    return HM1X_SUCCESS;
+}
+
+void HM1X_PosixSerial::fillRxBuffer(void)
+{
+    ssize_t count;
+
+    if (_fd < 0)
+    {
+        return;
+    }
+    if (_rxHead == _rxTail)
+    {
+        _rxHead = _rxTail = 0;
+    }
+    if (_rxTail == HM1X_POSIX_RX_BUFFER_SIZE)
+    {
+        // Compact before reading more
+        memmove(_rxBuffer, _rxBuffer + _rxHead, _rxTail - _rxHead);
+        _rxTail -= _rxHead;
+        _rxHead = 0;
+    }
+    count = ::read(_fd, _rxBuffer + _rxTail, HM1X_POSIX_RX_BUFFER_SIZE - _rxTail);
+    if (count > 0)
+    {
+        _rxTail += count;
+    }
+}
+
+int HM1X_PosixSerial::available(void)
+{
+    fillRxBuffer();
+    return (int) (_rxTail - _rxHead);
+}
+
+int HM1X_PosixSerial::read(void)
+{
+    if ((_rxHead == _rxTail) && (available() == 0))
+    {
+        return -1;
+    }
+    return _rxBuffer[_rxHead++];
+}
+
+int HM1X_PosixSerial::peek(void)
+{
+    if ((_rxHead == _rxTail) && (available() == 0))
+    {
+        return -1;
+    }
+    return _rxBuffer[_rxHead];
+}
+
+size_t HM1X_PosixSerial::write(const uint8_t * buffer, size_t size)
+{
+    size_t sent = 0;
+
+    while ((_fd >= 0) && (sent < size))
+    {
+        ssize_t count = ::write(_fd, buffer + sent, size - sent);
+        if (count > 0)
+        {
+            sent += count;
+        }
+        else if ((count < 0) && (errno != EAGAIN) && (errno != EINTR))
+        {
+            break;
+        }
+        else
+        {
+            // Transmit queue full -- wait for room
+            struct pollfd pfd = { _fd, POLLOUT, 0 };
+            if (poll(&pfd, 1, HM1X_POSIX_WRITE_TIMEOUT) <= 0)
+            {
+                break;
+            }
+        }
+    }
+    return sent;
+}
+
+void HM1X_PosixSerial::flush(void)
+{
+    if (_fd >= 0)
+    {
+        tcdrain(_fd);
+    }
+}
+
+#endif
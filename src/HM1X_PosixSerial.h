@@ -0,0 +1,72 @@
+/*
+  POSIX serial port for the SparkFun HM1X Bluetooth Arduino Library
+
+  A Stream over a termios device, for running the library on a Linux
+  gateway with the module on a USB-UART adapter:
+
+    HM1X_PosixSerial port;
+    HM1X_BT bt;
+    port.begin("/dev/ttyUSB0", 9600);
+    bt.begin(port, 9600, HM1X_PosixSerial::onBaud, &port);
+
+  Reads never block. beginPty() opens the master side of a pseudo-terminal
+  instead, so a simulated module can sit on the other end.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "SparkFun_HM1X_Bluetooth_Arduino_Library.h"
+
+#ifdef HM1X_POSIX_ENABLED
+
+#define HM1X_POSIX_RX_BUFFER_SIZE 256
+
+class HM1X_PosixSerial : public Stream {
+public:
+    HM1X_PosixSerial() : _fd(-1), _rxHead(0), _rxTail(0) {};
+    ~HM1X_PosixSerial() { end(); };
+
+    // Open a tty in raw 8N1 mode. Returns HM1X_ERROR_NO_CONNECTION if the
+    // device can't be opened or configured.
+    HM1X_error_t begin(const char * path, unsigned long baud = 9600);
+    // Open a new pseudo-terminal and write the slave's path to slavePath
+    HM1X_error_t beginPty(char * slavePath, size_t size);
+    void end(void);
+
+    HM1X_error_t setBaud(unsigned long baud,
+                         HM1X_Core::HM1X_stop_bits_t stopBits = HM1X_Core::HM1X_STOP_BITS_1,
+                         HM1X_Core::HM1X_parity_t parity = HM1X_Core::HM1X_PARITY_NONE);
+    // HM1X_baud_callback_t for HM1X_BT::begin(Stream &) -- context is the port
+    static void onBaud(unsigned long baud, HM1X_Core::HM1X_stop_bits_t stopBits,
+                       HM1X_Core::HM1X_parity_t parity, void * context);
+
+    int fd(void) { return _fd; };
+    operator bool(void) { return (_fd >= 0); };
+
+    int available(void);
+    int read(void);
+    int peek(void);
+    size_t write(uint8_t c) { return write(&c, 1); };
+    size_t write(const uint8_t * buffer, size_t size);
+    using Print::write;
+    void flush(void);
+
+private:
+    int _fd;
+    uint8_t _rxBuffer[HM1X_POSIX_RX_BUFFER_SIZE];
+    size_t _rxHead;
+    size_t _rxTail;
+
+    HM1X_error_t configure(unsigned long baud, HM1X_Core::HM1X_stop_bits_t stopBits,
+                           HM1X_Core::HM1X_parity_t parity);
+    void fillRxBuffer(void);
+};
+
+#endif
@@ -0,0 +1,571 @@
+/*
+  Qwiic Bluetooth bridge transport for the SparkFun HM1X Bluetooth Arduino Library
+
+  See HM1X_QwiicBridge.h for an overview.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <HM1X_QwiicBridge.h>
+#include <HM1X_Clock.h>
+
+#ifdef HM1X_I2C_ENABLED
+typedef enum {
+  I2C_CMD_AVAILABLE, // 0
+  I2C_CMD_READ,      // 1
+  I2C_CMD_WRITE,     // 2
+  I2C_CMD_SET_BAUD,  // 3
+  I2C_SET_ADDRESS,   // 4
+  I2C_CMD_READ_WITH_AVAILABLE, // 5 -- [bytes available] followed by up to N bytes
+  I2C_CMD_VERSION,   // 6 -- [magic][firmware version][capability flags]
+  I2C_CMD_BUFFER_SIZE // 7 -- [bytes the bridge can move per transaction]
+} qwiic_bt_commands_t;
+
+const uint8_t QWIIC_BT_VERSION_MAGIC = 0xB7;
+const uint8_t QWIIC_BT_VERSION_LENGTH = 3;
+const int QWIIC_BT_ADDRESS_DELAY = 10;
+
+HM1X_QwiicBridge::HM1X_QwiicBridge()
+{
+    _wirePort = NULL;
+    _address = 0;
+    _rxIndex = 0;
+    _rxCount = 0;
+    _remoteCount = 0;
+    _lastPoll = 0;
+    _pollInterval = HM1X_I2C_POLL_INTERVAL;
+    _version = 0;
+    _capabilities = 0;
+    _chunkSize = HM1X_I2C_CHUNK_SIZE;
+    _intPin = -1;
+    _clock = HM1X_I2C_CLOCK_STANDARD;
+#if defined(SDA) && defined(SCL)
+    _sdaPin = SDA;
+    _sclPin = SCL;
+#else
+    _sdaPin = -1;
+    _sclPin = -1;
+#endif
+    clearCounters();
+}
+
+void HM1X_QwiicBridge::begin(TwoWire & wirePort, uint8_t address, int intPin, uint32_t clock)
+{
+    _wirePort = &wirePort;
+    _address = address;
+    _intPin = intPin;
+    if (_intPin >= 0)
+    {
+        pinMode(_intPin, INPUT_PULLUP); // Bridge drives it open-drain
+    }
+    _rxIndex = 0;
+    _rxCount = 0;
+    _remoteCount = 0;
+
+    _wirePort->begin();
+    _wirePort->setClock(HM1X_I2C_CLOCK_STANDARD);
+    _clock = HM1X_I2C_CLOCK_STANDARD;
+
+    // Find out if the bridge supports the fused read, fall back if not
+    probe();
+
+    // Only speed up once the bridge is known to answer
+    if (clock > HM1X_I2C_CLOCK_STANDARD)
+    {
+        setClock(clock);
+    }
+}
+
+int HM1X_QwiicBridge::available(void)
+{
+    // May refill the cache (fused read), so count the cache afterwards
+    int remote = remoteAvailable();
+    return remote + (_rxCount - _rxIndex);
+}
+
+// Serve from the receive cache, refilling it with a full chunk
+// when empty rather than fetching a byte per transaction.
+int HM1X_QwiicBridge::readRefill(void)
+{
+    if (fillRxBuffer() == 0)
+    {
+        return -1;
+    }
+    return _rxBuffer[_rxIndex++];
+}
+
+size_t HM1X_QwiicBridge::readBytes(uint8_t * buffer, size_t length, uint8_t maxTransactions)
+{
+    size_t count = 0;
+    uint32_t limit = _transactions + maxTransactions;
+
+    while (count < length)
+    {
+        if (_rxIndex >= _rxCount)
+        {
+            // A cached count saves the query
+            uint8_t cost = refillTransactions();
+            if ((cost > 1) && (_pollInterval > 0) && (HM1X_Clock::elapsed(_lastPoll) < _pollInterval))
+            {
+                cost = 1;
+            }
+            if ((_transactions + cost > limit) || (fillRxBuffer() == 0))
+            {
+                break;
+            }
+        }
+        buffer[count++] = _rxBuffer[_rxIndex++];
+    }
+    return count;
+}
+
+void HM1X_QwiicBridge::clearCounters(void)
+{
+    _transactions = 0;
+    _busBytes = 0;
+    _errors = 0;
+    _failures = 0;
+    _recoveries = 0;
+    _payloadBytes = 0;
+    _busMicros = 0;
+}
+
+size_t HM1X_QwiicBridge::write(const uint8_t * buffer, size_t size)
+{
+    size_t charsWritten = 0;
+
+    // The bridge can only take one chunk per transmission.
+    // Split larger writes into multiple transmissions.
+    while (charsWritten < size)
+    {
+        size_t toWrite = size - charsWritten;
+        if (toWrite > _chunkSize) toWrite = _chunkSize;
+
+        if (!transaction(I2C_CMD_WRITE, buffer + charsWritten, toWrite, NULL, 0))
+        {
+            break; // Report only what the bridge accepted
+        }
+        charsWritten += toWrite;
+        _payloadBytes += toWrite;
+    }
+    return charsWritten;
+}
+
+int HM1X_QwiicBridge::remoteAvailable(void)
+{
+    uint8_t count;
+
+    // Trust the cached count until the poll interval elapses -- it is
+    // decremented locally as bytes are read, so it never over-reports.
+    if ((_pollInterval > 0) && (HM1X_Clock::elapsed(_lastPoll) < _pollInterval))
+    {
+        return _remoteCount;
+    }
+
+    // Data-ready line idle -- bridge is empty, no need to ask it.
+    // Without an INT pin, fall back to polling the bridge.
+    if ((_intPin >= 0) && (digitalRead(_intPin) == HIGH))
+    {
+        _remoteCount = 0;
+        return 0;
+    }
+
+    // With an empty cache, the fused command checks and fetches in one go
+    if ((_capabilities & QWIIC_BT_CAP_READ_WITH_AVAILABLE) && (_rxIndex >= _rxCount))
+    {
+        fillRxBuffer();
+        return _remoteCount;
+    }
+
+    _lastPoll = HM1X_Clock::now();
+    if (!transaction(I2C_CMD_AVAILABLE, NULL, 0, &count, 1))
+    {
+        _remoteCount = 0; // Never hand a failed read back as a length
+        return 0;
+    }
+    _remoteCount = count;
+    return _remoteCount;
+}
+
+uint8_t HM1X_QwiicBridge::fillRxBuffer(void)
+{
+    int avail;
+    uint8_t bytesToRead;
+
+    _rxIndex = 0;
+    _rxCount = 0;
+
+    if (_capabilities & QWIIC_BT_CAP_READ_WITH_AVAILABLE)
+    {
+        return fusedRead();
+    }
+
+    avail = remoteAvailable();
+
+    if (avail <= 0)
+    {
+        return 0;
+    }
+    bytesToRead = (avail > _chunkSize) ? _chunkSize : avail;
+    if (bytesToRead > HM1X_I2C_RX_BUFFER_SIZE) bytesToRead = HM1X_I2C_RX_BUFFER_SIZE;
+
+    if (!transaction(I2C_CMD_READ, &bytesToRead, 1, _rxBuffer, bytesToRead))
+    {
+        // Whatever the bridge gave up is gone -- re-sync the count
+        _remoteCount = 0;
+        _lastPoll = HM1X_Clock::now() - _pollInterval;
+        return 0;
+    }
+    _rxCount = bytesToRead;
+    _remoteCount -= bytesToRead;
+    _payloadBytes += bytesToRead;
+    return _rxCount;
+}
+
+// I2C_CMD_READ_WITH_AVAILABLE -- one transaction replaces AVAILABLE + READ.
+// Bridge answers with the number of bytes it held, then that many bytes
+// (up to the requested count).
+uint8_t HM1X_QwiicBridge::fusedRead(void)
+{
+    // Chunk + count byte still fits the host's Wire buffer
+    uint8_t reply[HM1X_I2C_MAX_CHUNK + 1];
+    uint8_t bytesToRead = _chunkSize;
+    uint8_t held;
+
+    _lastPoll = HM1X_Clock::now();
+    _remoteCount = 0;
+
+    if (!transaction(I2C_CMD_READ_WITH_AVAILABLE, &bytesToRead, 1, reply, bytesToRead + 1))
+    {
+        return 0;
+    }
+
+    held = reply[0];
+    if (held < bytesToRead) bytesToRead = held;
+    for (_rxCount = 0; _rxCount < bytesToRead; _rxCount++)
+    {
+        _rxBuffer[_rxCount] = reply[_rxCount + 1];
+    }
+    _remoteCount = held - _rxCount;
+    _payloadBytes += _rxCount;
+    return _rxCount;
+}
+
+// Step down from the requested clock until the bridge passes verification
+HM1X_error_t HM1X_QwiicBridge::setClock(uint32_t clock)
+{
+    uint32_t tryClock = clock;
+
+    while (1)
+    {
+        _wirePort->setClock(tryClock);
+        _clock = tryClock;
+        if (verifyClock())
+        {
+            return (tryClock == clock) ? HM1X_SUCCESS : HM1X_ERROR_READ_ERROR;
+        }
+
+        if (tryClock > HM1X_I2C_CLOCK_FAST)
+        {
+            tryClock = HM1X_I2C_CLOCK_FAST;
+        }
+        else if (tryClock > HM1X_I2C_CLOCK_STANDARD)
+        {
+            tryClock = HM1X_I2C_CLOCK_STANDARD;
+        }
+        else
+        {
+            return HM1X_ERROR_NO_CONNECTION;
+        }
+    }
+}
+
+uint32_t HM1X_QwiicBridge::bytesPerSecond(void)
+{
+    if (_busMicros == 0)
+    {
+        return 0;
+    }
+    return (uint32_t) ((float) _payloadBytes * 1000000.0 / (float) _busMicros);
+}
+
+// Run a burst of transactions at the current clock. Retries would hide a
+// marginal bus, so a single failed attempt fails the whole test.
+boolean HM1X_QwiicBridge::verifyClock(void)
+{
+    uint32_t errors = _errors;
+    uint8_t reply[QWIIC_BT_VERSION_LENGTH];
+
+    for (uint8_t i = 0; i < HM1X_I2C_VERIFY_ROUNDS; i++)
+    {
+        if (_version > 0)
+        {
+            // Known reply -- catches corrupted bits, not just NACKs
+            if (!transaction(I2C_CMD_VERSION, NULL, 0, reply, QWIIC_BT_VERSION_LENGTH)
+                || (reply[0] != QWIIC_BT_VERSION_MAGIC) || (reply[1] != _version)
+                || (reply[2] != _capabilities))
+            {
+                return false;
+            }
+        }
+        else if (!transaction(I2C_CMD_AVAILABLE, NULL, 0, reply, 1))
+        {
+            return false;
+        }
+    }
+    return (_errors == errors);
+}
+
+// I2C_CMD_VERSION -- Ask the bridge what it supports. Older firmware doesn't
+// know the command, so only trust a reply that starts with the magic byte.
+void HM1X_QwiicBridge::probe(void)
+{
+    uint8_t reply[QWIIC_BT_VERSION_LENGTH];
+
+    _version = 0;
+    _capabilities = 0;
+
+    if (transaction(I2C_CMD_VERSION, NULL, 0, reply, QWIIC_BT_VERSION_LENGTH)
+        && (reply[0] == QWIIC_BT_VERSION_MAGIC))
+    {
+        _version = reply[1];
+        _capabilities = reply[2];
+    }
+
+    // Default to the ATtiny85 limit unless the bridge says otherwise
+    _chunkSize = HM1X_I2C_CHUNK_SIZE;
+    if (_capabilities & QWIIC_BT_CAP_BUFFER_SIZE)
+    {
+        uint8_t size;
+
+        if (transaction(I2C_CMD_BUFFER_SIZE, NULL, 0, &size, 1) && (size > 0))
+        {
+            // Bounded by the host's Wire buffer (command byte + chunk)
+            _chunkSize = (size > HM1X_I2C_MAX_CHUNK) ? HM1X_I2C_MAX_CHUNK : size;
+        }
+    }
+}
+
+// Reads that pop bytes off the bridge can't be repeated after the data
+// phase fails -- the bytes are already gone. Everything else can.
+static boolean i2cRepeatable(uint8_t command)
+{
+    return (command != I2C_CMD_READ) && (command != I2C_CMD_READ_WITH_AVAILABLE);
+}
+
+// Send command + args, then optionally read exactly destLength bytes back.
+// Returns false unless the whole transaction completed -- callers must not
+// use dest on failure.
+boolean HM1X_QwiicBridge::transaction(uint8_t command, const uint8_t * args, uint8_t argLength,
+                                       uint8_t * dest, uint8_t destLength)
+{
+    unsigned long start = micros();
+    boolean success;
+
+    success = exchange(command, args, argLength, dest, destLength);
+    _busMicros += (uint32_t) (micros() - start);
+    return success;
+}
+
+// Retries address NACKs and bus errors, recovering a stuck bus if needed.
+boolean HM1X_QwiicBridge::exchange(uint8_t command, const uint8_t * args, uint8_t argLength,
+                                    uint8_t * dest, uint8_t destLength)
+{
+    for (uint8_t attempt = 0; attempt <= HM1X_I2C_RETRIES; attempt++)
+    {
+        uint8_t status;
+
+        _wirePort->beginTransmission(_address);
+        _wirePort->write(command);
+        for (uint8_t i = 0; i < argLength; i++)
+        {
+            _wirePort->write(args[i]);
+        }
+        status = _wirePort->endTransmission(dest == NULL);
+        _transactions++;
+        _busBytes += argLength + 1;
+
+        if (status != 0)
+        {
+            fault();
+            // 3: NACK on data -- the bridge may have taken part of a write,
+            // sending it again would duplicate bytes.
+            if (status == 3)
+            {
+                _failures++;
+                return false;
+            }
+            continue;
+        }
+        if (dest == NULL)
+        {
+            return true;
+        }
+
+        if (_wirePort->requestFrom(_address, destLength) == destLength)
+        {
+            _busBytes += destLength;
+            for (uint8_t i = 0; i < destLength; i++)
+            {
+                dest[i] = (uint8_t) _wirePort->read();
+            }
+            return true;
+        }
+
+        // Short read -- discard the partial data
+        while (_wirePort->available())
+        {
+            _wirePort->read();
+        }
+        fault();
+        if (!i2cRepeatable(command))
+        {
+            _failures++;
+            return false;
+        }
+    }
+    _failures++;
+    return false;
+}
+
+void HM1X_QwiicBridge::fault(void)
+{
+    _errors++;
+
+    // A slave that lost clocks mid-byte can hold SDA low forever
+    if ((_sdaPin >= 0) && (_sclPin >= 0) && (digitalRead(_sdaPin) == LOW))
+    {
+        recoverBus();
+    }
+}
+
+// Pull a line low. The latch goes low first so the pin never drives high
+// -- like open-drain, it only ever pulls down or lets the pullup win.
+static void i2cPullLow(int pin)
+{
+    digitalWrite(pin, LOW);
+    pinMode(pin, OUTPUT);
+}
+
+// Clock SCL until the stuck slave releases SDA, then issue a STOP
+void HM1X_QwiicBridge::recoverBus(void)
+{
+    _wirePort->end();
+
+    pinMode(_sdaPin, INPUT_PULLUP);
+    pinMode(_sclPin, INPUT_PULLUP);
+    for (uint8_t i = 0; (i < 9) && (digitalRead(_sdaPin) == LOW); i++)
+    {
+        i2cPullLow(_sclPin);
+        delayMicroseconds(5);
+        pinMode(_sclPin, INPUT_PULLUP);
+        delayMicroseconds(5);
+    }
+    // STOP: SDA rises while SCL is high
+    i2cPullLow(_sdaPin);
+    delayMicroseconds(5);
+    pinMode(_sclPin, INPUT_PULLUP);
+    delayMicroseconds(5);
+    pinMode(_sdaPin, INPUT_PULLUP);
+    delayMicroseconds(5);
+
+    // begin() drops the bus back to its default clock
+    _wirePort->begin();
+    _wirePort->setClock(_clock);
+    _recoveries++;
+}
+
+void HM1X_QwiicBridge::setModuleBaud(uint8_t baudIndex)
+{
+    transaction(I2C_CMD_SET_BAUD, &baudIndex, 1, NULL, 0);
+}
+
+// Does anything ACK at this address?
+static boolean i2cAck(TwoWire * wirePort, uint8_t address)
+{
+    wirePort->beginTransmission(address);
+    return (wirePort->endTransmission(true) == 0);
+}
+
+// Is there a Qwiic Bluetooth bridge at this address? Whatever else is on
+// the bus is never written to -- a command byte could be a register write
+// to some other device. At the two addresses the board can be jumpered to,
+// an ACK is enough (older firmware can't prove itself). Anywhere else, a
+// bare read must come back with the version magic, which newer firmware
+// answers when no command is pending.
+static boolean i2cBridgeAt(TwoWire * wirePort, uint8_t address)
+{
+    boolean magic;
+
+    if (!i2cAck(wirePort, address))
+    {
+        return false;
+    }
+    if ((address == QWIIC_BLUETOOTH_DEFAULT_ADDRESS) || (address == QWIIC_BLUETOOTH_JUMPED_ADDRESS))
+    {
+        return true;
+    }
+
+    if (wirePort->requestFrom(address, QWIIC_BT_VERSION_LENGTH) != QWIIC_BT_VERSION_LENGTH)
+    {
+        return false;
+    }
+    magic = (wirePort->read() == QWIIC_BT_VERSION_MAGIC);
+    while (wirePort->available()) wirePort->read();
+    return magic;
+}
+
+uint8_t HM1X_QwiicBridge::scan(TwoWire & wirePort, uint8_t * addresses, uint8_t maxAddresses)
+{
+    uint8_t found = 0;
+
+    for (uint8_t address = 0x08; (address <= 0x77) && (found < maxAddresses); address++)
+    {
+        if (i2cBridgeAt(&wirePort, address))
+        {
+            addresses[found++] = address;
+        }
+    }
+    return found;
+}
+
+HM1X_error_t HM1X_QwiicBridge::changeAddress(uint8_t address)
+{
+    if ((_wirePort == NULL) || (address < 0x08) || (address > 0x77))
+    {
+        return HM1X_UNEXPECTED_RESPONSE;
+    }
+    if (address == _address)
+    {
+        return HM1X_SUCCESS;
+    }
+    // Two devices on one address would corrupt each other's transfers
+    if (i2cAck(_wirePort, address))
+    {
+        return HM1X_ERROR_INVALID;
+    }
+
+    setAddress(address);
+    HM1X_Clock::wait(QWIIC_BT_ADDRESS_DELAY); // Give the bridge time to re-init its I2C peripheral
+
+    if (!i2cAck(_wirePort, address))
+    {
+        return HM1X_ERROR_NO_CONNECTION;
+    }
+    _address = address;
+    return HM1X_SUCCESS;
+}
+
+void HM1X_QwiicBridge::setAddress(uint8_t address)
+{
+    if ((address < 0x08) || (address > 0x77)) {
+        return;
+    }
+    transaction(I2C_SET_ADDRESS, &address, 1, NULL, 0);
+}
+#endif
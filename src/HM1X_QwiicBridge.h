@@ -0,0 +1,163 @@
+/*
+  Qwiic Bluetooth bridge transport for the SparkFun HM1X Bluetooth Arduino Library
+
+  The Qwiic Bluetooth board puts an ATtiny85 between the I2C bus and the
+  module's UART. HM1X_QwiicBridge speaks the bridge's command set:
+    - Received bytes are fetched a chunk at a time into a local cache
+    - The bridge's byte count is cached between polls, or skipped entirely
+      while the optional data-ready line is idle
+    - Newer bridge firmware reports a version, a fused available+read
+      command and its transfer size; older firmware is still supported
+    - Every transaction is checked, retried, and a stuck bus is recovered
+
+  HM1X_BT uses one of these for its Qwiic transport. It can also be used
+  directly as the transport policy of HM1X_BT_T.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "HM1X_Config.h"
+
+#define QWIIC_BLUETOOTH_DEFAULT_ADDRESS 0x1B
+#define QWIIC_BLUETOOTH_JUMPED_ADDRESS 0x1C
+
+#ifdef HM1X_I2C_ENABLED
+#define HM1X_I2C_CHUNK_SIZE 14      // ATtiny85 bridge moves 14 bytes per transaction
+// Largest chunk the host's Wire buffer can carry alongside a command byte
+#if defined(BUFFER_LENGTH)
+#define HM1X_I2C_WIRE_BUFFER BUFFER_LENGTH
+#elif defined(I2C_BUFFER_LENGTH)
+#define HM1X_I2C_WIRE_BUFFER I2C_BUFFER_LENGTH
+#else
+#define HM1X_I2C_WIRE_BUFFER 32
+#endif
+#if (HM1X_I2C_WIRE_BUFFER > 65)
+#define HM1X_I2C_MAX_CHUNK 64
+#else
+#define HM1X_I2C_MAX_CHUNK (HM1X_I2C_WIRE_BUFFER - 1)
+#endif
+#define HM1X_I2C_RX_BUFFER_SIZE HM1X_I2C_MAX_CHUNK // Host-side receive cache
+#define HM1X_I2C_POLL_INTERVAL 2    // Minimum ms between bridge byte-count queries
+#define HM1X_I2C_RETRIES 2          // Extra attempts after a failed transaction
+#define HM1X_I2C_CLOCK_STANDARD 100000
+#define HM1X_I2C_CLOCK_FAST 400000
+#define HM1X_I2C_CLOCK_FAST_PLUS 1000000
+#define HM1X_I2C_VERIFY_ROUNDS 16   // Transactions that must pass at a new clock
+
+// Qwiic bridge capability flags (reported by I2C_CMD_VERSION)
+#define QWIIC_BT_CAP_READ_WITH_AVAILABLE 0x01
+#define QWIIC_BT_CAP_BUFFER_SIZE 0x02
+
+class HM1X_QwiicBridge {
+public:
+    HM1X_QwiicBridge();
+
+    // intPin: optional bridge data-ready output (active low). When given,
+    // the bus is only touched while the line is asserted.
+    void begin(TwoWire &wirePort, uint8_t address, int intPin = -1, uint32_t clock = HM1X_I2C_CLOCK_STANDARD);
+    boolean attached(void) { return (_wirePort != NULL); };
+
+    // Byte stream to/from the module
+    int available(void);
+    int read(void) { return (_rxIndex < _rxCount) ? _rxBuffer[_rxIndex++] : readRefill(); };
+    // Read up to length bytes, starting no more than maxTransactions bus
+    // transactions (a failed one may still be retried). Cached bytes cost
+    // none. Returns the number read.
+    size_t readBytes(uint8_t * buffer, size_t length, uint8_t maxTransactions);
+    // Transactions one refill of the cache takes: a fused read, or a count
+    // query and a read on older firmware
+    uint8_t refillTransactions(void) { return (_capabilities & QWIIC_BT_CAP_READ_WITH_AVAILABLE) ? 1 : 2; };
+    size_t write(const uint8_t * buffer, size_t size);
+
+    // Tell the bridge to talk to the module at btBauds[baudIndex]
+    void setModuleBaud(uint8_t baudIndex);
+
+    // Bus usage
+    // The bridge's byte count is cached and only re-read once per poll
+    // interval (ms). 0 asks the bridge on every available() call.
+    void setPollInterval(uint16_t ms) { _pollInterval = ms; };
+    uint32_t transactions(void) { return _transactions; };
+    uint32_t busBytes(void) { return _busBytes; };
+    uint64_t busMicros(void) { return _busMicros; }; // Time spent in transactions
+    void clearCounters(void);
+
+    // Bridge firmware, probed in begin(). 0 if it predates the query.
+    uint8_t version(void) { return _version; };
+    uint8_t capabilities(void) { return _capabilities; };
+    // Bytes moved per I2C read/write, negotiated with the bridge in begin()
+    uint8_t chunkSize(void) { return _chunkSize; };
+
+    // Discovery -- fill addresses with every bridge answering between
+    // 0x08 and 0x77. Other devices are only addressed and read, never
+    // written to. Bridges on older firmware are only found at
+    // QWIIC_BLUETOOTH_DEFAULT_ADDRESS and QWIIC_BLUETOOTH_JUMPED_ADDRESS.
+    // Returns the number found.
+    static uint8_t scan(TwoWire &wirePort, uint8_t * addresses, uint8_t maxAddresses);
+    // Move this bridge to a new address. HM1X_ERROR_INVALID if the address
+    // is in use.
+    HM1X_error_t changeAddress(uint8_t address);
+    uint8_t address(void) { return _address; };
+
+    // Fault handling
+    // Failed transactions are retried, and a bus held low by a confused
+    // slave is freed by clocking SCL. Pins default to the board's SDA/SCL.
+    void setRecoveryPins(int sdaPin, int sclPin) { _sdaPin = sdaPin; _sclPin = sclPin; };
+    uint32_t errors(void) { return _errors; };         // Failed attempts
+    uint32_t failures(void) { return _failures; };     // Gave up after retries
+    uint32_t busRecoveries(void) { return _recoveries; };
+
+    // Bus speed
+    // The bridge is tested at the requested clock and stepped down (Fast-mode
+    // Plus, Fast-mode, Standard) until it passes. Returns HM1X_SUCCESS at the
+    // requested clock, HM1X_ERROR_READ_ERROR if a slower one was needed.
+    HM1X_error_t setClock(uint32_t clock);
+    uint32_t clock(void) { return _clock; };
+    // Payload bytes moved per second of bus time, since the counters were cleared
+    uint32_t bytesPerSecond(void);
+
+private:
+    TwoWire * _wirePort;
+    uint8_t _address;
+    // Bytes already clocked over the bus but not yet read by the application
+    uint8_t _rxBuffer[HM1X_I2C_RX_BUFFER_SIZE];
+    uint8_t _rxIndex;
+    uint8_t _rxCount;
+    // Last byte count reported by the bridge, less what we've read since
+    int _remoteCount;
+    unsigned long _lastPoll;
+    uint16_t _pollInterval;
+    uint32_t _transactions;
+    uint32_t _busBytes;
+    uint8_t _version;
+    uint8_t _capabilities;
+    uint8_t _chunkSize;
+    int _intPin;
+    int _sdaPin;
+    int _sclPin;
+    uint32_t _errors;
+    uint32_t _failures;
+    uint32_t _recoveries;
+    uint32_t _clock;
+    uint32_t _payloadBytes;
+    uint64_t _busMicros;  // 32 bits would wrap after 71 minutes on the bus
+
+    boolean transaction(uint8_t command, const uint8_t * args, uint8_t argLength, uint8_t * dest, uint8_t destLength);
+    boolean exchange(uint8_t command, const uint8_t * args, uint8_t argLength, uint8_t * dest, uint8_t destLength);
+    boolean verifyClock(void);
+    void fault(void);
+    void recoverBus(void);
+    int readRefill(void);
+    int remoteAvailable(void);
+    uint8_t fillRxBuffer(void);
+    uint8_t fusedRead(void);
+    void probe(void);
+    void setAddress(uint8_t address);
+};
+#endif
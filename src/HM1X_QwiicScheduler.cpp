@@ -0,0 +1,149 @@
+/*
+  Multi-module Qwiic bus scheduler for the SparkFun HM1X Bluetooth Arduino Library
+
+  See HM1X_QwiicScheduler.h for usage.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <HM1X_QwiicScheduler.h>
+
+#ifdef HM1X_I2C_ENABLED
+
+HM1X_QwiicScheduler::HM1X_QwiicScheduler()
+{
+    _numDevices = 0;
+    _next = 0;
+    _callback = NULL;
+    _callbackContext = NULL;
+}
+
+int8_t HM1X_QwiicScheduler::add(HM1X_BT & bt, uint8_t budget)
+{
+    if ((_numDevices >= HM1X_SCHEDULER_MAX_DEVICES) ||
+        !bt.qwiicBridge().attached() || bt.polling())
+    {
+        return -1;
+    }
+
+    _devices[_numDevices].bt = &bt;
+    _devices[_numDevices].budget = clampBudget(&bt, budget);
+    _devices[_numDevices].busTime = 0;
+    _devices[_numDevices].transactions = 0;
+
+    return _numDevices++;
+}
+
+void HM1X_QwiicScheduler::setBudget(uint8_t device, uint8_t budget)
+{
+    if (device < _numDevices)
+    {
+        _devices[device].budget = clampBudget(_devices[device].bt, budget);
+    }
+}
+
+void HM1X_QwiicScheduler::onData(HM1X_data_callback_t callback, void * context)
+{
+    _callback = callback;
+    _callbackContext = context;
+}
+
+void HM1X_QwiicScheduler::service(void)
+{
+    if (_numDevices == 0)
+    {
+        return;
+    }
+
+    for (uint8_t i = 0; i < _numDevices; i++)
+    {
+        serviceDevice((_next + i) % _numDevices);
+    }
+    _next = (_next + 1) % _numDevices;
+}
+
+HM1X_BT * HM1X_QwiicScheduler::device(uint8_t device)
+{
+    if (device >= _numDevices)
+    {
+        return NULL;
+    }
+    return _devices[device].bt;
+}
+
+uint64_t HM1X_QwiicScheduler::busTime(uint8_t device)
+{
+    if (device >= _numDevices)
+    {
+        return 0;
+    }
+    return _devices[device].busTime;
+}
+
+uint32_t HM1X_QwiicScheduler::busTransactions(uint8_t device)
+{
+    if (device >= _numDevices)
+    {
+        return 0;
+    }
+    return _devices[device].transactions;
+}
+
+void HM1X_QwiicScheduler::clearBusTime(void)
+{
+    for (uint8_t i = 0; i < _numDevices; i++)
+    {
+        _devices[i].busTime = 0;
+        _devices[i].transactions = 0;
+    }
+}
+
+void HM1X_QwiicScheduler::serviceDevice(uint8_t device)
+{
+    HM1X_scheduled_device_t * dev = &_devices[device];
+    HM1X_QwiicBridge & bridge = dev->bt->qwiicBridge();
+    uint8_t buffer[HM1X_I2C_MAX_CHUNK];
+    uint32_t startTransactions = bridge.transactions();
+    uint64_t startMicros = bridge.busMicros();
+    uint32_t used = 0;
+
+    // poll() reads the bridge into its own buffer -- leave it alone
+    if (dev->bt->polling())
+    {
+        return;
+    }
+
+    // Pull a chunk at a time until the module is drained or out of budget.
+    // The bridge won't start a transaction past what's left of it.
+    while (used < dev->budget)
+    {
+        size_t len = bridge.readBytes(buffer, bridge.chunkSize(), (uint8_t) (dev->budget - used));
+        used = bridge.transactions() - startTransactions;
+
+        if (len == 0)
+        {
+            break;
+        }
+        if (_callback != NULL)
+        {
+            _callback(device, buffer, (uint8_t) len, _callbackContext);
+        }
+    }
+    dev->busTime += bridge.busMicros() - startMicros;
+    dev->transactions += used;
+}
+
+// Too small a budget could never refill the bridge's cache
+uint8_t HM1X_QwiicScheduler::clampBudget(HM1X_BT * bt, uint8_t budget)
+{
+    uint8_t least = bt->qwiicBridge().refillTransactions();
+
+    return (budget > least) ? budget : least;
+}
+
+#endif
@@ -0,0 +1,78 @@
+/*
+  Multi-module Qwiic bus scheduler for the SparkFun HM1X Bluetooth Arduino Library
+
+  Services several Qwiic Bluetooth bridges sharing one TwoWire bus.
+  Each call to service() visits every module once, round-robin, and lets
+  it start at most its budget of I2C transactions -- the bridge checks the
+  budget before each one. Received data is handed to a callback, so a
+  chatty module can't hold the bus and starve the rest. Bus time spent in
+  each module's transactions is accumulated for budgeting.
+
+  Use HM1X_BT::scanI2c() to find bridges and HM1X_BT::changeI2cAddress()
+  to give each one a unique address before adding them here. Modules
+  handed to the scheduler shouldn't also be read with available()/read()
+  -- that would bypass the budgets -- or set up with setupPoll(), which
+  reads the bridge itself.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "SparkFun_HM1X_Bluetooth_Arduino_Library.h"
+
+#ifdef HM1X_I2C_ENABLED
+
+#define HM1X_SCHEDULER_MAX_DEVICES 8
+
+class HM1X_QwiicScheduler {
+public:
+    // Data received from module number "device" (the index add() returned)
+    typedef void (*HM1X_data_callback_t)(uint8_t device, const uint8_t * data, uint8_t length, void * context);
+
+    HM1X_QwiicScheduler();
+
+    // Add a Qwiic module that has already been through begin(). budget is
+    // the number of I2C transactions it may use per round, at least one
+    // refill of its bridge's cache. Returns the device index, or -1 if the
+    // scheduler is full or the module isn't on Qwiic or is polling.
+    int8_t add(HM1X_BT & bt, uint8_t budget = 2);
+    void setBudget(uint8_t device, uint8_t budget);
+    void onData(HM1X_data_callback_t callback, void * context = NULL);
+
+    // Run one round over every module
+    void service(void);
+
+    uint8_t devices(void) { return _numDevices; };
+    HM1X_BT * device(uint8_t device);
+
+    // Per-module bus usage since the last clearBusTime()
+    uint64_t busTime(uint8_t device); // microseconds
+    uint32_t busTransactions(uint8_t device);
+    void clearBusTime(void);
+
+private:
+    typedef struct {
+        HM1X_BT * bt;
+        uint8_t budget;
+        uint64_t busTime;
+        uint32_t transactions;
+    } HM1X_scheduled_device_t;
+
+    HM1X_scheduled_device_t _devices[HM1X_SCHEDULER_MAX_DEVICES];
+    uint8_t _numDevices;
+    uint8_t _next; // First module of the next round, so nobody is always last
+
+    HM1X_data_callback_t _callback;
+    void * _callbackContext;
+
+    void serviceDevice(uint8_t device);
+    static uint8_t clampBudget(HM1X_BT * bt, uint8_t budget);
+};
+
+#endif
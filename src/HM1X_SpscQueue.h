@@ -0,0 +1,121 @@
+/*
+  Lock-free single-producer/single-consumer queue for the SparkFun HM1X
+  Bluetooth Arduino Library
+
+  A fixed ring of Size entries (a power of two). One thread pushes and one
+  thread pops. Neither side ever waits: push() fails when the ring is full
+  and pop() fails when it's empty. Each index is written by one side only
+  and published with release/acquire ordering, so no lock is needed.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "HM1X_Config.h"
+
+#ifdef HM1X_THREADS_ENABLED
+
+#include <atomic>
+
+template <typename T, size_t Size>
+class HM1X_SpscQueue {
+    static_assert((Size & (Size - 1)) == 0, "HM1X_SpscQueue size must be a power of two");
+
+public:
+    HM1X_SpscQueue() : _head(0), _tail(0) {};
+
+    // Producer side
+    boolean push(const T & item)
+    {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+
+        if (tail - _head.load(std::memory_order_acquire) >= Size)
+        {
+            return false;
+        }
+        _items[tail & (Size - 1)] = item;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    };
+    // Push as many as fit, returns the number pushed
+    size_t push(const T * items, size_t count)
+    {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        size_t room = Size - (tail - _head.load(std::memory_order_acquire));
+
+        if (count > room)
+        {
+            count = room;
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            _items[(tail + i) & (Size - 1)] = items[i];
+        }
+        _tail.store(tail + count, std::memory_order_release);
+        return count;
+    };
+
+    // Consumer side
+    boolean pop(T & item)
+    {
+        size_t head = _head.load(std::memory_order_relaxed);
+
+        if (head == _tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        item = _items[head & (Size - 1)];
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    };
+    // Pop up to count, returns the number popped
+    size_t pop(T * items, size_t count)
+    {
+        size_t head = _head.load(std::memory_order_relaxed);
+        size_t waiting = _tail.load(std::memory_order_acquire) - head;
+
+        if (count > waiting)
+        {
+            count = waiting;
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            items[i] = _items[(head + i) & (Size - 1)];
+        }
+        _head.store(head + count, std::memory_order_release);
+        return count;
+    };
+    // First entry, without removing it -- consumer side only
+    const T * peek(void)
+    {
+        size_t head = _head.load(std::memory_order_relaxed);
+
+        if (head == _tail.load(std::memory_order_acquire))
+        {
+            return NULL;
+        }
+        return &_items[head & (Size - 1)];
+    };
+
+    // Either side -- a snapshot, may be stale by the time it's used
+    size_t size(void)
+    {
+        size_t head = _head.load(std::memory_order_acquire); // Head first, so it can't pass tail
+
+        return _tail.load(std::memory_order_acquire) - head;
+    };
+    size_t capacity(void) { return Size; };
+
+private:
+    T _items[Size];
+    std::atomic<size_t> _head; // Next to pop, written by the consumer
+    std::atomic<size_t> _tail; // Next to push, written by the producer
+};
+
+#endif
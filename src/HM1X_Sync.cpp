@@ -0,0 +1,143 @@
+/*
+  Locks and signals for the SparkFun HM1X Bluetooth Arduino Library
+
+  See HM1X_Sync.h.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <HM1X_Sync.h>
+
+#ifdef HM1X_THREADS_ENABLED
+
+#ifdef HM1X_FREERTOS_ENABLED
+
+static TickType_t syncTicks(uint32_t timeout)
+{
+    return (timeout == HM1X_WAIT_FOREVER) ? portMAX_DELAY : pdMS_TO_TICKS(timeout);
+}
+
+HM1X_Mutex::HM1X_Mutex()
+{
+#ifdef HM1X_NO_HEAP
+    _handle = xSemaphoreCreateMutexStatic(&_storage);
+#else
+    _handle = xSemaphoreCreateMutex();
+#endif
+}
+
+HM1X_Mutex::~HM1X_Mutex()
+{
+    vSemaphoreDelete(_handle);
+}
+
+boolean HM1X_Mutex::lock(uint32_t timeout)
+{
+    return xSemaphoreTake(_handle, syncTicks(timeout)) == pdTRUE;
+}
+
+void HM1X_Mutex::unlock(void)
+{
+    xSemaphoreGive(_handle);
+}
+
+HM1X_Signal::HM1X_Signal()
+{
+#ifdef HM1X_NO_HEAP
+    _handle = xSemaphoreCreateBinaryStatic(&_storage);
+#else
+    _handle = xSemaphoreCreateBinary();
+#endif
+}
+
+HM1X_Signal::~HM1X_Signal()
+{
+    vSemaphoreDelete(_handle);
+}
+
+void HM1X_Signal::give(void)
+{
+    xSemaphoreGive(_handle); // Fails harmlessly if already given
+}
+
+boolean HM1X_Signal::take(uint32_t timeout)
+{
+    return xSemaphoreTake(_handle, syncTicks(timeout)) == pdTRUE;
+}
+
+#else
+
+HM1X_Mutex::HM1X_Mutex() : _locked(false)
+{
+}
+
+HM1X_Mutex::~HM1X_Mutex()
+{
+}
+
+boolean HM1X_Mutex::lock(uint32_t timeout)
+{
+    std::unique_lock<std::mutex> guard(_mutex);
+
+    if (timeout == HM1X_WAIT_FOREVER)
+    {
+        _condition.wait(guard, [this] { return !_locked; });
+    }
+    else if (!_condition.wait_for(guard, std::chrono::milliseconds(timeout), [this] { return !_locked; }))
+    {
+        return false;
+    }
+    _locked = true;
+    return true;
+}
+
+void HM1X_Mutex::unlock(void)
+{
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        _locked = false;
+    }
+    _condition.notify_one();
+}
+
+HM1X_Signal::HM1X_Signal() : _given(false)
+{
+}
+
+HM1X_Signal::~HM1X_Signal()
+{
+}
+
+void HM1X_Signal::give(void)
+{
+    {
+        std::lock_guard<std::mutex> guard(_mutex);
+        _given = true;
+    }
+    _condition.notify_one();
+}
+
+boolean HM1X_Signal::take(uint32_t timeout)
+{
+    std::unique_lock<std::mutex> guard(_mutex);
+
+    if (timeout == HM1X_WAIT_FOREVER)
+    {
+        _condition.wait(guard, [this] { return _given; });
+    }
+    else if (!_condition.wait_for(guard, std::chrono::milliseconds(timeout), [this] { return _given; }))
+    {
+        return false;
+    }
+    _given = false;
+    return true;
+}
+
+#endif
+
+#endif
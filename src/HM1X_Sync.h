@@ -0,0 +1,107 @@
+/*
+  Locks and signals for the SparkFun HM1X Bluetooth Arduino Library
+
+  The two primitives HM1X_Threaded needs, on FreeRTOS semaphores or, on a
+  Linux host, std::mutex and std::condition_variable:
+    - HM1X_Mutex: one task at a time. On FreeRTOS it inherits priority,
+      so a low-priority holder can't stall a high-priority waiter.
+    - HM1X_Signal: a binary semaphore. One thread give()s, another
+      sleeps in take() until it does. Gives don't count -- several before
+      a take() wake it once.
+
+  Timeouts are in ms of the OS clock (ticks on FreeRTOS), not HM1X_Clock.
+
+  With HM1X_NO_HEAP, the FreeRTOS semaphores are created in static storage
+  (needs configSUPPORT_STATIC_ALLOCATION, which the ESP32 core sets).
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "HM1X_Config.h"
+
+#ifdef HM1X_THREADS_ENABLED
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#elif defined(HM1X_FREERTOS_ENABLED)
+#include <FreeRTOS.h>
+#include <semphr.h>
+#else
+#include <mutex>
+#include <condition_variable>
+#endif
+
+#define HM1X_WAIT_FOREVER 0xFFFFFFFF
+
+class HM1X_Mutex {
+public:
+    HM1X_Mutex();
+    ~HM1X_Mutex();
+
+    // Returns false if another thread still holds it after timeout ms
+    boolean lock(uint32_t timeout = HM1X_WAIT_FOREVER);
+    void unlock(void);
+
+private:
+#ifdef HM1X_FREERTOS_ENABLED
+    SemaphoreHandle_t _handle;
+#ifdef HM1X_NO_HEAP
+    StaticSemaphore_t _storage;
+#endif
+#else
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    bool _locked;
+#endif
+
+    HM1X_Mutex(const HM1X_Mutex &);
+    HM1X_Mutex & operator=(const HM1X_Mutex &);
+};
+
+// Holds a mutex until the end of the scope
+class HM1X_MutexLock {
+public:
+    HM1X_MutexLock(HM1X_Mutex & mutex) : _mutex(mutex) { _mutex.lock(); };
+    ~HM1X_MutexLock() { _mutex.unlock(); };
+
+private:
+    HM1X_Mutex & _mutex;
+
+    HM1X_MutexLock(const HM1X_MutexLock &);
+    HM1X_MutexLock & operator=(const HM1X_MutexLock &);
+};
+
+class HM1X_Signal {
+public:
+    HM1X_Signal();
+    ~HM1X_Signal();
+
+    void give(void);
+    // Sleep until give(), or timeout ms. 0 just checks.
+    boolean take(uint32_t timeout = HM1X_WAIT_FOREVER);
+
+private:
+#ifdef HM1X_FREERTOS_ENABLED
+    SemaphoreHandle_t _handle;
+#ifdef HM1X_NO_HEAP
+    StaticSemaphore_t _storage;
+#endif
+#else
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    bool _given;
+#endif
+
+    HM1X_Signal(const HM1X_Signal &);
+    HM1X_Signal & operator=(const HM1X_Signal &);
+};
+
+#endif
@@ -0,0 +1,302 @@
+/*
+  Threaded mode for the SparkFun HM1X Bluetooth Arduino Library
+
+  See HM1X_Threaded.h.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <HM1X_Threaded.h>
+
+#ifdef HM1X_THREADS_ENABLED
+
+// Notifications and command responses all start with this
+const char HM1X_THREADED_OK_PREFIX[] = "OK+";
+const size_t HM1X_THREADED_OK_PREFIX_LENGTH = 3;
+
+HM1X_Threaded::HM1X_Threaded(HM1X_Core & bt) :
+    _bt(bt), _connectedBle(false), _connectedEdr(false), _overflows(0),
+    _messageLength(0), _lastRx(0), _commandSent(0), _lastTx(0), _commandState(COMMAND_IDLE),
+    _commandTimeout(HM1X_THREADED_COMMAND_TIMEOUT), _commandError(HM1X_SUCCESS)
+{
+    _bleAddress[0] = 0;
+    _edrAddress[0] = 0;
+}
+
+HM1X_error_t HM1X_Threaded::begin(void)
+{
+    char address[HM1X_ADDRESS_LENGTH + 1];
+
+    _bt.connectedBleAddress(address);
+    setLink(true, _bt.connectedBle(), address);
+    _bt.connectedEdrAddress(address);
+    setLink(false, _bt.connectedEdr(), address);
+    return _bt.notify(true, true);
+}
+
+int HM1X_Threaded::read(void)
+{
+    uint8_t c;
+
+    if (!_rx.pop(c))
+    {
+        return -1;
+    }
+    return c;
+}
+
+boolean HM1X_Threaded::waitAvailable(uint16_t timeout)
+{
+    if (available() > 0)
+    {
+        return true;
+    }
+    _dataReady.take(0); // Drop a signal for data already read
+    if (available() > 0)
+    {
+        return true;
+    }
+    _dataReady.take(timeout);
+    return available() > 0;
+}
+
+boolean HM1X_Threaded::waitEvent(HM1X_link_event_t & event, uint16_t timeout)
+{
+    if (_events.pop(event))
+    {
+        return true;
+    }
+    _eventReady.take(0); // Drop a signal for an event already read
+    if (_events.pop(event))
+    {
+        return true;
+    }
+    _eventReady.take(timeout);
+    return _events.pop(event);
+}
+
+size_t HM1X_Threaded::write(const uint8_t * buffer, size_t size)
+{
+    HM1X_MutexLock lock(_txLock);
+
+    return _tx.push(buffer, size);
+}
+
+boolean HM1X_Threaded::writeAtomic(const uint8_t * buffer, size_t size)
+{
+    HM1X_MutexLock lock(_txLock);
+
+    // Only writers fill _tx, and they take turns -- the room can only grow
+    if (_tx.capacity() - _tx.size() < size)
+    {
+        return false;
+    }
+    return _tx.push(buffer, size) == size;
+}
+
+void HM1X_Threaded::connectedBleAddress(char * address)
+{
+    HM1X_MutexLock lock(_stateLock);
+
+    strcpy(address, _bleAddress);
+}
+
+void HM1X_Threaded::connectedEdrAddress(char * address)
+{
+    HM1X_MutexLock lock(_stateLock);
+
+    strcpy(address, _edrAddress);
+}
+
+HM1X_error_t HM1X_Threaded::command(const char * command, char * response, size_t size, uint16_t timeout)
+{
+    uint8_t state;
+    HM1X_error_t err;
+
+    if (strlen(command) >= HM1X_THREADED_COMMAND_SIZE)
+    {
+        return HM1X_ERROR_ER;
+    }
+    if (!_commandLock.lock(timeout))
+    {
+        return HM1X_ERROR_TRY_LATER; // Another thread's command is still in flight
+    }
+    strcpy(_command, command);
+    _commandTimeout = timeout;
+    _commandDone.take(0); // Drop a signal left by a command that timed out
+    _commandState.store(COMMAND_QUEUED, std::memory_order_release);
+
+    while (_commandState.load(std::memory_order_acquire) != COMMAND_DONE)
+    {
+        if (!_commandDone.take(timeout))
+        {
+            // Take it back if the receive thread never picked it up. Once
+            // it's been sent, the receive thread times it out for us.
+            state = COMMAND_QUEUED;
+            if (_commandState.compare_exchange_strong(state, COMMAND_IDLE, std::memory_order_acq_rel))
+            {
+                _commandLock.unlock();
+                return HM1X_ERROR_TIMEOUT;
+            }
+        }
+    }
+
+    err = _commandError;
+    if ((response != NULL) && (size > 0))
+    {
+        strncpy(response, _response, size - 1);
+        response[size - 1] = 0;
+    }
+    _commandState.store(COMMAND_IDLE, std::memory_order_release);
+    _commandLock.unlock();
+    return err;
+}
+
+void HM1X_Threaded::service(void)
+{
+    uint8_t buffer[32];
+    size_t count;
+    uint8_t state = _commandState.load(std::memory_order_acquire);
+
+    // Application data out -- unless a command is waiting or on the wire,
+    // when the module would take the two for one
+    if ((state != COMMAND_QUEUED) && (state != COMMAND_SENT))
+    {
+        while ((count = _tx.pop(buffer, sizeof(buffer))) > 0)
+        {
+            _bt.write((const char *) buffer, count);
+            _lastTx = HM1X_Clock::now();
+        }
+    }
+
+    // Don't send a command into the middle of a message -- its response
+    // would be mixed up with it -- or straight after data
+    state = COMMAND_QUEUED;
+    if ((_messageLength == 0) && (HM1X_Clock::elapsed(_lastTx) >= HM1X_THREADED_MESSAGE_GAP) &&
+        _commandState.compare_exchange_strong(state, COMMAND_SENT, std::memory_order_acq_rel))
+    {
+        _bt.print("AT");
+        if (strlen(_command) > 0)
+        {
+            _bt.print("+");
+            _bt.print(_command);
+        }
+        _commandSent = HM1X_Clock::now();
+    }
+
+    while (_bt.available() > 0)
+    {
+        _message[_messageLength++] = _bt.read();
+        _lastRx = HM1X_Clock::now();
+
+        // Pass data straight through unless it could be a notification
+        // or the response we're waiting for
+        if ((_commandState.load(std::memory_order_relaxed) != COMMAND_SENT) &&
+            (strncmp(_message, HM1X_THREADED_OK_PREFIX,
+                     (_messageLength < HM1X_THREADED_OK_PREFIX_LENGTH) ? _messageLength : HM1X_THREADED_OK_PREFIX_LENGTH) != 0))
+        {
+            deliver((const uint8_t *) _message, _messageLength);
+            _messageLength = 0;
+        }
+        else if (_messageLength >= HM1X_THREADED_MESSAGE_SIZE)
+        {
+            dispatch();
+        }
+    }
+
+    if ((_messageLength > 0) && (HM1X_Clock::elapsed(_lastRx) >= HM1X_THREADED_MESSAGE_GAP))
+    {
+        dispatch();
+    }
+    else if ((_messageLength == 0) &&
+             (_commandState.load(std::memory_order_relaxed) == COMMAND_SENT) &&
+             (HM1X_Clock::elapsed(_commandSent) >= _commandTimeout))
+    {
+        _response[0] = 0;
+        _commandError = HM1X_ERROR_TIMEOUT;
+        _commandState.store(COMMAND_DONE, std::memory_order_release);
+        _commandDone.give();
+    }
+}
+
+// Classify a complete message
+void HM1X_Threaded::dispatch(void)
+{
+    HM1X_link_event_t event;
+
+    _message[_messageLength] = 0;
+    event.type = HM1X_Core::parseNotification(_message, event.address);
+
+    if (event.type != HM1X_Core::HM1X_NOTIFY_NONE)
+    {
+        if ((event.type == HM1X_Core::HM1X_NOTIFY_CONNECT_BLE) ||
+            (event.type == HM1X_Core::HM1X_NOTIFY_DISCONNECT_BLE))
+        {
+            setLink(true, event.type == HM1X_Core::HM1X_NOTIFY_CONNECT_BLE, event.address);
+        }
+        else if ((event.type == HM1X_Core::HM1X_NOTIFY_CONNECT_EDR) ||
+                 (event.type == HM1X_Core::HM1X_NOTIFY_DISCONNECT_EDR))
+        {
+            setLink(false, event.type == HM1X_Core::HM1X_NOTIFY_CONNECT_EDR, event.address);
+        }
+        if (_events.push(event))
+        {
+            _eventReady.give();
+        }
+        else
+        {
+            _overflows.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    else if (_commandState.load(std::memory_order_relaxed) == COMMAND_SENT)
+    {
+        strncpy(_response, _message, HM1X_THREADED_RESPONSE_SIZE - 1);
+        _response[HM1X_THREADED_RESPONSE_SIZE - 1] = 0;
+        _commandError = HM1X_SUCCESS;
+        _commandState.store(COMMAND_DONE, std::memory_order_release);
+        _commandDone.give();
+    }
+    else
+    {
+        deliver((const uint8_t *) _message, _messageLength);
+    }
+    _messageLength = 0;
+}
+
+// Never waits -- whatever doesn't fit is dropped and counted
+void HM1X_Threaded::deliver(const uint8_t * data, size_t size)
+{
+    size_t pushed = _rx.push(data, size);
+
+    if (pushed > 0)
+    {
+        _dataReady.give();
+    }
+    if (pushed < size)
+    {
+        _overflows.fetch_add(size - pushed, std::memory_order_relaxed);
+    }
+}
+
+void HM1X_Threaded::setLink(boolean ble, boolean connected, const char * address)
+{
+    HM1X_MutexLock lock(_stateLock);
+    char * peer = ble ? _bleAddress : _edrAddress;
+
+    if (connected)
+    {
+        snprintf(peer, HM1X_ADDRESS_LENGTH + 1, "%s", address);
+    }
+    else
+    {
+        peer[0] = 0;
+    }
+    (ble ? _connectedBle : _connectedEdr).store(connected, std::memory_order_release);
+}
+
+#endif
@@ -0,0 +1,164 @@
+/*
+  Threaded mode for the SparkFun HM1X Bluetooth Arduino Library
+
+  Splits a module between a receive thread, which owns the port, and the
+  application. The receive thread calls service() in a loop. It drains
+  the port, splits the input into messages, and hands them over through
+  lock-free single-producer/single-consumer queues:
+    - received data -> available()/read()
+    - connect/disconnect notifications -> event()
+  Application data goes the other way through write(). AT commands use a
+  single-slot channel: command() takes its turn on a mutex, then sleeps
+  until the receive thread signals the reply. Queued data is held back
+  while a command is on the wire, and a command waits for a quiet gap
+  after data, so the module never sees the two run together.
+
+  The receive thread never waits on the application, beyond copying a
+  peer's address under a lock. If a queue is full, the data is dropped and
+  counted in overflows().
+
+  On FreeRTOS (ESP32, or -DHM1X_FREERTOS), the locks and waits are
+  FreeRTOS semaphores -- a waiting task sleeps. On Linux they're
+  std::mutex and std::condition_variable, for std::thread.
+
+    HM1X_BT bt;
+    HM1X_Threaded threaded(bt);
+
+    bt.begin(Serial1, 9600);
+    threaded.begin();
+    // receive task / thread:
+    while (1) { threaded.service(); delay(1); }
+    // application task / thread:
+    if (threaded.waitAvailable(1000)) Serial.write(threaded.read());
+
+  After begin(), use only the HM1X_Threaded interface -- calling bt's own
+  methods would race the receive thread.
+  Any number of threads can write(), send commands and read the
+  connection state. Use one application thread for read()/event() and
+  the waits on them.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "SparkFun_HM1X_Bluetooth_Arduino_Library.h"
+#include "HM1X_SpscQueue.h"
+#include "HM1X_Sync.h"
+
+#ifdef HM1X_THREADS_ENABLED
+
+#ifndef HM1X_THREADED_RX_QUEUE_SIZE
+#define HM1X_THREADED_RX_QUEUE_SIZE 512 // Power of two
+#endif
+#ifndef HM1X_THREADED_TX_QUEUE_SIZE
+#define HM1X_THREADED_TX_QUEUE_SIZE 256 // Power of two
+#endif
+#ifndef HM1X_THREADED_EVENT_QUEUE_SIZE
+#define HM1X_THREADED_EVENT_QUEUE_SIZE 8 // Power of two
+#endif
+#define HM1X_THREADED_MESSAGE_SIZE 64 // Longest message classified as a whole
+#define HM1X_THREADED_MESSAGE_GAP 10 // ms of silence that ends a message
+#define HM1X_THREADED_COMMAND_SIZE 32
+#define HM1X_THREADED_RESPONSE_SIZE 64
+#define HM1X_THREADED_COMMAND_TIMEOUT 100
+
+class HM1X_Threaded {
+public:
+    typedef struct {
+        HM1X_Core::HM1X_notification_t type;
+        char address[HM1X_ADDRESS_LENGTH + 1];
+    } HM1X_link_event_t;
+
+    HM1X_Threaded(HM1X_Core & bt);
+
+    // Call after bt.begin(), before starting the receive thread. Turns on
+    // connect/disconnect notifications.
+    HM1X_error_t begin(void);
+
+    // Receive thread
+    void service(void);
+
+    // Application -- one reader
+    int available(void) { return _rx.size(); };
+    int read(void);
+    size_t read(uint8_t * buffer, size_t size) { return _rx.pop(buffer, size); };
+    boolean event(HM1X_link_event_t & event) { return _events.pop(event); };
+    // Sleep until there's data or an event, or timeout ms
+    boolean waitAvailable(uint16_t timeout);
+    boolean waitEvent(HM1X_link_event_t & event, uint16_t timeout);
+
+    // Application -- any thread
+    // Queue data for the module. Returns how much fit.
+    size_t write(const uint8_t * buffer, size_t size);
+    // All of it or, if it won't fit, none -- records from several threads
+    // reach the module whole
+    boolean writeAtomic(const uint8_t * buffer, size_t size);
+    // Send "AT+<command>" ("AT" if empty) and sleep until the response.
+    // Waits up to timeout for another thread's command to finish first,
+    // then gives up with HM1X_ERROR_TRY_LATER.
+    HM1X_error_t command(const char * command, char * response, size_t size,
+                         uint16_t timeout = HM1X_THREADED_COMMAND_TIMEOUT);
+
+    // Any thread
+    boolean connected(void) { return connectedBle() || connectedEdr(); };
+    boolean connectedBle(void) { return _connectedBle.load(std::memory_order_acquire); };
+    boolean connectedEdr(void) { return _connectedEdr.load(std::memory_order_acquire); };
+    // Peer's address, empty if not connected. address holds HM1X_ADDRESS_LENGTH + 1.
+    void connectedBleAddress(char * address);
+    void connectedEdrAddress(char * address);
+    // Bytes and events dropped because the application fell behind
+    uint32_t overflows(void) { return _overflows.load(std::memory_order_relaxed); };
+
+private:
+    typedef enum {
+        COMMAND_IDLE,    // No command
+        COMMAND_QUEUED,  // Waiting for the receive thread to send it
+        COMMAND_SENT,    // Waiting for the module's response
+        COMMAND_DONE     // Response (or error) ready for command()
+    } command_state_t;
+
+    HM1X_Core & _bt;
+    HM1X_SpscQueue<uint8_t, HM1X_THREADED_RX_QUEUE_SIZE> _rx;
+    HM1X_SpscQueue<uint8_t, HM1X_THREADED_TX_QUEUE_SIZE> _tx;
+    HM1X_SpscQueue<HM1X_link_event_t, HM1X_THREADED_EVENT_QUEUE_SIZE> _events;
+    std::atomic<bool> _connectedBle;
+    std::atomic<bool> _connectedEdr;
+    std::atomic<uint32_t> _overflows;
+    HM1X_Signal _dataReady;
+    HM1X_Signal _eventReady;
+    HM1X_Mutex _txLock; // Writers take turns pushing into _tx
+
+    // Peer addresses -- written by the receive thread, copied out by any
+    HM1X_Mutex _stateLock;
+    char _bleAddress[HM1X_ADDRESS_LENGTH + 1];
+    char _edrAddress[HM1X_ADDRESS_LENGTH + 1];
+
+    // Receive thread only
+    char _message[HM1X_THREADED_MESSAGE_SIZE + 1];
+    size_t _messageLength;
+    unsigned long _lastRx;
+    unsigned long _commandSent;
+    unsigned long _lastTx;
+
+    // Command channel -- one caller at a time holds _commandLock. Then
+    // ownership of the rest passes with _commandState.
+    HM1X_Mutex _commandLock;
+    HM1X_Signal _commandDone;
+    std::atomic<uint8_t> _commandState;
+    char _command[HM1X_THREADED_COMMAND_SIZE];
+    char _response[HM1X_THREADED_RESPONSE_SIZE];
+    uint16_t _commandTimeout;
+    HM1X_error_t _commandError;
+
+    void dispatch(void);
+    void deliver(const uint8_t * data, size_t size);
+    void setLink(boolean ble, boolean connected, const char * address);
+};
+
+#endif
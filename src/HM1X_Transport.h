@@ -0,0 +1,166 @@
+/*
+  Transport policies for HM1X_BT_T
+
+  Each policy wraps one kind of port and exposes the same small set of
+  inline operations, so HM1X_BT_T<Policy> compiles down to direct calls
+  on that port:
+    void attach(...)             -- port and settings, from HM1X_BT_T::begin()
+    unsigned long baud()         -- host baud to start at, 0 if the host has none
+    int available()
+    int read()                   -- -1 if nothing is waiting
+    size_t write(const uint8_t * buffer, size_t size)
+    Print * pacedPort()          -- port for CTS/burst pacing, NULL if it doesn't apply
+    void begin(baud, stopBits, parity) -- follow the module to a new baud/framing
+    boolean framingSupported()   -- can the host run other than 8N1?
+
+  Any class with these members can be used as a policy.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU General Public License for more details.
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "SparkFun_HM1X_Bluetooth_Arduino_Library.h"
+
+#ifdef HM1X_HARDWARE_SERIAL_ENABLED
+class HM1X_HardwareSerialTransport {
+public:
+    HM1X_HardwareSerialTransport() : _port(NULL), _baud(9600) {};
+
+    void attach(HardwareSerial & port, unsigned long baud = 9600) { _port = &port; _baud = baud; };
+    unsigned long baud(void) { return _baud; };
+
+    int available(void) { return _port->available(); };
+    int read(void) { return _port->read(); };
+    size_t write(const uint8_t * buffer, size_t size) { return _port->write(buffer, size); };
+    Print * pacedPort(void) { return _port; };
+
+    void begin(unsigned long baud, HM1X_Core::HM1X_stop_bits_t stopBits, HM1X_Core::HM1X_parity_t parity)
+    {
+        begin(*_port, baud, stopBits, parity);
+    };
+    boolean framingSupported(void) { return true; };
+
+    // (Re)start a UART with the module's framing. Drains pending output first.
+    static void begin(HardwareSerial & port, unsigned long baud,
+                      HM1X_Core::HM1X_stop_bits_t stopBits, HM1X_Core::HM1X_parity_t parity)
+    {
+        boolean twoStop = (stopBits == HM1X_Core::HM1X_STOP_BITS_2);
+
+        port.flush();
+#ifdef SERIAL_8N1
+        if (parity == HM1X_Core::HM1X_PARITY_EVEN)
+        {
+            port.begin(baud, twoStop ? SERIAL_8E2 : SERIAL_8E1);
+        }
+        else if (parity == HM1X_Core::HM1X_PARITY_ODD)
+        {
+            port.begin(baud, twoStop ? SERIAL_8O2 : SERIAL_8O1);
+        }
+        else
+        {
+            port.begin(baud, twoStop ? SERIAL_8N2 : SERIAL_8N1);
+        }
+#else
+        // Core without framing constants -- 8N1 only
+        port.begin(baud);
+#endif
+    };
+
+private:
+    HardwareSerial * _port;
+    unsigned long _baud;
+};
+#endif
+
+#ifdef HM1X_SOFTWARE_SERIAL_ENABLED
+class HM1X_SoftwareSerialTransport {
+public:
+    HM1X_SoftwareSerialTransport() : _port(NULL), _baud(9600) {};
+
+    void attach(SoftwareSerial & port, unsigned long baud = 9600) { _port = &port; _baud = baud; };
+    unsigned long baud(void) { return _baud; };
+
+    int available(void) { return _port->available(); };
+    int read(void) { return _port->read(); };
+    size_t write(const uint8_t * buffer, size_t size) { return _port->write(buffer, size); };
+    Print * pacedPort(void) { return _port; };
+
+    void begin(unsigned long baud, HM1X_Core::HM1X_stop_bits_t, HM1X_Core::HM1X_parity_t) { _port->begin(baud); };
+    boolean framingSupported(void) { return false; };
+
+private:
+    SoftwareSerial * _port;
+    unsigned long _baud;
+};
+#endif
+
+#ifdef HM1X_I2C_ENABLED
+class HM1X_WireTransport : public HM1X_QwiicBridge {
+public:
+    void attach(TwoWire & wirePort, uint8_t address = QWIIC_BLUETOOTH_DEFAULT_ADDRESS,
+                int intPin = -1, uint32_t clock = HM1X_I2C_CLOCK_STANDARD)
+    {
+        HM1X_QwiicBridge::begin(wirePort, address, intPin, clock);
+    };
+    // The bridge owns the module's UART, there's no host baud to search
+    unsigned long baud(void) { return 0; };
+
+    Print * pacedPort(void) { return NULL; };
+
+    void begin(unsigned long baud, HM1X_Core::HM1X_stop_bits_t, HM1X_Core::HM1X_parity_t)
+    {
+        HM1X_Core::HM1X_baud_t index = HM1X_Core::baudIndex(baud);
+
+        if (index != HM1X_Core::HM1X_BAUD_INVALID)
+        {
+            setModuleBaud(index);
+        }
+    };
+    boolean framingSupported(void) { return false; };
+};
+#endif
+
+// Any other Stream -- USB CDC, DMA UART drivers, etc. The port must already
+// be running at the module's baud. Pass onBaud to let the library move the
+// port to another baud rate and framing.
+class HM1X_StreamTransport {
+public:
+    HM1X_StreamTransport() : _port(NULL), _baud(0), _onBaud(NULL), _context(NULL) {};
+
+    void attach(Stream & port, unsigned long baud = 0,
+                HM1X_Core::HM1X_baud_callback_t onBaud = NULL, void * context = NULL)
+    {
+        _port = &port;
+        _baud = baud;
+        _onBaud = onBaud;
+        _context = context;
+    };
+    // Can't search for the module's baud unless we can change ours
+    unsigned long baud(void) { return (_onBaud != NULL) ? _baud : 0; };
+
+    int available(void) { return _port->available(); };
+    int read(void) { return _port->read(); };
+    size_t write(const uint8_t * buffer, size_t size) { return _port->write(buffer, size); };
+    Print * pacedPort(void) { return _port; };
+
+    void begin(unsigned long baud, HM1X_Core::HM1X_stop_bits_t stopBits, HM1X_Core::HM1X_parity_t parity)
+    {
+        if (_onBaud != NULL)
+        {
+            _onBaud(baud, stopBits, parity, _context);
+        }
+    };
+    boolean framingSupported(void) { return (_onBaud != NULL); };
+
+private:
+    Stream * _port;
+    unsigned long _baud;
+    HM1X_Core::HM1X_baud_callback_t _onBaud;
+    void * _context;
+};
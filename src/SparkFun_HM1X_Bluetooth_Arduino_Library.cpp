@@ -31,144 +31,179 @@
 
 #include <SparkFun_HM1X_Bluetooth_Arduino_Library.h>
 
+#ifdef HM1X_NO_HEAP
+// Fail the build if anything below allocates
+#pragma GCC poison malloc calloc realloc free String
+#endif
+
 #define CHECK_HM1X_CONNECTION_ON_BEGIN
 
 const int HM1X_DEFAULT_TIMEOUT = 1000;
 const int HM1X_RESPONSE_TIMEOUT = 100;
 const int HM1X_POLL_DELAY = 10;
-
-const char HM1X_COMMAND_AT[] = "AT";
-const char HM1X_COMMAND_RESET[] = "RESET";
-const char HM1X_COMMAND_FACTORY_DEFAULTS[] = "RENEW";
-const char HM1X_COMMAND_VERSION[] = "VERR";
-const char HM1X_COMMAND_INIT_NOTIFY[] = "INIT";
-const char HM1X_COMMAND_NOTIFY_INIT[] = "NOTI";
-const char HM1X_COMMAND_NOTIFY_MODE[] = "NOTP";
-const char HM1X_COMMAND_EDR_NAME[] = "NAME";
-const char HM1X_COMMAND_BLE_NAME[] = "NAMB";
-const char HM1X_COMMAND_EDR_ADR[] = "ADDE";
-const char HM1X_COMMAND_BLE_ADR[] = "ADDB";
-const char HM1X_COMMAND_LAST_EDR[] = "RADE";
-const char HM1X_COMMAND_LAST_BLE[] = "RADB";
-const char HM1X_COMMAND_CLEAR_BOND_EDR[] = "BONDE";
-const char HM1X_COMMAND_CLEAR_BOND_BLE[] = "BONDB";
-const char HM1X_COMMAND_CLEAR_ADR_EDR[] = "CLEAE";
-const char HM1X_COMMAND_CLEAR_ADR_BLE[] = "CLEAB";
-const char HM1X_COMMAND_EDR_MODE[] = "ROLE";
-const char HM1X_COMMAND_BLE_MODE[] = "ROLB";
-const char HM1X_COMMAND_HIGH_SPEED_SPP[] = "HIGH";
-const char HM1X_COMMAND_DUAL_WORK_MODE[] = "DUAL";
-const char HM1X_COMMAND_MODULE_WORK_MODE[] = "MODE";
-const char HM1X_COMMAND_A_TO_B_MODE[] = "ATOB";
-const char HM1X_COMMAND_AUTHENTICATION_MODE[] = "AUTH";
-const char HM1X_COMMAND_EDR_PIN_CODE[] = "PINE";
-const char HM1X_COMMAND_BLE_PIN_CODE[] = "PINB";
-const char HM1X_COMMAND_COD[] = "COFD";
-const char HM1X_COMMAND_UPDATE_CON_PARAM[] = "COUP";
-const char HM1X_COMMAND_IBEACON_SWITCH[] = "IBEA";
-const char HM1X_COMMAND_IBEACON_UUID[] = "IBE";
-const char HM1X_COMMAND_IBEACON_MAJOR[] = "MAJO";
-const char HM1X_COMMAND_IBEACON_MINOR[] = "MINO";
-const char HM1X_COMMAND_IBEACON_POWER[] = "MEAS";
-const char HM1X_COMMAND_MTU_SIZE[] = "MTUS";
-const char HM1X_COMMAND_ADVERT_TYPE[] = "SCAN";
-const char HM1X_COMMAND_SAFE_MODE[] = "SAFE";
-const char HM1X_COMMAND_BLE_MAC[] = "ONEM";
-const char HM1X_COMMAND_SYSTEM_KEY[] = "PIO0";
-const char HM1X_COMMAND_SYSTEM_LED[] = "PIO1";
-const char HM1X_COMMAND_PIO_STATUS[] = "PIO";
-const char HM1X_COMMAND_BLE_WORK_METHOD[] = "RESP";
-const char HM1X_COMMAND_EDR_WORK_TYPE[] = "IMME";
-const char HM1X_COMMAND_BLE_WORK_TYPE[] = "IMMB";
-const char HM1X_COMMAND_START_EDR_WORK[] = "STARE";
-const char HM1X_COMMAND_START_BLE_WORK[] = "STARB";
-const char HM1X_COMMAND_STOP_EDR_WORK[] = "STOPE";
-const char HM1X_COMMAND_STOP_BLE_WORK[] = "STOPB";
-const char HM1X_COMMAND_BAUD[] = "BAUD";
-const char HM1X_COMMAND_FLOW_CONTROL[] ="FIOW";
-const char HM1X_COMMAND_STOP_BITS[] = "STOP";
-const char HM1X_COMMAND_PARITY_BIT[] = "PARI";
-
-const char HM1X_RESPONSE_OK[] = "OK";
-const char HM1X_RESPONSE_GET[] = "+Get:";
-const char HM1X_RESPONSE_SET[] = "+Set:";
-
-const char HM1X_OK_CONN_EDR[] = "OK+CONE:";
-const char HM1X_OK_CONN_BLE[] = "OK+CONB:";
-const char HM1X_OK_DISCON_EDR[] = "OK+LSTE";
-const char HM1X_OK_DISCON_BLE[] = "OK+LSTB";
-
-const char HM1X_RESPONSE_PLUS[] = "+";
-const char HM1X_QUERY_STRING[] = "?";
+const uint8_t HM1X_COMMAND_CHUNK_LENGTH = 32; // Stack buffer sendCommand() assembles in
+const uint8_t HM1X_RESPONSE_LENGTH = 48; // Longest awaited: "OK+Set:" and a 28-character name
+
+const char HM1X_COMMAND_AT[] HM1X_PROGMEM = "AT";
+const char HM1X_COMMAND_RESET[] HM1X_PROGMEM = "RESET";
+const char HM1X_COMMAND_FACTORY_DEFAULTS[] HM1X_PROGMEM = "RENEW";
+const char HM1X_COMMAND_VERSION[] HM1X_PROGMEM = "VERR";
+const char HM1X_COMMAND_INIT_NOTIFY[] HM1X_PROGMEM = "INIT";
+const char HM1X_COMMAND_NOTIFY_INIT[] HM1X_PROGMEM = "NOTI";
+const char HM1X_COMMAND_NOTIFY_MODE[] HM1X_PROGMEM = "NOTP";
+const char HM1X_COMMAND_EDR_NAME[] HM1X_PROGMEM = "NAME";
+const char HM1X_COMMAND_BLE_NAME[] HM1X_PROGMEM = "NAMB";
+const char HM1X_COMMAND_EDR_ADR[] HM1X_PROGMEM = "ADDE";
+const char HM1X_COMMAND_BLE_ADR[] HM1X_PROGMEM = "ADDB";
+const char HM1X_COMMAND_LAST_EDR[] HM1X_PROGMEM = "RADE";
+const char HM1X_COMMAND_LAST_BLE[] HM1X_PROGMEM = "RADB";
+const char HM1X_COMMAND_CLEAR_BOND_EDR[] HM1X_PROGMEM = "BONDE";
+const char HM1X_COMMAND_CLEAR_BOND_BLE[] HM1X_PROGMEM = "BONDB";
+const char HM1X_COMMAND_CLEAR_ADR_EDR[] HM1X_PROGMEM = "CLEAE";
+const char HM1X_COMMAND_CLEAR_ADR_BLE[] HM1X_PROGMEM = "CLEAB";
+const char HM1X_COMMAND_EDR_MODE[] HM1X_PROGMEM = "ROLE";
+const char HM1X_COMMAND_BLE_MODE[] HM1X_PROGMEM = "ROLB";
+const char HM1X_COMMAND_HIGH_SPEED_SPP[] HM1X_PROGMEM = "HIGH";
+const char HM1X_COMMAND_DUAL_WORK_MODE[] HM1X_PROGMEM = "DUAL";
+const char HM1X_COMMAND_MODULE_WORK_MODE[] HM1X_PROGMEM = "MODE";
+const char HM1X_COMMAND_A_TO_B_MODE[] HM1X_PROGMEM = "ATOB";
+const char HM1X_COMMAND_AUTHENTICATION_MODE[] HM1X_PROGMEM = "AUTH";
+const char HM1X_COMMAND_EDR_PIN_CODE[] HM1X_PROGMEM = "PINE";
+const char HM1X_COMMAND_BLE_PIN_CODE[] HM1X_PROGMEM = "PINB";
+const char HM1X_COMMAND_COD[] HM1X_PROGMEM = "COFD";
+const char HM1X_COMMAND_UPDATE_CON_PARAM[] HM1X_PROGMEM = "COUP";
+const char HM1X_COMMAND_IBEACON_SWITCH[] HM1X_PROGMEM = "IBEA";
+const char HM1X_COMMAND_IBEACON_UUID[] HM1X_PROGMEM = "IBE";
+const char HM1X_COMMAND_IBEACON_MAJOR[] HM1X_PROGMEM = "MAJO";
+const char HM1X_COMMAND_IBEACON_MINOR[] HM1X_PROGMEM = "MINO";
+const char HM1X_COMMAND_IBEACON_POWER[] HM1X_PROGMEM = "MEAS";
+const char HM1X_COMMAND_MTU_SIZE[] HM1X_PROGMEM = "MTUS";
+const char HM1X_COMMAND_ADVERT_TYPE[] HM1X_PROGMEM = "SCAN";
+const char HM1X_COMMAND_SAFE_MODE[] HM1X_PROGMEM = "SAFE";
+const char HM1X_COMMAND_BLE_MAC[] HM1X_PROGMEM = "ONEM";
+const char HM1X_COMMAND_SYSTEM_KEY[] HM1X_PROGMEM = "PIO0";
+const char HM1X_COMMAND_SYSTEM_LED[] HM1X_PROGMEM = "PIO1";
+const char HM1X_COMMAND_PIO_STATUS[] HM1X_PROGMEM = "PIO";
+const char HM1X_COMMAND_BLE_WORK_METHOD[] HM1X_PROGMEM = "RESP";
+const char HM1X_COMMAND_EDR_WORK_TYPE[] HM1X_PROGMEM = "IMME";
+const char HM1X_COMMAND_BLE_WORK_TYPE[] HM1X_PROGMEM = "IMMB";
+const char HM1X_COMMAND_START_EDR_WORK[] HM1X_PROGMEM = "STARE";
+const char HM1X_COMMAND_START_BLE_WORK[] HM1X_PROGMEM = "STARB";
+const char HM1X_COMMAND_STOP_EDR_WORK[] HM1X_PROGMEM = "STOPE";
+const char HM1X_COMMAND_STOP_BLE_WORK[] HM1X_PROGMEM = "STOPB";
+const char HM1X_COMMAND_BAUD[] HM1X_PROGMEM = "BAUD";
+const char HM1X_COMMAND_FLOW_CONTROL[] HM1X_PROGMEM = "FIOW";
+const char HM1X_COMMAND_STOP_BITS[] HM1X_PROGMEM = "STOP";
+const char HM1X_COMMAND_PARITY_BIT[] HM1X_PROGMEM = "PARI";
+
+const char HM1X_RESPONSE_OK[] HM1X_PROGMEM = "OK";
+const char HM1X_RESPONSE_GET[] HM1X_PROGMEM = "+Get:";
+const char HM1X_RESPONSE_SET[] HM1X_PROGMEM = "+Set:";
+
+const char HM1X_OK_CONN_EDR[] HM1X_PROGMEM = "OK+CONE:";
+const char HM1X_OK_CONN_BLE[] HM1X_PROGMEM = "OK+CONB:";
+const char HM1X_OK_DISCON_EDR[] HM1X_PROGMEM = "OK+LSTE";
+const char HM1X_OK_DISCON_BLE[] HM1X_PROGMEM = "OK+LSTB";
+
+const char HM1X_RESPONSE_PLUS[] HM1X_PROGMEM = "+";
+const char HM1X_QUERY_STRING[] = "?"; // In RAM -- sent as a command argument
 
 const char HM1X_DISCONNECT_RESPONSE_LEN = 20;
 const uint8_t HM1X_CONNECT_LENGTH = 20;
 const uint8_t HM1X_DISCONNECT_LENGTH = 21;
 
-#ifdef HM1X_I2C_ENABLED
-typedef enum {
-  I2C_CMD_AVAILABLE, // 0
-  I2C_CMD_READ,      // 1
-  I2C_CMD_WRITE,     // 2
-  I2C_CMD_SET_BAUD,  // 3
-  I2C_SET_ADDRESS    // 4
-} qwiic_bt_commands_t;
-#endif
-
-static const long btBauds[HM1X_BT::NUM_HM1X_BAUDS] = {0, 4800, 9600, 19200, 38400, 57600, 115200, 320400};
-
-HM1X_BT::HM1X_BT(HM1X_model_t btModel)
-{
+static const long btBauds[HM1X_Core::NUM_HM1X_BAUDS] = {0, 4800, 9600, 19200, 38400, 57600, 115200, 230400};
+
+// AT+BAUD parameter for each HM1X_baud_t. 0: the model can't run at that rate.
+#define HM1X_BAUD_CODES_HM13 0
+#define HM1X_BAUD_CODES_HM10 1
+static const char btBaudCodes[][HM1X_Core::NUM_HM1X_BAUDS] = {
+    {0, '1', '2', '3', '4', '5', '6', '7'}, // HM-12/13
+    {0, '5', '0', '1', '2', '3', '4', '8'}  // HM-10/11 and the HM-16..19 BLE modules
+};
+
+// Indexed by HM1X_model_t. HM-14/15 aren't characterised, so they get the
+// full HM-13 command set and nothing is refused locally.
+static const HM1X_Core::HM1X_model_info_t btModels[HM1X_Core::NUM_HM_MODELS] = {
+    // HM-10: CC2541, PIO2..PIOB (PIO0 is the system key, PIO1 the LED)
+    {HM1X_CAP_BLE | HM1X_CAP_IBEACON | HM1X_CAP_FRAMING | HM1X_CAP_FLOW_CONTROL | HM1X_CAP_PIO | HM1X_CAP_BOND,
+     HM1X_BAUD_CODES_HM10, 0x0FFC},
+    // HM-11: CC2541, PIO2..PIO3
+    {HM1X_CAP_BLE | HM1X_CAP_IBEACON | HM1X_CAP_FRAMING | HM1X_CAP_FLOW_CONTROL | HM1X_CAP_PIO | HM1X_CAP_BOND,
+     HM1X_BAUD_CODES_HM10, 0x000C},
+    // HM-12, HM-13: dual mode
+    {HM1X_CAP_ALL, HM1X_BAUD_CODES_HM13, 0x000C},
+    {HM1X_CAP_ALL, HM1X_BAUD_CODES_HM13, 0x000C},
+    // HM-14, HM-15
+    {HM1X_CAP_ALL, HM1X_BAUD_CODES_HM13, 0x000C},
+    {HM1X_CAP_ALL, HM1X_BAUD_CODES_HM13, 0x000C},
+    // HM-16..19: CC2640/CC2642 BLE
+    {HM1X_CAP_BLE | HM1X_CAP_IBEACON | HM1X_CAP_MTU | HM1X_CAP_FRAMING | HM1X_CAP_FLOW_CONTROL | HM1X_CAP_PIO | HM1X_CAP_BOND,
+     HM1X_BAUD_CODES_HM10, 0x03FC},
+    {HM1X_CAP_BLE | HM1X_CAP_IBEACON | HM1X_CAP_MTU | HM1X_CAP_FRAMING | HM1X_CAP_FLOW_CONTROL | HM1X_CAP_PIO | HM1X_CAP_BOND,
+     HM1X_BAUD_CODES_HM10, 0x03FC},
+    {HM1X_CAP_BLE | HM1X_CAP_IBEACON | HM1X_CAP_MTU | HM1X_CAP_FRAMING | HM1X_CAP_FLOW_CONTROL | HM1X_CAP_PIO | HM1X_CAP_BOND,
+     HM1X_BAUD_CODES_HM10, 0x03FC},
+    {HM1X_CAP_BLE | HM1X_CAP_IBEACON | HM1X_CAP_MTU | HM1X_CAP_FRAMING | HM1X_CAP_FLOW_CONTROL | HM1X_CAP_PIO | HM1X_CAP_BOND,
+     HM1X_BAUD_CODES_HM10, 0x03FC}
+};
+
+// Return HM1X_ERROR_UNSUPPORTED from a command the model doesn't have.
+// HM1X_CAPABILITIES is a constant, so for a group compiled out of the build
+// the compiler drops the rest of the command.
+#define HM1X_REQUIRE(capability) \
+    if (((HM1X_CAPABILITIES & (capability)) != (capability)) || !modelSupports(capability)) \
+        return HM1X_ERROR_UNSUPPORTED
+
+HM1X_Core::HM1X_Core(HM1X_model_t btModel)
+{
+    if (btModel >= NUM_HM_MODELS)
+    {
+        btModel = HM13;
+    }
     _btModel = btModel;
+    _modelInfo = &btModels[btModel];
     
     _connectedBle = false;
     _connectedEdr = false;
-    _edrAddress = "";
-    _bleAddress = "";
-    _response = "";
+    _edrAddress[0] = 0;
+    _bleAddress[0] = 0;
+    _responseLength = 0;
+    _responseRead = 0;
 
     _polling = false;
 
+    _baud = 9600;
+    _stopBits = HM1X_STOP_BITS_1;
+    _parity = HM1X_PARITY_NONE;
+
+    _ctsPin = -1;
+    _ctsCallback = NULL;
+    _ctsContext = NULL;
+    _paceBurstSize = 0;
+    _paceBurstDelay = 0;
+}
+
+HM1X_BT::HM1X_BT(HM1X_model_t btModel) : HM1X_Core(btModel)
+{
 #ifdef HM1X_SOFTWARE_SERIAL_ENABLED
     _softSerial = NULL;
 #endif
 #ifdef HM1X_HARDWARE_SERIAL_ENABLED
     _serialPort = NULL;
 #endif
-#ifdef HM1X_I2C_ENABLED
-    _wirePort = NULL;
-    _wireAddress = 0;
-#endif
+    _stream = NULL;
+    _onBaud = NULL;
+    _onBaudContext = NULL;
 }
 
 #ifdef HM1X_SOFTWARE_SERIAL_ENABLED
 boolean HM1X_BT::begin(SoftwareSerial & softSerial, unsigned long baud)
 {
     _softSerial = &softSerial;
-    _softSerial->begin(baud);
-    
-#ifdef CHECK_HM1X_CONNECTION_ON_BEGIN
-    if( init() == HM1X_SUCCESS ) 
-    {
-        return true;
-    }
-
-    // If init() fails the first time, try forcing the baud rate to the requested baud and try again.
-    if (forceBaud(baud) == HM1X_SUCCESS)
-    {
-        reset();
-        _softSerial->begin(baud);
-        delay(5000); // Delay long enough for module to reset
-        if( init() == HM1X_SUCCESS ) 
-        {
-            return true;
-        }
-    }
+    hwBegin(baud);
 
-    return false;
-#else
-    return true;
-#endif
+    return connect(baud);
 }
 #endif
 
@@ -176,20 +211,52 @@ boolean HM1X_BT::begin(SoftwareSerial & softSerial, unsigned long baud)
 boolean HM1X_BT::begin(HardwareSerial &serialPort, unsigned long baud)
 {
     _serialPort = &serialPort;
-    _serialPort->begin(baud);
+    hwBegin(baud);
+
+    return connect(baud);
+}
+#endif
+
+#ifdef HM1X_I2C_ENABLED
+boolean HM1X_BT::begin(TwoWire & wirePort, uint8_t wireAddress, int intPin, uint32_t clock)
+{
+    _bridge.begin(wirePort, wireAddress, intPin, clock);
+
+    // The bridge sits between us and the module's UART, so there's no
+    // host-side baud to search.
+    return connect(0);
+}
+#endif
+
+boolean HM1X_BT::begin(Stream & port, unsigned long baud, HM1X_baud_callback_t onBaud, void * context)
+{
+    _stream = &port;
+    _onBaud = onBaud;
+    _onBaudContext = context;
+    _baud = baud;
+
+    // Can't search for the module's baud unless we can change ours
+    return connect((_onBaud != NULL) ? baud : 0);
+}
 
+boolean HM1X_Core::connect(unsigned long baud)
+{
 #ifdef CHECK_HM1X_CONNECTION_ON_BEGIN
     if( init() == HM1X_SUCCESS ) 
     {
         return true;
     }
+    if (baud == 0)
+    {
+        return false;
+    }
 
     // If init() fails the first time, try forcing the baud rate to the requested baud and try again.
     if (forceBaud(baud) == HM1X_SUCCESS)
     {
         reset();
-        _serialPort->begin(baud);
-        delay(5000); // Delay long enough for module to reset
+        hwBegin(baud);
+        HM1X_Clock::wait(5000); // Delay long enough for module to reset
         if( init() == HM1X_SUCCESS ) 
         {
             return true;
@@ -201,123 +268,130 @@ boolean HM1X_BT::begin(HardwareSerial &serialPort, unsigned long baud)
     return true;
 #endif
 }
-#endif
 
-#ifdef HM1X_I2C_ENABLED
-boolean HM1X_BT::begin(TwoWire & wirePort, uint8_t wireAddress)
+boolean HM1X_Core::setupPoll(void)
 {
-    _wirePort = &wirePort;
-    _wireAddress = wireAddress;
-
-    _wirePort->begin();
+    HM1X_error_t err;
+    err = notify(true, true);
 
-#ifdef CHECK_HM1X_CONNECTION_ON_BEGIN
-    //writeI2cBaud(HM1X_BAUD_9600);
-    if( init() == HM1X_SUCCESS ) 
+    if (err == HM1X_SUCCESS)
     {
+        _polling = true;
         return true;
     }
+    return false;
+}
+
+boolean HM1X_Core::poll(void)
+{
+    uint16_t start;
+    boolean handled = false;
+
+    // Move unread data to the front, then receive onto the end of it
+    if (_responseRead > 0)
+    {
+        memmove(_response, _response + _responseRead, _responseLength - _responseRead);
+        _responseLength -= _responseRead;
+        _responseRead = 0;
+    }
+    start = _responseLength;
 
-    // If we fail to initialize, try forcing the baud rate to 9600
-    // then iterate through all possible bauds, and send AT+BAUD2 command
-    /*for (uint8_t i = HM1X_BAUD_4800; i < NUM_HM1X_BAUDS; i++) 
+    // Receive serial stream, delay for a bit between charaters. If the
+    // buffer fills, the rest waits in the port for the next poll.
+    while (hwAvailable() && (_responseLength < HM1X_POLL_BUFFER_LENGTH))
     {
-        writeI2cBaud(i);
-        setBaud(HM1X_BAUD_9600);
+        _response[_responseLength++] = readChar();
+        HM1X_Clock::wait(HM1X_POLL_DELAY);
     }
-    // Then try init one more time:
-    if( init() == HM1X_SUCCESS ) 
+    _response[_responseLength] = 0;
+
+    if (_responseLength == start)
     {
-        return true;
-    }*/
+        return false;
+    }
 
-    return false;
-#else
-    return true;
-#endif
+    handled = (handleNotification(_response + start) != HM1X_NOTIFY_NONE);
+    if (handled)
+    {
+        // Notifications aren't data -- take it back off
+        _responseLength = start;
+    }
+    return handled;
 }
-#endif
 
-boolean HM1X_BT::setupPoll(void)
+HM1X_Core::HM1X_notification_t HM1X_Core::handleNotification(const char * response)
 {
-    HM1X_error_t err;
-    err = notify(true, true);
+    char address[HM1X_ADDRESS_LENGTH + 1];
+    HM1X_notification_t type = parseNotification(response, address);
 
-    if (err == HM1X_SUCCESS)
+    switch (type)
     {
-        _polling = true;
-        return true;
+    case HM1X_NOTIFY_CONNECT_EDR:
+    case HM1X_NOTIFY_DISCONNECT_EDR:
+        strcpy(_edrAddress, address);
+        _connectedEdr = (type == HM1X_NOTIFY_CONNECT_EDR);
+        break;
+    case HM1X_NOTIFY_CONNECT_BLE:
+    case HM1X_NOTIFY_DISCONNECT_BLE:
+        strcpy(_bleAddress, address);
+        _connectedBle = (type == HM1X_NOTIFY_CONNECT_BLE);
+        break;
+    default:
+        // TODO: OK+INIT -- Module restarted -- need to do anything?
+        break;
     }
-    return false;
+    return type;
 }
 
-boolean HM1X_BT::poll(void)
+HM1X_Core::HM1X_notification_t HM1X_Core::parseNotification(const char * message, char * address)
 {
-    String response = "";
-    boolean handled = false;
+    HM1X_notification_t type = HM1X_NOTIFY_NONE;
 
-    // Receive serial stream, delay for a bit between charaters
-    if (hwAvailable())
+    if (strlen(message) < 7)
     {
-        while (hwAvailable())
-        {
-            response += readChar();
-            delay(HM1X_POLL_DELAY);
-        }
+        return HM1X_NOTIFY_NONE;
     }
-
-    if (response.length() == 0)
+    if (strncmp(message, "OK+INIT", 7) == 0)
     {
-        return false;
+        type = HM1X_NOTIFY_INIT;
+    }
+    else if (strncmp_P(message, HM1X_OK_CONN_EDR, strlen_P(HM1X_OK_CONN_EDR)) == 0)
+    {
+        type = HM1X_NOTIFY_CONNECT_EDR;
+    }
+    else if (strncmp_P(message, HM1X_OK_CONN_BLE, strlen_P(HM1X_OK_CONN_BLE)) == 0)
+    {
+        type = HM1X_NOTIFY_CONNECT_BLE;
+    }
+    else if (strncmp_P(message, HM1X_OK_DISCON_EDR, strlen_P(HM1X_OK_DISCON_EDR)) == 0)
+    {
+        type = HM1X_NOTIFY_DISCONNECT_EDR;
+    }
+    else if (strncmp_P(message, HM1X_OK_DISCON_BLE, strlen_P(HM1X_OK_DISCON_BLE)) == 0)
+    {
+        type = HM1X_NOTIFY_DISCONNECT_BLE;
     }
 
-    if (response.length() >= 7)
+    if (address != NULL)
     {
-        if (response.substring(0, 7) == "OK+INIT") 
-        {
-            // TODO: Module restarted -- need to do anything?
-            handled = true;
-        }
-        else if (response.substring(0, strlen(HM1X_OK_CONN_EDR)) == String(HM1X_OK_CONN_EDR))
-        {
-            _edrAddress = response.substring(8,20);
-            _connectedEdr = true;
-            handled = true;
-        }
-        else if (response.substring(0, strlen(HM1X_OK_CONN_BLE)) == String(HM1X_OK_CONN_BLE))
-        {
-            _bleAddress = response.substring(8,20);
-            _connectedBle = true;
-            handled = true;
-        }
-        else if (response.substring(0, strlen(HM1X_OK_DISCON_EDR)) == String(HM1X_OK_DISCON_EDR))
+        address[0] = 0;
+        // Address follows the 8 character prefix, e.g. OK+CONB:001122334455
+        if ((type != HM1X_NOTIFY_NONE) && (type != HM1X_NOTIFY_INIT) && (strlen(message) > 8))
         {
-            _edrAddress = response.substring(8, 20);
-            _connectedEdr = false;
-            handled = true;
+            strncpy(address, message + 8, HM1X_ADDRESS_LENGTH);
+            address[HM1X_ADDRESS_LENGTH] = 0;
         }
-        else if (response.substring(0, strlen(HM1X_OK_DISCON_BLE)) == String(HM1X_OK_DISCON_BLE))
-        {
-            _bleAddress = response.substring(8, 20);
-            _connectedBle = false;
-            handled = true;
-        }
-    }
-    if (handled == false)
-    {
-        // Store response into local buffer
-        _response += response;
     }
-    return handled;
+    return type;
 }
 
-int HM1X_BT::available(void)
+int HM1X_Core::available(void)
 {
-    // If we've polled, then return either _response.length()
+    // If we've polled, then return either data poll() has buffered
     //       or otherwise bytes available in I2C/Serial buffer.
     if ( _polling )
     {
-        return _response.length();
+        return responseAvailable();
     }
     else
     {
@@ -327,15 +401,17 @@ int HM1X_BT::available(void)
     //return hwAvailable();
 }
 
-char HM1X_BT::read(void)
+char HM1X_Core::read(void)
 {
-    // If we've polled, then return either _response.length()
+    // If we've polled, then return either data poll() has buffered
     //       or otherwise bytes available in I2C/Serial buffer.
     if ( _polling )
     {
-        char retVal = _response.charAt(0);
-        _response = _response.substring(1);
-        return retVal;
+        if (_responseRead >= _responseLength)
+        {
+            return 0;
+        }
+        return _response[_responseRead++];
     }
     else
     {
@@ -343,119 +419,40 @@ char HM1X_BT::read(void)
     }
 }
 
-
-size_t HM1X_BT::write(uint8_t c)
+size_t HM1X_Core::readBytes(char * buffer, size_t length)
 {
-    if (0)
-    {
+    size_t count = 0;
 
-    }
-#ifdef HM1X_SOFTWARE_SERIAL_ENABLED
-    else if (_softSerial != NULL)
-    {
-        return _softSerial->write(c);
-    }
-#endif
-#ifdef HM1X_HARDWARE_SERIAL_ENABLED
-    else if (_serialPort != NULL)
-    {
-        return _serialPort->write(c);
-    }
-#endif
-#ifdef HM1X_I2C_ENABLED
-    else if (_wirePort != NULL)
+    while ((count < length) && (available() > 0))
     {
-        _wirePort->beginTransmission(_wireAddress);
-        _wirePort->write(I2C_CMD_WRITE);
-        _wirePort->write(c);
-        _wirePort->endTransmission(true);
-        return (size_t) 1;
+        buffer[count++] = read();
     }
-    return (size_t) 0;
-#endif
+    return count;
 }
 
-size_t HM1X_BT::write(const char *str)
+size_t HM1X_Core::write(uint8_t c)
 {
-    size_t len = strlen(str);
-
-    if (0)
-    {
-
-    }
-#ifdef HM1X_SOFTWARE_SERIAL_ENABLED
-    else if (_softSerial != NULL)
-    {
-        return _softSerial->print(str);
-    }
-#endif
-#ifdef HM1X_HARDWARE_SERIAL_ENABLED
-    else if (_serialPort != NULL)
-    {
-        return _serialPort->print(str);
-    }
-#endif
-#ifdef HM1X_I2C_ENABLED
-    else if (_wirePort != NULL)
-    {
-        _wirePort->beginTransmission(_wireAddress);
-        _wirePort->write(I2C_CMD_WRITE);
-        for (int i = 0; i < len; i++)
-        {
-            _wirePort->write(str[i]);
-        }
-        _wirePort->endTransmission(true);
-        return len;
-    }
-#endif
-    return (size_t) 0;
+    return hwWrite((const char *) &c, 1);
 }
 
-size_t HM1X_BT::write(const char * buffer, size_t size)
+size_t HM1X_Core::write(const char *str)
 {
-    if (0)
-    {
+    return hwWrite(str, strlen(str));
+}
 
-    }
-#ifdef HM1X_SOFTWARE_SERIAL_ENABLED
-    else if (_softSerial != NULL)
-    {
-        return _softSerial->print(buffer);
-    }
-#endif
-#ifdef HM1X_HARDWARE_SERIAL_ENABLED
-    else if (_serialPort != NULL)
-    {
-        return _serialPort->print(buffer);
-    }
-#endif
-#ifdef HM1X_I2C_ENABLED
-    else if (_wirePort != NULL)
-    {
-        _wirePort->beginTransmission(_wireAddress);
-        _wirePort->write(I2C_CMD_WRITE);
-        for (int i = 0; i < size; i++)
-        {
-            _wirePort->write(buffer[i]);
-        }
-        _wirePort->endTransmission(true);
-        return size;
-    }
-#endif
-    return (size_t) 0;
+size_t HM1X_Core::write(const char * buffer, size_t size)
+{
+    return hwWrite(buffer, size);
 }
 
-HM1X_error_t HM1X_BT::testOrDisconnect(void)
+HM1X_error_t HM1X_Core::testOrDisconnect(void)
 {
-    char * response;
+    char response[HM1X_DISCONNECT_RESPONSE_LEN + 2] = "";
     HM1X_error_t err;
 
-    response = (char *) calloc(HM1X_DISCONNECT_RESPONSE_LEN + 2, sizeof(char));
-    if (response == NULL) return HM1X_OUT_OF_MEMORY;
+    sendCommandWithTimeout(NULL, NULL, response, sizeof(response), HM1X_DEFAULT_TIMEOUT);
 
-    sendCommandWithTimeout("", &response, HM1X_DEFAULT_TIMEOUT);
-
-    if (strcmp(response, HM1X_RESPONSE_OK) == 0)
+    if (strcmp_P(response, HM1X_RESPONSE_OK) == 0)
     {
         err = HM1X_SUCCESS;
     }
@@ -470,166 +467,103 @@ HM1X_error_t HM1X_BT::testOrDisconnect(void)
         err = HM1X_SUCCESS; //HM1X_UNEXPECTED_RESPONSE;
     }
 
-    free(response);
-
     return err;
 }
 
 // AT+RENEW -- Restore factory defaults
-HM1X_error_t HM1X_BT::factoryDefaults(void)
+HM1X_error_t HM1X_Core::factoryDefaults(void)
 {
-    String expectedResponse;
-    char * command;
-    char * response;
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_PLUS) + sizeof(HM1X_COMMAND_FACTORY_DEFAULTS) + 1] = "";
     HM1X_error_t err;
 
-    // Generate command: "AT+RENEW"
-    command = (char *) calloc(strlen(HM1X_COMMAND_FACTORY_DEFAULTS) + 1, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
-    sprintf(command, "%s", HM1X_COMMAND_FACTORY_DEFAULTS);
-
     // Generate expected response: "OK+RENEW"
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_PLUS) 
-                      + strlen(HM1X_COMMAND_FACTORY_DEFAULTS) + 1, sizeof(char));
-    if (response == NULL) return HM1X_OUT_OF_MEMORY;
-    sprintf(response, "%s%s%s", HM1X_RESPONSE_OK, HM1X_RESPONSE_PLUS, HM1X_COMMAND_FACTORY_DEFAULTS);
-
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM HM1X_PGM), HM1X_RESPONSE_OK, HM1X_RESPONSE_PLUS, HM1X_COMMAND_FACTORY_DEFAULTS);
 
-    free(response);
-    free(command);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_FACTORY_DEFAULTS, NULL, response, HM1X_DEFAULT_TIMEOUT);
 
     return err;
 }
 
 // AT+RESET -- Restart module
-HM1X_error_t HM1X_BT::reset(void)
+HM1X_error_t HM1X_Core::reset(void)
 {
-    String expectedResponse;
-    char * command;
-    char * response;
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_PLUS) + sizeof(HM1X_COMMAND_RESET) + 1] = "";
     HM1X_error_t err;
 
-    // Generate command: "AT+RESET"
-    command = (char *) calloc(strlen(HM1X_COMMAND_RESET) + 1, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
-    sprintf(command, "%s", HM1X_COMMAND_RESET);
-
     // Generate expected response: "OK+RESET"
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_COMMAND_RESET) + 1, sizeof(char));
-    if (response == NULL) return HM1X_OUT_OF_MEMORY;
-    sprintf(response, "%s%s%s", HM1X_RESPONSE_OK, HM1X_RESPONSE_PLUS, HM1X_COMMAND_RESET);
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM HM1X_PGM), HM1X_RESPONSE_OK, HM1X_RESPONSE_PLUS, HM1X_COMMAND_RESET);
 
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_RESET, NULL, response, HM1X_DEFAULT_TIMEOUT);
 
-    free(response);
-    free(command);
+    // Baud, stop bit and parity changes take effect when the module restarts.
+    // Follow them on the host side (UART or Qwiic bridge) so we stay in sync.
+    if (err == HM1X_SUCCESS)
+    {
+        hwBegin(_baud);
+    }
 
     return err;
 }
 
 // AT+VERR -- Software version
-HM1X_error_t HM1X_BT::version(char * version)
+HM1X_error_t HM1X_Core::version(char * version)
 {
-    String expectedResponse;
-    char * command;
-    char * response;
+    char response[12 + 1] = "";
     int retNum;
 
-    // Generate command: "AT+VERR?"
-    command = (char *) calloc(strlen(HM1X_COMMAND_VERSION) + strlen(HM1X_QUERY_STRING) + 1, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
-    strcpy(command, HM1X_COMMAND_VERSION);
-    strcat(command, HM1X_QUERY_STRING);
-
-    // Generate expected response: "OK+RESET"
-    response = (char *) calloc(12 + 1, sizeof(char));
-    if (response == NULL) return HM1X_OUT_OF_MEMORY;
-
-    sendCommandWithTimeout(command, &response, HM1X_DEFAULT_TIMEOUT);
-    strcpy(version, response + strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_GET));
-
-    free(response);
-    free(command);
+    sendCommandWithTimeout(HM1X_COMMAND_VERSION, HM1X_QUERY_STRING, response, sizeof(response), HM1X_DEFAULT_TIMEOUT);
+    strcpy(version, response + strlen_P(HM1X_RESPONSE_OK) + strlen_P(HM1X_RESPONSE_GET));
 
     return HM1X_SUCCESS;
 }
 
-HM1X_error_t HM1X_BT::notifyInfo(boolean enabled)
+HM1X_error_t HM1X_Core::notifyInfo(boolean enabled)
 {
     HM1X_error_t err;
-    char * command;
-    char * response;
+    char argument[2];
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + 2] = "";
     char param;
 
     if (enabled) param = '1';
     else param = '0';
 
     // Build command: e.g. AT+NOTI1
-    command = (char *) calloc(strlen(HM1X_COMMAND_NOTIFY_INIT) + 2, sizeof(char));
-    if (command == NULL)
-    {
-        return HM1X_OUT_OF_MEMORY;
-    }
-    sprintf(command, "%s%c", HM1X_COMMAND_NOTIFY_INIT, param);
+    sprintf(argument, "%c", param);
 
     // Build expected response: e.g. OK+Set:1
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_SET) + 2, sizeof(char));
-    if (response == NULL)
-    {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
-    }
-    sprintf(response, "%s%s%c", HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, param);
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM "%c"), HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, param);
 
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_NOTIFY_INIT, argument, response, HM1X_DEFAULT_TIMEOUT);
     
-    free(command);
-    free(response);
-
     return err;
 }
 
 
 // AT+NOTI -- Set notify information 
-HM1X_error_t HM1X_BT::notifyMode(boolean enabled)
+HM1X_error_t HM1X_Core::notifyMode(boolean enabled)
 {
     HM1X_error_t err;
-    char * command;
-    char * response;
+    char argument[2];
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + 2] = "";
     char param;
     
     if (enabled) param = '1';
     else param = '0';
 
     // Build command: e.g. AT+NOTP1
-    command = (char *) calloc(strlen(HM1X_COMMAND_NOTIFY_MODE) + 2, sizeof(char));
-    if (command == NULL)
-    {
-        return HM1X_OUT_OF_MEMORY;
-    }
-    sprintf(command, "%s%c", HM1X_COMMAND_NOTIFY_MODE, param);
+    sprintf(argument, "%c", param);
 
     // Build expected response: e.g. OK+Set:1)
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_SET) + 2, sizeof(char));
-    if (response == NULL)
-    {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
-    }
-    sprintf(response, "%s%s%c", HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, param);
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM "%c"), HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, param);
 
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_NOTIFY_MODE, argument, response, HM1X_DEFAULT_TIMEOUT);
     
-    free(command);
-    free(response);
-
     return err;
 }
 
 
 // AT+NOTI, AT+NOTP -- Notify information
-HM1X_error_t HM1X_BT::notify(boolean enabled, boolean withAddress)
+HM1X_error_t HM1X_Core::notify(boolean enabled, boolean withAddress)
 {
     HM1X_error_t err;
 
@@ -638,482 +572,282 @@ HM1X_error_t HM1X_BT::notify(boolean enabled, boolean withAddress)
     return err;
 }
 
-String HM1X_BT::getEdrName(void)
+#ifndef HM1X_NO_HEAP
+String HM1X_Core::getEdrName(void)
 {
-    char * name;
-    String retName = "";
-    name = (char *)malloc(32* sizeof(char));
-    if (name != NULL)
+    char name[HM1X_NAME_LENGTH + 1];
+
+    if (getEdrName(name) == HM1X_SUCCESS)
     {
-        if (getEdrName(name) == HM1X_SUCCESS)
-        {
-            retName = String(name);
-        }
+        return String(name);
     }
-    return retName;
+    return "";
 }
+#endif
 
 // AT+NAME, AT+NAMB -- Set EDR/BLE name
-HM1X_error_t HM1X_BT::getEdrName(char * name)
+HM1X_error_t HM1X_Core::getEdrName(char * name)
 {
     HM1X_error_t err;
-    char * command;
-    char * response;
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_GET) + HM1X_NAME_LENGTH + 2] = "";
     int retNameLen;
 
-    // Create command string: AT+NAME?
-    command = (char *) calloc(strlen(HM1X_COMMAND_EDR_NAME) + strlen(HM1X_QUERY_STRING) + 2, sizeof(char));
-    if (command == NULL)
-    {
-        return HM1X_OUT_OF_MEMORY;
-    }
-    strcat(command, HM1X_COMMAND_EDR_NAME);
-    strcat(command, HM1X_QUERY_STRING);
-
-    // Allocate enough memory for a response (up to 28 bytes + "OK+Get:")
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_GET) + 28 + 2, sizeof(char));
-    if (response == NULL)
-    {
-        return HM1X_OUT_OF_MEMORY;
-    }
+    HM1X_REQUIRE(HM1X_CAP_DUAL_MODE | HM1X_CAP_EDR);
 
-    retNameLen = sendCommandWithTimeout(command, &response, HM1X_RESPONSE_TIMEOUT);
+    retNameLen = sendCommandWithTimeout(HM1X_COMMAND_EDR_NAME, HM1X_QUERY_STRING, response, sizeof(response), HM1X_RESPONSE_TIMEOUT);
     if (retNameLen == 0)
     {
         return HM1X_ERROR_TIMEOUT;
     }
-    strcpy(name, response + (strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_GET)));
-
-    free(response);
-    free(command);
-    
-    return HM1X_SUCCESS;
+    return copyResponseValue(name, response, HM1X_NAME_LENGTH);
 }
 
-HM1X_error_t HM1X_BT::setEdrName(String name)
+#ifndef HM1X_NO_HEAP
+HM1X_error_t HM1X_Core::setEdrName(String name)
 {
-    char * edrChar;
-    edrChar = (char *) calloc(name.length() + 1, sizeof(char));
-    name.toCharArray(edrChar, name.length() + 1);
-    return setEdrName(edrChar);
+    return setEdrName(name.c_str());
 }
+#endif
 
-HM1X_error_t HM1X_BT::setEdrName(const char * name)
+HM1X_error_t HM1X_Core::setEdrName(const char * name)
 {
     HM1X_error_t err;
-    char * command;
-    char * response;
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + HM1X_NAME_LENGTH + 2] = "";
     int nameLen;
 
+    HM1X_REQUIRE(HM1X_CAP_DUAL_MODE | HM1X_CAP_EDR);
+
     nameLen = strlen(name);
 
-    if (nameLen > 28) // Name can't exceed 28 characters
+    if (nameLen > HM1X_NAME_LENGTH) // Name can't exceed 28 characters
     {
         return HM1X_UNEXPECTED_RESPONSE;
     }
 
-    // Build command: e.g. AT+NAMEMY_EDR_DEVICE
-    command = (char *) calloc(strlen(HM1X_COMMAND_EDR_NAME) + nameLen + 2, sizeof(char));
-    if (command == NULL)
-    {
-        return HM1X_OUT_OF_MEMORY;
-    }
-    strcat(command, HM1X_COMMAND_EDR_NAME);
-    strcat(command, name);
-
     // Build expected response: e.g. OK+Set:MY_EDR_DEVICE
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_SET) + nameLen + 2, sizeof(char));
-    if (response == NULL)
-    {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
-    }
-    strcat(response, HM1X_RESPONSE_OK);
-    strcat(response, HM1X_RESPONSE_SET);
+    strcat_P(response, HM1X_RESPONSE_OK);
+    strcat_P(response, HM1X_RESPONSE_SET);
     strcat(response, name);
 
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_EDR_NAME, name, response, HM1X_DEFAULT_TIMEOUT);
     
-    free(command);
-    free(response);
-
     return err;
 }
 
-String HM1X_BT::getBleName(void)
+#ifndef HM1X_NO_HEAP
+String HM1X_Core::getBleName(void)
 {
-    char * name;
-    String retName = "";
-    name = (char *)malloc(32* sizeof(char));
-    if (name != NULL)
+    char name[HM1X_NAME_LENGTH + 1];
+
+    if (getBleName(name) == HM1X_SUCCESS)
     {
-        if (getBleName(name) == HM1X_SUCCESS)
-        {
-            retName = String(name);
-        }
+        return String(name);
     }
-    return retName;
+    return "";
 }
+#endif
 
-HM1X_error_t HM1X_BT::getBleName(char * name)
+HM1X_error_t HM1X_Core::getBleName(char * name)
 {
     HM1X_error_t err;
-    char * command;
-    char * response;
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_GET) + HM1X_NAME_LENGTH + 2] = "";
     int retNameLen;
 
-    // Create command string: AT+NAMB?
-    command = (char *) calloc(strlen(HM1X_COMMAND_BLE_NAME) + strlen(HM1X_QUERY_STRING) + 2, sizeof(char));
-    if (command == NULL)
-    {
-        return HM1X_OUT_OF_MEMORY;
-    }
-    strcat(command, HM1X_COMMAND_BLE_NAME);
-    strcat(command, HM1X_QUERY_STRING);
-
-    // Allocate enough memory for a response (up to 28 bytes + "OK+Get:")
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_GET) + 28 + 2, sizeof(char));
-    if (response == NULL)
-    {
-        return HM1X_OUT_OF_MEMORY;
-    }
+    HM1X_REQUIRE(HM1X_CAP_DUAL_MODE | HM1X_CAP_BLE);
 
-    retNameLen = sendCommandWithTimeout(command, &response, HM1X_RESPONSE_TIMEOUT);
+    retNameLen = sendCommandWithTimeout(HM1X_COMMAND_BLE_NAME, HM1X_QUERY_STRING, response, sizeof(response), HM1X_RESPONSE_TIMEOUT);
     if (retNameLen == 0)
     {
         return HM1X_ERROR_TIMEOUT;
     }
-    strcpy(name, response + (strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_GET)));
-
-    free(response);
-    free(command);
-    
-    return HM1X_SUCCESS;
+    return copyResponseValue(name, response, HM1X_NAME_LENGTH);
 }
 
-HM1X_error_t HM1X_BT::setBleName(String name)
+#ifndef HM1X_NO_HEAP
+HM1X_error_t HM1X_Core::setBleName(String name)
 {
-    char * bleName;
-    bleName = (char *) calloc(name.length() + 1, sizeof(char));
-    name.toCharArray(bleName, name.length() + 1);
-    return setBleName(bleName);
+    return setBleName(name.c_str());
 }
+#endif
 
-HM1X_error_t HM1X_BT::setBleName(const char * name)
+HM1X_error_t HM1X_Core::setBleName(const char * name)
 {
     HM1X_error_t err;
-    char * command;
-    char * response;
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + HM1X_NAME_LENGTH + 2] = "";
     int nameLen;
 
+    HM1X_REQUIRE(HM1X_CAP_DUAL_MODE | HM1X_CAP_BLE);
+
     nameLen = strlen(name);
 
-    if (nameLen > 28) // Name can't exceed 28 characters
+    if (nameLen > HM1X_NAME_LENGTH) // Name can't exceed 28 characters
     {
         return HM1X_UNEXPECTED_RESPONSE;
     }
 
-    // Build command: e.g. AT+NAMBMY_BLE_DEVICE
-    command = (char *) calloc(strlen(HM1X_COMMAND_BLE_NAME) + nameLen + 2, sizeof(char));
-    if (command == NULL)
-    {
-        return HM1X_OUT_OF_MEMORY;
-    }
-    strcat(command, HM1X_COMMAND_BLE_NAME);
-    strcat(command, name);
-
     // Build expected response: e.g. OK+Set:MY_BLE_DEVICE
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_SET) + nameLen + 2, sizeof(char));
-    if (response == NULL)
-    {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
-    }
-    strcat(response, HM1X_RESPONSE_OK);
-    strcat(response, HM1X_RESPONSE_SET);
+    strcat_P(response, HM1X_RESPONSE_OK);
+    strcat_P(response, HM1X_RESPONSE_SET);
     strcat(response, name);
 
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_BLE_NAME, name, response, HM1X_DEFAULT_TIMEOUT);
     
-    free(command);
-    free(response);
-
     return err;
 }
 
-String HM1X_BT::edrAddress(void)
+#ifndef HM1X_NO_HEAP
+String HM1X_Core::edrAddress(void)
 {
-    char * address;
-    address = (char *) calloc(22, sizeof(char));
+    char address[HM1X_ADDRESS_LENGTH + 1];
+
     if (edrAddress(address) == HM1X_SUCCESS)
     {
         return String(address);
     }
     return ""; // Return nothing on fail
 }
+#endif
 
 // AT+ADDE -- EDR address
-HM1X_error_t HM1X_BT::edrAddress(char * retAddress)
+HM1X_error_t HM1X_Core::edrAddress(char * retAddress)
 {
-    char * command;
-    char * response;
-
-    command = (char *) calloc(strlen(HM1X_COMMAND_EDR_ADR) + strlen(HM1X_QUERY_STRING) + 1, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
-    strcpy(command, HM1X_COMMAND_EDR_ADR);
-    strcat(command, HM1X_QUERY_STRING);
-
-    response = (char *) calloc(20 + 1, sizeof(char));
-    if (response == NULL) return HM1X_OUT_OF_MEMORY;
+    char response[20 + 1] = "";
 
-    sendCommandWithTimeout(command, &response, HM1X_RESPONSE_TIMEOUT);
+    HM1X_REQUIRE(HM1X_CAP_DUAL_MODE | HM1X_CAP_EDR);
 
-    strcpy(retAddress, response + (strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_GET)));
+    sendCommandWithTimeout(HM1X_COMMAND_EDR_ADR, HM1X_QUERY_STRING, response, sizeof(response), HM1X_RESPONSE_TIMEOUT);
 
-    free(response);
-    free(command);
-    
-    return HM1X_SUCCESS;
+    return copyResponseValue(retAddress, response, HM1X_ADDRESS_LENGTH);
 }
 
-String HM1X_BT::bleAddress(void)
+#ifndef HM1X_NO_HEAP
+String HM1X_Core::bleAddress(void)
 {
-    char * address;
-    address = (char *) calloc(22, sizeof(char));
+    char address[HM1X_ADDRESS_LENGTH + 1];
+
     if (bleAddress(address) == HM1X_SUCCESS)
     {
         return String(address);
     }
     return ""; // Return nothing on fail
 }
+#endif
 
 // AT+ADDB -- BLE address
-HM1X_error_t HM1X_BT::bleAddress(char * retAddress)
+HM1X_error_t HM1X_Core::bleAddress(char * retAddress)
 {
-    char * command;
-    char * response;
+    char response[20 + 1] = "";
 
-    command = (char *) calloc(strlen(HM1X_COMMAND_BLE_ADR) + strlen(HM1X_QUERY_STRING) + 1, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
-    strcpy(command, HM1X_COMMAND_BLE_ADR);
-    strcat(command, HM1X_QUERY_STRING);
+    HM1X_REQUIRE(HM1X_CAP_DUAL_MODE | HM1X_CAP_BLE);
 
-    response = (char *) calloc(20 + 1, sizeof(char));
-    if (response == NULL) return HM1X_OUT_OF_MEMORY;
+    sendCommandWithTimeout(HM1X_COMMAND_BLE_ADR, HM1X_QUERY_STRING, response, sizeof(response), HM1X_RESPONSE_TIMEOUT);
 
-    sendCommandWithTimeout(command, &response, HM1X_RESPONSE_TIMEOUT);
-
-    strcpy(retAddress, response + (strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_GET)));
-    
-    free(response);
-    free(command);
-
-    return HM1X_SUCCESS;
+    return copyResponseValue(retAddress, response, HM1X_ADDRESS_LENGTH);
 }
 
 // AT+RADE, AT+RADB -- Last connected EDR/BLE address
-HM1X_error_t HM1X_BT::lastEdrAddress(char * address)
+HM1X_error_t HM1X_Core::lastEdrAddress(char * address)
 {
-    char * command;
-    char * response;
+    char response[20 + 1] = "";
 
-    command = (char *) calloc(strlen(HM1X_COMMAND_LAST_EDR) + strlen(HM1X_QUERY_STRING) + 1, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
-    strcpy(command, HM1X_COMMAND_LAST_EDR);
-    strcat(command, HM1X_QUERY_STRING);
+    HM1X_REQUIRE(HM1X_CAP_DUAL_MODE | HM1X_CAP_EDR);
 
-    response = (char *) calloc(20 + 1, sizeof(char));
-    if (response == NULL) return HM1X_OUT_OF_MEMORY;
+    sendCommandWithTimeout(HM1X_COMMAND_LAST_EDR, HM1X_QUERY_STRING, response, sizeof(response), HM1X_RESPONSE_TIMEOUT);
 
-    sendCommandWithTimeout(command, &response, HM1X_RESPONSE_TIMEOUT);
-
-    strcpy(address, response + (strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_GET)));
-
-    free(response);
-    free(command);
-    
-    return HM1X_SUCCESS;
+    return copyResponseValue(address, response, HM1X_ADDRESS_LENGTH);
 }
 
-HM1X_error_t HM1X_BT::lastBleAddress(char * address)
+HM1X_error_t HM1X_Core::lastBleAddress(char * address)
 {
-    char * command;
-    char * response;
+    char response[20 + 1] = "";
 
-    command = (char *) calloc(strlen(HM1X_COMMAND_LAST_BLE) + strlen(HM1X_QUERY_STRING) + 1, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
-    strcpy(command, HM1X_COMMAND_LAST_BLE);
-    strcat(command, HM1X_QUERY_STRING);
+    HM1X_REQUIRE(HM1X_CAP_DUAL_MODE | HM1X_CAP_BLE);
 
-    response = (char *) calloc(20 + 1, sizeof(char));
-    if (response == NULL) return HM1X_OUT_OF_MEMORY;
+    sendCommandWithTimeout(HM1X_COMMAND_LAST_BLE, HM1X_QUERY_STRING, response, sizeof(response), HM1X_RESPONSE_TIMEOUT);
 
-    sendCommandWithTimeout(command, &response, HM1X_RESPONSE_TIMEOUT);
-
-    strcpy(address, response + (strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_GET)));
-
-    free(response);
-    free(command);
-    
-    return HM1X_SUCCESS;
+    return copyResponseValue(address, response, HM1X_ADDRESS_LENGTH);
 }
 
 // AT+BONDE, AT+BONDB --- Clear EDR/BLE bond info
-HM1X_error_t HM1X_BT::clearEdrBond(void)
+HM1X_error_t HM1X_Core::clearEdrBond(void)
 {
     HM1X_error_t err;
-    char * command;
-    char * response;
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_PLUS) + sizeof(HM1X_COMMAND_CLEAR_BOND_EDR) + 1] = "";
 
-    // Build command: e.g. AT+BONDE
-    command = (char *) calloc(strlen(HM1X_COMMAND_CLEAR_BOND_EDR) + 1, sizeof(char));
-    if (command == NULL)
-    {
-        return HM1X_OUT_OF_MEMORY;
-    }
-    strcat(command, HM1X_COMMAND_CLEAR_BOND_EDR);
+    HM1X_REQUIRE(HM1X_CAP_DUAL_MODE | HM1X_CAP_EDR | HM1X_CAP_BOND);
 
     // Build expected response: e.g. OK+BONDE
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_PLUS)
-                    + strlen(HM1X_COMMAND_CLEAR_BOND_EDR) + 1, sizeof(char));
-    if (response == NULL)
-    {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
-    }
-    strcat(response, HM1X_RESPONSE_OK);
-    strcat(response, HM1X_RESPONSE_PLUS);
-    strcat(response, HM1X_COMMAND_CLEAR_BOND_EDR);
+    strcat_P(response, HM1X_RESPONSE_OK);
+    strcat_P(response, HM1X_RESPONSE_PLUS);
+    strcat_P(response, HM1X_COMMAND_CLEAR_BOND_EDR);
 
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_CLEAR_BOND_EDR, NULL, response, HM1X_DEFAULT_TIMEOUT);
     
-    free(command);
-    free(response);
-
     return err;
 }
 
-HM1X_error_t HM1X_BT::clearBleBond(void)
+HM1X_error_t HM1X_Core::clearBleBond(void)
 {
     HM1X_error_t err;
-    char * command;
-    char * response;
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_PLUS) + sizeof(HM1X_COMMAND_CLEAR_BOND_BLE) + 2] = "";
 
-    // Build command: e.g. AT+BONDB
-    command = (char *) calloc(strlen(HM1X_COMMAND_CLEAR_BOND_BLE) + 2, sizeof(char));
-    if (command == NULL)
-    {
-        return HM1X_OUT_OF_MEMORY;
-    }
-    strcat(command, HM1X_COMMAND_CLEAR_BOND_BLE);
+    HM1X_REQUIRE(HM1X_CAP_DUAL_MODE | HM1X_CAP_BLE | HM1X_CAP_BOND);
 
     // Build expected response: e.g. OK+BONDB
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_PLUS)
-                    + strlen(HM1X_COMMAND_CLEAR_BOND_BLE) + 2, sizeof(char));
-    if (response == NULL)
-    {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
-    }
-    strcat(response, HM1X_RESPONSE_OK);
-    strcat(response, HM1X_RESPONSE_PLUS);
-    strcat(response, HM1X_COMMAND_CLEAR_BOND_BLE);
+    strcat_P(response, HM1X_RESPONSE_OK);
+    strcat_P(response, HM1X_RESPONSE_PLUS);
+    strcat_P(response, HM1X_COMMAND_CLEAR_BOND_BLE);
 
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_CLEAR_BOND_BLE, NULL, response, HM1X_DEFAULT_TIMEOUT);
     
-    free(command);
-    free(response);
-
     return err;
 }
 
 // AT+CLEAE, AT+CLEAB -- Clear last connected EDR/BLE address
-HM1X_error_t HM1X_BT::clearEdrConnected(void)
+HM1X_error_t HM1X_Core::clearEdrConnected(void)
 {
     HM1X_error_t err;
-    char * command;
-    char * response;
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_PLUS) + sizeof(HM1X_COMMAND_CLEAR_ADR_EDR) + 1] = "";
 
-    // Build command: e.g. AT+CLEAE
-    command = (char *) calloc(strlen(HM1X_COMMAND_CLEAR_ADR_EDR) + 1, sizeof(char));
-    if (command == NULL)
-    {
-        return HM1X_OUT_OF_MEMORY;
-    }
-    strcat(command, HM1X_COMMAND_CLEAR_ADR_EDR);
+    HM1X_REQUIRE(HM1X_CAP_DUAL_MODE | HM1X_CAP_EDR);
 
     // Build expected response: e.g. OK+CLEAE
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_PLUS)
-                    + strlen(HM1X_COMMAND_CLEAR_ADR_EDR) + 1, sizeof(char));
-    if (response == NULL)
-    {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
-    }
-    strcat(response, HM1X_RESPONSE_OK);
-    strcat(response, HM1X_RESPONSE_PLUS);
-    strcat(response, HM1X_COMMAND_CLEAR_ADR_EDR);
+    strcat_P(response, HM1X_RESPONSE_OK);
+    strcat_P(response, HM1X_RESPONSE_PLUS);
+    strcat_P(response, HM1X_COMMAND_CLEAR_ADR_EDR);
 
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_CLEAR_ADR_EDR, NULL, response, HM1X_DEFAULT_TIMEOUT);
     
-    free(command);
-    free(response);
-
     return err;
 }
 
-HM1X_error_t HM1X_BT::clearBleConnected(void)
+HM1X_error_t HM1X_Core::clearBleConnected(void)
 {
     HM1X_error_t err;
-    char * command;
-    char * response;
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_PLUS) + sizeof(HM1X_COMMAND_CLEAR_ADR_BLE) + 1] = "";
 
-    // Build command: e.g. AT+CLEAB
-    command = (char *) calloc(strlen(HM1X_COMMAND_CLEAR_ADR_BLE) + 1, sizeof(char));
-    if (command == NULL)
-    {
-        return HM1X_OUT_OF_MEMORY;
-    }
-    strcat(command, HM1X_COMMAND_CLEAR_ADR_BLE);
+    HM1X_REQUIRE(HM1X_CAP_DUAL_MODE | HM1X_CAP_BLE);
 
     // Build expected response: e.g. OK+CLEAB
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_PLUS)
-                    + strlen(HM1X_COMMAND_CLEAR_ADR_BLE) + 1, sizeof(char));
-    if (response == NULL)
-    {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
-    }
-    strcat(response, HM1X_RESPONSE_OK);
-    strcat(response, HM1X_RESPONSE_PLUS);
-    strcat(response, HM1X_COMMAND_CLEAR_ADR_BLE);
+    strcat_P(response, HM1X_RESPONSE_OK);
+    strcat_P(response, HM1X_RESPONSE_PLUS);
+    strcat_P(response, HM1X_COMMAND_CLEAR_ADR_BLE);
 
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_CLEAR_ADR_BLE, NULL, response, HM1X_DEFAULT_TIMEOUT);
     
-    free(command);
-    free(response);
-
     return err;
 }
 
 // AT+ROLE, AT+ROLB -- EDR/BLE mode
-HM1X_error_t HM1X_BT::getEdrMode(HM1X_edr_mode_t * mode)
+HM1X_error_t HM1X_Core::getEdrMode(HM1X_edr_mode_t * mode)
 {
-    char * command;
-    char * response;
-
-    // Set command string: "AT+ROLE?""
-    command = (char *) calloc(strlen(HM1X_COMMAND_EDR_MODE) + strlen(HM1X_QUERY_STRING) + 1, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
-    strcpy(command, HM1X_COMMAND_EDR_MODE);
-    strcat(command, HM1X_QUERY_STRING);
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_GET) + 2] = "";
 
-    response = (char *) calloc(sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_GET) + 2, sizeof(char));
-    if (response == NULL) return HM1X_OUT_OF_MEMORY;
+    HM1X_REQUIRE(HM1X_CAP_DUAL_MODE | HM1X_CAP_EDR);
 
-    sendCommandWithTimeout(command, &response, HM1X_RESPONSE_TIMEOUT);
+    sendCommandWithTimeout(HM1X_COMMAND_EDR_MODE, HM1X_QUERY_STRING, response, sizeof(response), HM1X_RESPONSE_TIMEOUT);
 
-    strcpy(response, response + (strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_GET)));
+    strcpy(response, response + (strlen_P(HM1X_RESPONSE_OK) + strlen_P(HM1X_RESPONSE_GET)));
 
     if (strcmp(response, "0") == 0)
     {
@@ -1129,18 +863,17 @@ HM1X_error_t HM1X_BT::getEdrMode(HM1X_edr_mode_t * mode)
         return HM1X_UNEXPECTED_RESPONSE;
     }
 
-    free(response);
-    free(command);
-    
     return HM1X_SUCCESS;
 }
 
-HM1X_error_t HM1X_BT::setEdrMode(HM1X_edr_mode_t mode)
+HM1X_error_t HM1X_Core::setEdrMode(HM1X_edr_mode_t mode)
 {
     HM1X_error_t err;
-    char * command;
-    char * response;
+    char argument[2];
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + 2] = "";
     char modeParam;
+
+    HM1X_REQUIRE(HM1X_CAP_DUAL_MODE | HM1X_CAP_EDR);
     
     if (mode == EDR_MODE_INVALID)
     {
@@ -1148,44 +881,26 @@ HM1X_error_t HM1X_BT::setEdrMode(HM1X_edr_mode_t mode)
     }
 
     // Build command: e.g. AT+ROLE0
-    command = (char *) calloc(strlen(HM1X_COMMAND_EDR_MODE) + 2, sizeof(char));
     modeParam = (mode == EDR_SLAVE) ? '0' : '1';
-    sprintf(command, "%s%c", HM1X_COMMAND_EDR_MODE, modeParam);
+    sprintf(argument, "%c", modeParam);
 
     // Build expected response: e.g. OK+Set:0
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_SET) + 2, sizeof(char));
-    if (response == NULL)
-    {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
-    }
-    sprintf(response, "%s%s%c", HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, modeParam);
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM "%c"), HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, modeParam);
 
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_EDR_MODE, argument, response, HM1X_DEFAULT_TIMEOUT);
     
-    free(command);
-    free(response);
-
     return err;
 }
 
-HM1X_error_t HM1X_BT::getBleMode(HM1X_ble_mode_t * mode)
+HM1X_error_t HM1X_Core::getBleMode(HM1X_ble_mode_t * mode)
 {
-    char * command;
-    char * response;
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_GET) + 2] = "";
 
-    // Set command string: "AT+ROLE?""
-    command = (char *) calloc(strlen(HM1X_COMMAND_BLE_MODE) + strlen(HM1X_QUERY_STRING) + 1, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
-    strcpy(command, HM1X_COMMAND_BLE_MODE);
-    strcat(command, HM1X_QUERY_STRING);
+    HM1X_REQUIRE(HM1X_CAP_DUAL_MODE | HM1X_CAP_BLE);
 
-    response = (char *) calloc(sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_GET) + 2, sizeof(char));
-    if (response == NULL) return HM1X_OUT_OF_MEMORY;
+    sendCommandWithTimeout(HM1X_COMMAND_BLE_MODE, HM1X_QUERY_STRING, response, sizeof(response), HM1X_RESPONSE_TIMEOUT);
 
-    sendCommandWithTimeout(command, &response, HM1X_RESPONSE_TIMEOUT);
-
-    strcpy(response, response + (strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_GET)));
+    strcpy(response, response + (strlen_P(HM1X_RESPONSE_OK) + strlen_P(HM1X_RESPONSE_GET)));
 
     if (strcmp(response, "0") == 0)
     {
@@ -1201,18 +916,17 @@ HM1X_error_t HM1X_BT::getBleMode(HM1X_ble_mode_t * mode)
         return HM1X_UNEXPECTED_RESPONSE;
     }
 
-    free(response);
-    free(command);
-    
     return HM1X_SUCCESS;
 }
 
-HM1X_error_t HM1X_BT::setBleMode(HM1X_ble_mode_t mode)
+HM1X_error_t HM1X_Core::setBleMode(HM1X_ble_mode_t mode)
 {
     HM1X_error_t err;
-    char * command;
-    char * response;
+    char argument[2];
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + 2] = "";
     char modeParam;
+
+    HM1X_REQUIRE(HM1X_CAP_DUAL_MODE | HM1X_CAP_BLE);
     
     if (mode == EDR_MODE_INVALID)
     {
@@ -1220,357 +934,265 @@ HM1X_error_t HM1X_BT::setBleMode(HM1X_ble_mode_t mode)
     }
 
     // Build command: e.g. AT+ROLB0
-    command = (char *) calloc(strlen(HM1X_COMMAND_BLE_MODE) + 2, sizeof(char));
     modeParam = (mode == EDR_SLAVE) ? '0' : '1';
-    sprintf(command, "%s%c", HM1X_COMMAND_BLE_MODE, modeParam);
+    sprintf(argument, "%c", modeParam);
 
     // Build expected response: e.g. OK+Set:0
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_SET) + 2, sizeof(char));
-    if (response == NULL)
-    {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
-    }
-    sprintf(response, "%s%s%c", HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, modeParam);
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM "%c"), HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, modeParam);
 
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_BLE_MODE, argument, response, HM1X_DEFAULT_TIMEOUT);
     
-    free(command);
-    free(response);
-
     return err;
 }
 
+// AT+STARB -- Start BLE work (discovery, in the central role)
+HM1X_error_t HM1X_Core::startBleWork(void)
+{
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_PLUS) + sizeof(HM1X_COMMAND_START_BLE_WORK) + 1] = "";
+
+    HM1X_REQUIRE(HM1X_CAP_DUAL_MODE | HM1X_CAP_BLE);
+
+    // Build expected response: OK+STARB
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM HM1X_PGM), HM1X_RESPONSE_OK, HM1X_RESPONSE_PLUS, HM1X_COMMAND_START_BLE_WORK);
+
+    return sendCommandAndWaitFor(HM1X_COMMAND_START_BLE_WORK, NULL, response, HM1X_DEFAULT_TIMEOUT);
+}
+
+// AT+STOPB -- Stop BLE work
+HM1X_error_t HM1X_Core::stopBleWork(void)
+{
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_PLUS) + sizeof(HM1X_COMMAND_STOP_BLE_WORK) + 1] = "";
+
+    HM1X_REQUIRE(HM1X_CAP_DUAL_MODE | HM1X_CAP_BLE);
+
+    // Build expected response: OK+STOPB
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM HM1X_PGM), HM1X_RESPONSE_OK, HM1X_RESPONSE_PLUS, HM1X_COMMAND_STOP_BLE_WORK);
+
+    return sendCommandAndWaitFor(HM1X_COMMAND_STOP_BLE_WORK, NULL, response, HM1X_DEFAULT_TIMEOUT);
+}
+
 // AT+HIGH -- Data transmission speed mode
 // Disabled: SPP and BLE speeds balanced
 // Enabled: SPP will go high speed
-HM1X_error_t HM1X_BT::enableHighSpeedSPP(boolean enabled)
+HM1X_error_t HM1X_Core::enableHighSpeedSPP(boolean enabled)
 {
     HM1X_error_t err;
-    char * command;
-    char * response;
+    char argument[2];
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + 2] = "";
     char hsParam;
 
+    HM1X_REQUIRE(HM1X_CAP_DUAL_MODE | HM1X_CAP_EDR);
+
     // Build command: e.g. AT+HIGH0
-    command = (char *) calloc(strlen(HM1X_COMMAND_HIGH_SPEED_SPP) + 2, sizeof(char));
     hsParam = (enabled) ? '1' : '0';
-    sprintf(command, "%s%c", HM1X_COMMAND_HIGH_SPEED_SPP, hsParam);
+    sprintf(argument, "%c", hsParam);
 
     // Build expected response: e.g. OK+Set:0
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_SET) + 2, sizeof(char));
-    if (response == NULL)
-    {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
-    }
-    sprintf(response, "%s%s%c", HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, hsParam);
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM "%c"), HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, hsParam);
 
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_HIGH_SPEED_SPP, argument, response, HM1X_DEFAULT_TIMEOUT);
     
-    free(command);
-    free(response);
-
     return err;
 }
 
 
-HM1X_error_t HM1X_BT::enableDualMode(boolean enabled)
+HM1X_error_t HM1X_Core::enableDualMode(boolean enabled)
 {
     HM1X_error_t err;
-    char * command;
-    char * response;
+    char argument[2];
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + 2] = "";
     char hsParam;
 
+    HM1X_REQUIRE(HM1X_CAP_DUAL_MODE);
+
     // Build command: e.g. AT+DUAL0
-    command = (char *) calloc(strlen(HM1X_COMMAND_DUAL_WORK_MODE) + 2, sizeof(char));
     hsParam = (enabled) ? '0' : '1';
-    sprintf(command, "%s%c", HM1X_COMMAND_DUAL_WORK_MODE, hsParam);
+    sprintf(argument, "%c", hsParam);
 
     // Build expected response: e.g. OK+Set:0
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_SET) + 2, sizeof(char));
-    if (response == NULL)
-    {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
-    }
-    sprintf(response, "%s%s%c", HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, hsParam);
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM "%c"), HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, hsParam);
 
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_DUAL_WORK_MODE, argument, response, HM1X_DEFAULT_TIMEOUT);
     
-    free(command);
-    free(response);
-
     return err;
 }
 
 // AT+MODE -- Module work mode
 // Enabled: Allow remote control (send AT commands remotely)
 // Disabled: Data transmission only 
-HM1X_error_t HM1X_BT::enableRemoteControl(boolean enabled)
+HM1X_error_t HM1X_Core::enableRemoteControl(boolean enabled)
 {
     HM1X_error_t err;
-    char * command;
-    char * response;
+    char argument[2];
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + 2] = "";
     char param;
 
     // Build command: e.g. AT+MODE0
-    command = (char *) calloc(strlen(HM1X_COMMAND_MODULE_WORK_MODE) + 2, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
     param = (enabled) ? '1' : '0';
-    sprintf(command, "%s%c", HM1X_COMMAND_MODULE_WORK_MODE, param);
+    sprintf(argument, "%c", param);
 
     // Build expected response: e.g. OK+Set:0
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_SET) + 2, sizeof(char));
-    if (response == NULL)
-    {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
-    }
-    sprintf(response, "%s%s%c", HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, param);
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM "%c"), HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, param);
 
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_MODULE_WORK_MODE, argument, response, HM1X_DEFAULT_TIMEOUT);
     
-    free(command);
-    free(response);
-
     return err;
 }
 
 // AT+ATOB -- A to B mode
 // When two modules connected (BLE and SPP), this will route data from one to the other
-HM1X_error_t HM1X_BT::enableAtoB(boolean enable)
+HM1X_error_t HM1X_Core::enableAtoB(boolean enable)
 {
     HM1X_error_t err;
-    char * command;
-    char * response;
+    char argument[2];
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + 2] = "";
     char param;
 
+    HM1X_REQUIRE(HM1X_CAP_DUAL_MODE);
+
     // Build command: e.g. AT+ATOB0
-    command = (char *) calloc(strlen(HM1X_COMMAND_A_TO_B_MODE) + 2, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
     param = (enable) ? '1' : '0';
-    sprintf(command, "%s%c", HM1X_COMMAND_A_TO_B_MODE, param);
+    sprintf(argument, "%c", param);
 
     // Build expected response: e.g. OK+Set:0
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_SET) + 2, sizeof(char));
-    if (response == NULL)
-    {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
-    }
-    sprintf(response, "%s%s%c", HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, param);
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM "%c"), HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, param);
     
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_A_TO_B_MODE, argument, response, HM1X_DEFAULT_TIMEOUT);
     
-    free(command);
-    free(response);
-
     return err;
 }
 
     // AT+AUTH -- Authentication mode
-HM1X_error_t HM1X_BT::enableAuthenticationMode(boolean enable)
+HM1X_error_t HM1X_Core::enableAuthenticationMode(boolean enable)
 {
     HM1X_error_t err;
-    char * command;
-    char * response;
+    char argument[2];
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + 2] = "";
     char param;
 
+    HM1X_REQUIRE(HM1X_CAP_BOND);
+
     // Build command: e.g. AT+ATOB0
-    command = (char *) calloc(strlen(HM1X_COMMAND_AUTHENTICATION_MODE) + 2, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
     param = (enable) ? '1' : '0';
-    sprintf(command, "%s%c", HM1X_COMMAND_AUTHENTICATION_MODE, param);
+    sprintf(argument, "%c", param);
 
     // Build expected response: e.g. OK+Set:0
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_SET) + 2, sizeof(char));
-    if (response == NULL)
-    {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
-    }
-    sprintf(response, "%s%s%c", HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, param);
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM "%c"), HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, param);
 
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_AUTHENTICATION_MODE, argument, response, HM1X_DEFAULT_TIMEOUT);
     
-    free(command);
-    free(response);
-
     return err;
 }
 
 // AT+PINE, AT+PINB -- EDR/BLE PIN Code
-HM1X_error_t HM1X_BT::getEdrPin(char * code)
+HM1X_error_t HM1X_Core::getEdrPin(char * code)
 {
-    char * command;
-    char * response;
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_GET) + 8] = "";
 
-    // Set command string: "AT+PINE?""
-    command = (char *) calloc(strlen(HM1X_COMMAND_EDR_PIN_CODE) + strlen(HM1X_QUERY_STRING) + 1, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
-    sprintf(command, "%s%s", HM1X_COMMAND_EDR_PIN_CODE, HM1X_QUERY_STRING);
+    HM1X_REQUIRE(HM1X_CAP_DUAL_MODE | HM1X_CAP_EDR | HM1X_CAP_BOND);
 
-    response = (char *) calloc(sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_GET) + 8, sizeof(char));
-    if (response == NULL) return HM1X_OUT_OF_MEMORY;
-    
-    sendCommandWithTimeout(command, &response, HM1X_RESPONSE_TIMEOUT);
+    sendCommandWithTimeout(HM1X_COMMAND_EDR_PIN_CODE, HM1X_QUERY_STRING, response, sizeof(response), HM1X_RESPONSE_TIMEOUT);
 
-    strcpy(code, response + (strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_GET)));
+    strcpy(code, response + (strlen_P(HM1X_RESPONSE_OK) + strlen_P(HM1X_RESPONSE_GET)));
 
-    free(response);
-    free(command);
-    
     return HM1X_SUCCESS;    
 }
 
 // AT+PINE, AT+PINB -- EDR/BLE PIN Code
-HM1X_error_t HM1X_BT::getBlePin(char * code)
+HM1X_error_t HM1X_Core::getBlePin(char * code)
 {
-    char * command;
-    char * response;
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_GET) + 8] = "";
 
-    // Set command string: "AT+PINB?""
-    command = (char *) calloc(strlen(HM1X_COMMAND_BLE_PIN_CODE) + strlen(HM1X_QUERY_STRING) + 1, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
-    sprintf(command, "%s%s", HM1X_COMMAND_BLE_PIN_CODE, HM1X_QUERY_STRING);
+    HM1X_REQUIRE(HM1X_CAP_DUAL_MODE | HM1X_CAP_BLE | HM1X_CAP_BOND);
 
-    response = (char *) calloc(sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_GET) + 8, sizeof(char));
-    if (response == NULL) return HM1X_OUT_OF_MEMORY;
-    
-    sendCommandWithTimeout(command, &response, HM1X_RESPONSE_TIMEOUT);
+    sendCommandWithTimeout(HM1X_COMMAND_BLE_PIN_CODE, HM1X_QUERY_STRING, response, sizeof(response), HM1X_RESPONSE_TIMEOUT);
 
-    strcpy(code, response + (strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_GET)));
+    strcpy(code, response + (strlen_P(HM1X_RESPONSE_OK) + strlen_P(HM1X_RESPONSE_GET)));
 
-    free(response);
-    free(command);
-    
     return HM1X_SUCCESS;    
 }
 
-HM1X_error_t HM1X_BT::setEdrPin(char * code)
+HM1X_error_t HM1X_Core::setEdrPin(char * code)
 {
     HM1X_error_t err;
-    char * command;
-    char * response;
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + 8] = "";
+
+    HM1X_REQUIRE(HM1X_CAP_DUAL_MODE | HM1X_CAP_EDR | HM1X_CAP_BOND);
 
     if (strlen(code) > 6) return HM1X_UNEXPECTED_RESPONSE;
     // TODO: Should check if the code is numeric here
 
-    // Build command: e.g. AT+EDR1234
-    command = (char *) calloc(strlen(HM1X_COMMAND_EDR_PIN_CODE) + 8, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
-    sprintf(command, "%s%s", HM1X_COMMAND_EDR_PIN_CODE, code);
-
     // Build expected response: e.g. OK+Set:1234
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_SET) + 8, sizeof(char));
-    if (response == NULL)
-    {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
-    }
-    sprintf(response, "%s%s%s", HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, code);
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM "%s"), HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, code);
 
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_EDR_PIN_CODE, code, response, HM1X_DEFAULT_TIMEOUT);
     
-    free(command);
-    free(response);
-
     return err;
 }
 
-HM1X_error_t HM1X_BT::setBlePin(char * code)
+HM1X_error_t HM1X_Core::setBlePin(char * code)
 {
     HM1X_error_t err;
-    char * command;
-    char * response;
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + 8] = "";
+
+    HM1X_REQUIRE(HM1X_CAP_DUAL_MODE | HM1X_CAP_BLE | HM1X_CAP_BOND);
 
     if (strlen(code) > 6) return HM1X_UNEXPECTED_RESPONSE;
     // TODO: Should check if the code is numeric here
 
-    // Build command: e.g. AT+EDR1234
-    command = (char *) calloc(strlen(HM1X_COMMAND_BLE_PIN_CODE) + 8, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
-    sprintf(command, "%s%s", HM1X_COMMAND_BLE_PIN_CODE, code);
-
     // Build expected response: e.g. OK+Set:1234
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_SET) + 8, sizeof(char));
-    if (response == NULL)
-    {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
-    }
-    sprintf(response, "%s%s%s", HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, code);
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM "%s"), HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, code);
 
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_BLE_PIN_CODE, code, response, HM1X_DEFAULT_TIMEOUT);
     
-    free(command);
-    free(response);
-
     return err;
 }
 
 // AT+COFD -- Class of device
 // Can set to any value between 0x000000 to 0xFFFFFE
-HM1X_error_t HM1X_BT::setCod(uint32_t cod)
+HM1X_error_t HM1X_Core::setCod(uint32_t cod)
 {
     HM1X_error_t err;
-    char * command;
-    char * response;
+    char argument[7];
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + 7] = "";
+
+    HM1X_REQUIRE(HM1X_CAP_DUAL_MODE | HM1X_CAP_EDR);
 
     // Build command: e.g. AT+COFD001F00
-    command =(char *) calloc(strlen(HM1X_COMMAND_COD) + 7, sizeof(char));
-    sprintf(command, "%s%06X", HM1X_COMMAND_COD, cod);
+    sprintf(argument, "%06X", cod);
 
     // Build expected response: e.g. OK+Set:0
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_SET) + 7, sizeof(char));
-    if (response == NULL)
-    {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
-    }
-    sprintf(response, "%s%s%06X", HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, cod);
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM "%06X"), HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, cod);
 
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_COD, argument, response, HM1X_DEFAULT_TIMEOUT);
     
-    free(command);
-    free(response);
-
     return err;
 }
 
 // AT+COUP -- Update connection parameter
 // Only usable in  BLE slave mode. Updates min/max interval, slave latency, and connection supervised timeout
-HM1X_error_t HM1X_BT::enableUpdateConnectionParameter(boolean enable)
+HM1X_error_t HM1X_Core::enableUpdateConnectionParameter(boolean enable)
 {
     HM1X_error_t err;
-    char * command;
-    char * response;
+    char argument[2];
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + 2] = "";
     char param;
 
+    HM1X_REQUIRE(HM1X_CAP_BLE);
+
     // Build command: e.g. AT+COUP1
-    command = (char *) calloc(strlen(HM1X_COMMAND_UPDATE_CON_PARAM) + 2, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
     param = (enable) ? '1' : '0';
-    sprintf(command, "%s%c", HM1X_COMMAND_UPDATE_CON_PARAM, param);
+    sprintf(argument, "%c", param);
 
     // Build expected response: e.g. OK+Set:0
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_SET) + 2, sizeof(char));
-    if (response == NULL)
-    {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
-    }
-    sprintf(response, "%s%s%c", HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, param);
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM "%c"), HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, param);
 
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_UPDATE_CON_PARAM, argument, response, HM1X_DEFAULT_TIMEOUT);
     
-    free(command);
-    free(response);
-
     return err;
 }
 
-boolean HM1X_BT::iBeacon(boolean enable)
+boolean HM1X_Core::iBeacon(boolean enable)
 {
     if (enableiBeacon(enable) == HM1X_SUCCESS)
     {
@@ -1580,75 +1202,63 @@ boolean HM1X_BT::iBeacon(boolean enable)
 }
 
 // AT+IBEA -- Enable iBeacon
-HM1X_error_t HM1X_BT::enableiBeacon(boolean enabled)
+HM1X_error_t HM1X_Core::enableiBeacon(boolean enabled)
 {
     HM1X_error_t err;
-    char * command;
-    char * response;
+    char argument[2];
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + 2] = "";
     char param;
 
+    HM1X_REQUIRE(HM1X_CAP_IBEACON);
+
     // Build command: e.g. AT+IBEA1
-    command = (char *) calloc(strlen(HM1X_COMMAND_IBEACON_SWITCH) + 2, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
     param = (enabled) ? '1' : '0';
-    sprintf(command, "%s%c", HM1X_COMMAND_IBEACON_SWITCH, param);
+    sprintf(argument, "%c", param);
 
     // Build expected response: e.g. OK+Set:1
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_SET) + 2, sizeof(char));
-    if (response == NULL)
-    {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
-    }
-    sprintf(response, "%s%s%c", HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, param);
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM "%c"), HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, param);
 
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_IBEACON_SWITCH, argument, response, HM1X_DEFAULT_TIMEOUT);
     
-    free(command);
-    free(response);
-
     return err;
 }
 
-String HM1X_BT::getiBeaconUUID(void)
+#ifndef HM1X_NO_HEAP
+String HM1X_Core::getiBeaconUUID(void)
 {
-    char * uuid;
-    uuid = (char *) calloc(33, sizeof(char));
+    char uuid[HM1X_UUID_LENGTH + 1];
+
     if (getiBeaconUUID(uuid) == HM1X_SUCCESS)
     {
         return String(uuid);
     }
     return "";
 }
+#endif
 
 // AT+IBE0, AT+IBE1, AT+IBE2, AT+IBE3 -- Get/Set iBeacon UUID
-HM1X_error_t HM1X_BT::getiBeaconUUID(char * uuid)
+HM1X_error_t HM1X_Core::getiBeaconUUID(char * uuid)
 {
     HM1X_error_t err;
-    char * uuidPart;
-    uuidPart = (char *) calloc(8 * 4, sizeof(char));
-    
-    if (uuidPart == NULL) {
-        return HM1X_OUT_OF_MEMORY;
-    }
 
+    // Each part lands in place, NUL-terminating the string so far
     for (int i = 0; i < 4; i++)
     {
-        err = getiBeaconUUID(uuidPart + (i * 8), i);
+        err = getiBeaconUUID(uuid + (i * 8), i);
         if (err != HM1X_SUCCESS)
         {
-            free(uuidPart);
             return err;
         }
     }
-    strcpy(uuid, uuidPart);
     return HM1X_SUCCESS;
 }
 
-HM1X_error_t HM1X_BT::getiBeaconUUID(char * uuid, uint8_t position)
+HM1X_error_t HM1X_Core::getiBeaconUUID(char * uuid, uint8_t position)
 {
-    char * command;
-    char * response;
+    char argument[4];
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_GET) + 10] = "";
+
+    HM1X_REQUIRE(HM1X_CAP_IBEACON);
 
     if (position > 3)
     {
@@ -1656,24 +1266,18 @@ HM1X_error_t HM1X_BT::getiBeaconUUID(char * uuid, uint8_t position)
     }
 
     // Set command string: "AT+IBE<pos>?""
-    command = (char *) calloc(strlen(HM1X_COMMAND_IBEACON_UUID) + strlen(HM1X_QUERY_STRING) + 2, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
-    sprintf(command, "%s%d%s", HM1X_COMMAND_IBEACON_UUID, position, HM1X_QUERY_STRING);
+    sprintf(argument, "%d%s", position, HM1X_QUERY_STRING);
 
-    response = (char *) calloc(sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_GET) + 10, sizeof(char));
-    if (response == NULL) return HM1X_OUT_OF_MEMORY;
-    
-    sendCommandWithTimeout(command, &response, HM1X_RESPONSE_TIMEOUT);
+    sendCommandWithTimeout(HM1X_COMMAND_IBEACON_UUID, argument, response, sizeof(response), HM1X_RESPONSE_TIMEOUT);
 
-    strcpy(uuid, response + (strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_GET)));
+    // 8 hex characters a part
+    strncpy(uuid, response + (strlen_P(HM1X_RESPONSE_OK) + strlen_P(HM1X_RESPONSE_GET)), 8);
+    uuid[8] = 0;
 
-    free(response);
-    free(command);
-    
     return HM1X_SUCCESS;
 }
 
-HM1X_error_t HM1X_BT::setiBeaconUUID(char * first, char * second, char * third, char * fourth)
+HM1X_error_t HM1X_Core::setiBeaconUUID(char * first, char * second, char * third, char * fourth)
 {
     setiBeaconUUID(first, 0);
     setiBeaconUUID(second, 1);
@@ -1681,13 +1285,15 @@ HM1X_error_t HM1X_BT::setiBeaconUUID(char * first, char * second, char * third,
     return setiBeaconUUID(fourth, 3);
 }
 
-HM1X_error_t HM1X_BT::setiBeaconUUID(char * uuid, uint8_t position)
+HM1X_error_t HM1X_Core::setiBeaconUUID(char * uuid, uint8_t position)
 {
     HM1X_error_t err;
-    char * command;
-    char * response;
+    char argument[10];
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + 10] = "";
     char param;
 
+    HM1X_REQUIRE(HM1X_CAP_IBEACON);
+
     if (position > 3)
     {
         return HM1X_UNEXPECTED_RESPONSE;
@@ -1704,74 +1310,49 @@ HM1X_error_t HM1X_BT::setiBeaconUUID(char * uuid, uint8_t position)
     }
 
     // Build command: e.g. AT+IBEA1
-    command = (char *) calloc(strlen(HM1X_COMMAND_IBEACON_UUID) + 10, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
-    sprintf(command, "%s%d%s", HM1X_COMMAND_IBEACON_UUID, position, uuid);
+    sprintf(argument, "%d%s", position, uuid);
 
     // Build expected response: e.g. OK+Set:1
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_SET) + 10, sizeof(char));
-    if (response == NULL)
-    {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
-    }
-    sprintf(response, "%s%s%s", HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, uuid);
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM "%s"), HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, uuid);
 
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
-
-    
-    free(command);
-    free(response);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_IBEACON_UUID, argument, response, HM1X_DEFAULT_TIMEOUT);
 
     return err;
 }
 
 // AT+MAJO, AT+MINO -- iBeacon Major version
-/*HM1X_error_t HM1X_BT::getiBeaconVersions(uint16_t * major, uint16_t * minor)
+/*HM1X_error_t HM1X_Core::getiBeaconVersions(uint16_t * major, uint16_t * minor)
 {
     getiBeaconMajor(major);
     return getiBeaconMinor(minor);
 }
 
-HM1X_error_t HM1X_BT::setiBeaconVersions(uint16_t major, uint16_t minor)
+HM1X_error_t HM1X_Core::setiBeaconVersions(uint16_t major, uint16_t minor)
 {
     setiBeaconMajor(major);
     return setiBeaconMinor(minor);
 }*/
 
-HM1X_error_t HM1X_BT::getiBeaconMajor(uint16_t * version)
+HM1X_error_t HM1X_Core::getiBeaconMajor(uint16_t * version)
 {
-    char * command;
-    char * response;
-    char * hexMajor;
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_GET) + 6] = "";
 
-    // Set command string: "AT+MAJO?""
-    command = (char *) calloc(strlen(HM1X_COMMAND_IBEACON_MAJOR) + strlen(HM1X_QUERY_STRING) + 2, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
-    sprintf(command, "%s%s", HM1X_COMMAND_IBEACON_MAJOR, HM1X_QUERY_STRING);
+    HM1X_REQUIRE(HM1X_CAP_IBEACON);
 
-    response = (char *) calloc(sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_GET) + 6, sizeof(char));
-    if (response == NULL) return HM1X_OUT_OF_MEMORY;
+    sendCommandWithTimeout(HM1X_COMMAND_IBEACON_MAJOR, HM1X_QUERY_STRING, response, sizeof(response), HM1X_RESPONSE_TIMEOUT);
 
-    hexMajor = (char *) malloc(4 * sizeof(char) + 1);
-    if (hexMajor == NULL) return HM1X_OUT_OF_MEMORY;
-    
-    sendCommandWithTimeout(command, &response, HM1X_RESPONSE_TIMEOUT);
-
-    strcpy(hexMajor, response + (strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_GET)));
-    *version = strtol(hexMajor, NULL, 16);
+    *version = strtol(response + (strlen_P(HM1X_RESPONSE_OK) + strlen_P(HM1X_RESPONSE_GET)), NULL, 16);
 
-    free(response);
-    free(command);
-    
     return HM1X_SUCCESS;
 }
 
-HM1X_error_t HM1X_BT::setiBeaconMajor(uint16_t version)
+HM1X_error_t HM1X_Core::setiBeaconMajor(uint16_t version)
 {
     HM1X_error_t err;
-    char * command;
-    char * response;
+    char argument[6];
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + 6] = "";
+
+    HM1X_REQUIRE(HM1X_CAP_IBEACON);
 
     if (version > 0xFFFE) 
     {
@@ -1779,60 +1360,36 @@ HM1X_error_t HM1X_BT::setiBeaconMajor(uint16_t version)
     }
 
     // Build command: e.g. AT+MAJOR0001
-    command = (char *) calloc(strlen(HM1X_COMMAND_IBEACON_MAJOR) + 6, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
-    sprintf(command, "%s%04X", HM1X_COMMAND_IBEACON_MAJOR, version);
+    sprintf(argument, "%04X", version);
 
     // Build expected response: e.g. OK+Set:0001
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_SET) + 6, sizeof(char));
-    if (response == NULL)
-    {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
-    }
-    sprintf(response, "%s%s%04X", HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, version);
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM "%04X"), HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, version);
 
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_IBEACON_MAJOR, argument, response, HM1X_DEFAULT_TIMEOUT);
     
-    free(command);
-    free(response);
-
     return err;
 }
 
-HM1X_error_t HM1X_BT::getiBeaconMinor(uint16_t * version)
+HM1X_error_t HM1X_Core::getiBeaconMinor(uint16_t * version)
 {
-    char * command;
-    char * response;
-    char * hexMinor;
-
-    // Set command string: "AT+MAJO?""
-    command = (char *) calloc(strlen(HM1X_COMMAND_IBEACON_MINOR) + strlen(HM1X_QUERY_STRING) + 2, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
-    sprintf(command, "%s%s", HM1X_COMMAND_IBEACON_MINOR, HM1X_QUERY_STRING);
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_GET) + 6] = "";
 
-    response = (char *) calloc(sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_GET) + 6, sizeof(char));
-    if (response == NULL) return HM1X_OUT_OF_MEMORY;
+    HM1X_REQUIRE(HM1X_CAP_IBEACON);
 
-    hexMinor = (char *) malloc(4 * sizeof(char) + 1);
-    if (hexMinor == NULL) return HM1X_OUT_OF_MEMORY;
-    
-    sendCommandWithTimeout(command, &response, HM1X_RESPONSE_TIMEOUT);
+    sendCommandWithTimeout(HM1X_COMMAND_IBEACON_MINOR, HM1X_QUERY_STRING, response, sizeof(response), HM1X_RESPONSE_TIMEOUT);
 
-    strcpy(hexMinor, response + (strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_GET)));
-    *version = strtol(hexMinor, NULL, 16);
+    *version = strtol(response + (strlen_P(HM1X_RESPONSE_OK) + strlen_P(HM1X_RESPONSE_GET)), NULL, 16);
 
-    free(response);
-    free(command);
-    
     return HM1X_SUCCESS;
 }
 
-HM1X_error_t HM1X_BT::setiBeaconMinor(uint16_t version)
+HM1X_error_t HM1X_Core::setiBeaconMinor(uint16_t version)
 {
     HM1X_error_t err;
-    char * command;
-    char * response;
+    char argument[6];
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + 6] = "";
+
+    HM1X_REQUIRE(HM1X_CAP_IBEACON);
 
     if (version > 0xFFFE) 
     {
@@ -1840,93 +1397,60 @@ HM1X_error_t HM1X_BT::setiBeaconMinor(uint16_t version)
     }
 
     // Build command: e.g. AT+MAJOR0001
-    command = (char *) calloc(strlen(HM1X_COMMAND_IBEACON_MINOR) + 6, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
-    sprintf(command, "%s%04X", HM1X_COMMAND_IBEACON_MINOR, version);
+    sprintf(argument, "%04X", version);
 
     // Build expected response: e.g. OK+Set:0001
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_SET) + 6, sizeof(char));
-    if (response == NULL)
-    {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
-    }
-    sprintf(response, "%s%s%04X", HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, version);
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM "%04X"), HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, version);
 
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_IBEACON_MINOR, argument, response, HM1X_DEFAULT_TIMEOUT);
     
-    free(command);
-    free(response);
-
     return err;
 }
 
 // AT+MEAS -- iBeacon Measured Power
-HM1X_error_t HM1X_BT::getiBeaconPower(uint8_t * power)
+HM1X_error_t HM1X_Core::getiBeaconPower(uint8_t * power)
 {
-    char * command;
-    char * response;
-    char * hexPower;
-
-    // Set command string: "AT+MEAS?""
-    command = (char *) calloc(strlen(HM1X_COMMAND_IBEACON_POWER) + strlen(HM1X_QUERY_STRING) + 2, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
-    sprintf(command, "%s%s", HM1X_COMMAND_IBEACON_POWER, HM1X_QUERY_STRING);
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_GET) + 4] = "";
 
-    response = (char *) calloc(sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_GET) + 4, sizeof(char));
-    if (response == NULL) return HM1X_OUT_OF_MEMORY;
+    HM1X_REQUIRE(HM1X_CAP_IBEACON);
 
-    sendCommandWithTimeout(command, &response, HM1X_RESPONSE_TIMEOUT);
+    sendCommandWithTimeout(HM1X_COMMAND_IBEACON_POWER, HM1X_QUERY_STRING, response, sizeof(response), HM1X_RESPONSE_TIMEOUT);
     
-    hexPower = (char *) malloc(2 * sizeof(char) + 1);
-    if (hexPower == NULL) return HM1X_OUT_OF_MEMORY;
-
-    strcpy(hexPower, response + (strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_GET)));
-    *power = strtol(hexPower, NULL, 16);
+    *power = strtol(response + (strlen_P(HM1X_RESPONSE_OK) + strlen_P(HM1X_RESPONSE_GET)), NULL, 16);
 
-    free(response);
-    free(command);
-    
     return HM1X_SUCCESS;
 }
 
-HM1X_error_t HM1X_BT::setiBeaconPower(uint8_t power)
+HM1X_error_t HM1X_Core::setiBeaconPower(uint8_t power)
 {
-    char * command;
-    char * response;
+    char argument[6];
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + 6] = "";
     HM1X_error_t err;
 
+    HM1X_REQUIRE(HM1X_CAP_IBEACON);
+
     if (power > 255) return HM1X_UNEXPECTED_RESPONSE;
 
     // Build command: e.g. AT+MEASFF
-    command = (char *) calloc(strlen(HM1X_COMMAND_IBEACON_POWER) + 6, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
-    sprintf(command, "%s%2X", HM1X_COMMAND_IBEACON_POWER, power);
+    sprintf(argument, "%2X", power);
 
     // Build expected response: e.g. OK+Set:FF
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_SET) + 6, sizeof(char));
-    if (response == NULL)
-    {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
-    }
-    sprintf(response, "%s%s%2X", HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, power);
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM "%2X"), HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, power);
     
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_IBEACON_POWER, argument, response, HM1X_DEFAULT_TIMEOUT);
     
-    free(command);
-    free(response);
-
     return err;
 }
 
 // AT+MTUS -- MTU Size
-HM1X_error_t HM1X_BT::setMtuSize(HM1X_mtu_size_t mtuSize)
+HM1X_error_t HM1X_Core::setMtuSize(HM1X_mtu_size_t mtuSize)
 {
-    char * command;
-    char * response;
+    char argument[6];
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + 2] = "";
     char param;
     HM1X_error_t err;
+
+    HM1X_REQUIRE(HM1X_CAP_MTU);
     
     if (mtuSize == MTU_SIZE_60)
     {
@@ -1939,44 +1463,26 @@ HM1X_error_t HM1X_BT::setMtuSize(HM1X_mtu_size_t mtuSize)
     else return HM1X_UNEXPECTED_RESPONSE;
 
     // Build command: e.g. AT+MTUS0
-    command = (char *) calloc(strlen(HM1X_COMMAND_MTU_SIZE) + 6, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
-    sprintf(command, "%s%c", HM1X_COMMAND_MTU_SIZE, param);
+    sprintf(argument, "%c", param);
 
     // Build expected response: e.g. OK+Set:0
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_SET) + 2, sizeof(char));
-    if (response == NULL)
-    {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
-    }
-    sprintf(response, "%s%s%c", HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, param);
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM "%c"), HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, param);
     
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_MTU_SIZE, argument, response, HM1X_DEFAULT_TIMEOUT);
     
-    free(command);
-    free(response);
-
     return err;
 }
 
 // AT+SCAN -- EDR Advert type
-HM1X_error_t HM1X_BT::getEdrAdvertType(HM1X_edr_advert_t * type)
+HM1X_error_t HM1X_Core::getEdrAdvertType(HM1X_edr_advert_t * type)
 {
-    char * command;
-    char * response;
-
-    // Set command string: "AT+SCAN?""
-    command = (char *) calloc(strlen(HM1X_COMMAND_ADVERT_TYPE) + strlen(HM1X_QUERY_STRING) + 2, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
-    sprintf(command, "%s%s", HM1X_COMMAND_ADVERT_TYPE, HM1X_QUERY_STRING);
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_GET) + 2] = "";
 
-    response = (char *) calloc(sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_GET) + 2, sizeof(char));
-    if (response == NULL) return HM1X_OUT_OF_MEMORY;
+    HM1X_REQUIRE(HM1X_CAP_DUAL_MODE | HM1X_CAP_EDR);
 
-    sendCommandWithTimeout(command, &response, HM1X_RESPONSE_TIMEOUT);
+    sendCommandWithTimeout(HM1X_COMMAND_ADVERT_TYPE, HM1X_QUERY_STRING, response, sizeof(response), HM1X_RESPONSE_TIMEOUT);
 
-    strcpy(response, response + (strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_GET)));
+    strcpy(response, response + (strlen_P(HM1X_RESPONSE_OK) + strlen_P(HM1X_RESPONSE_GET)));
     if (strcmp(response, "0") == 0)
     {
         *type = DISCOVERY_AND_CONNECTABLE;
@@ -1990,18 +1496,17 @@ HM1X_error_t HM1X_BT::getEdrAdvertType(HM1X_edr_advert_t * type)
         *type = EDR_ADVERT_UNDEFINED;
     }
 
-    free(response);
-    free(command);
-    
     return HM1X_SUCCESS;
 }
 
-HM1X_error_t HM1X_BT::setEdrAdvertType(HM1X_edr_advert_t type)
+HM1X_error_t HM1X_Core::setEdrAdvertType(HM1X_edr_advert_t type)
 {
-    char * command;
-    char * response;
+    char argument[6];
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + 2] = "";
     char param;
     HM1X_error_t err;
+
+    HM1X_REQUIRE(HM1X_CAP_DUAL_MODE | HM1X_CAP_EDR);
     
     if (type == DISCOVERY_AND_CONNECTABLE)
     {
@@ -2014,32 +1519,21 @@ HM1X_error_t HM1X_BT::setEdrAdvertType(HM1X_edr_advert_t type)
     else return HM1X_UNEXPECTED_RESPONSE;
 
     // Build command: e.g. AT+SCAN0
-    command = (char *) calloc(strlen(HM1X_COMMAND_ADVERT_TYPE) + 6, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
-    sprintf(command, "%s%c", HM1X_COMMAND_ADVERT_TYPE, param);
+    sprintf(argument, "%c", param);
 
     // Build expected response: e.g. OK+Set:0
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_SET) + 2, sizeof(char));
-    if (response == NULL)
-    {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
-    }
-    sprintf(response, "%s%s%c", HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, param);
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM "%c"), HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, param);
     
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_ADVERT_TYPE, argument, response, HM1X_DEFAULT_TIMEOUT);
     
-    free(command);
-    free(response);
-
     return err;
 }
 
 // AT+SAFE -- Module safe mode
-HM1X_error_t HM1X_BT::enableSafeMode(boolean enabled)
+HM1X_error_t HM1X_Core::enableSafeMode(boolean enabled)
 {
-    char * command;
-    char * response;
+    char argument[2];
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + 2] = "";
     char param;
     HM1X_error_t err;
     
@@ -2053,35 +1547,26 @@ HM1X_error_t HM1X_BT::enableSafeMode(boolean enabled)
     }
 
     // Build command: e.g. AT+SAFE0
-    command = (char *) calloc(strlen(HM1X_COMMAND_SAFE_MODE) + 2, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
-    sprintf(command, "%s%c", HM1X_COMMAND_SAFE_MODE, param);
+    sprintf(argument, "%c", param);
 
     // Build expected response: e.g. OK+Set:0
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_SET) + 2, sizeof(char));
-    if (response == NULL)
-    {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
-    }
-    sprintf(response, "%s%s%c", HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, param);
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM "%c"), HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, param);
     
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_SAFE_MODE, argument, response, HM1X_DEFAULT_TIMEOUT);
     
-    free(command);
-    free(response);
-
     return err;
 }
 
 // AT+ONEM -- Whether to use BLE MAC address
 // Note: If you want to use BLE in Android, don't use this command :S
-HM1X_error_t HM1X_BT::disableBleAddress(boolean disabled)
+HM1X_error_t HM1X_Core::disableBleAddress(boolean disabled)
 {
-    char * command;
-    char * response;
+    char argument[2];
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + 2] = "";
     char param;
     HM1X_error_t err;
+
+    HM1X_REQUIRE(HM1X_CAP_DUAL_MODE | HM1X_CAP_BLE);
     
     if (disabled)
     {
@@ -2093,34 +1578,25 @@ HM1X_error_t HM1X_BT::disableBleAddress(boolean disabled)
     }
 
     // Build command: e.g. AT+ONEM0
-    command = (char *) calloc(strlen(HM1X_COMMAND_BLE_MAC) + 2, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
-    sprintf(command, "%s%c", HM1X_COMMAND_BLE_MAC, param);
+    sprintf(argument, "%c", param);
 
     // Build expected response: e.g. OK+Set:0
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_SET) + 2, sizeof(char));
-    if (response == NULL)
-    {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
-    }
-    sprintf(response, "%s%s%c", HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, param);
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM "%c"), HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, param);
     
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_BLE_MAC, argument, response, HM1X_DEFAULT_TIMEOUT);
     
-    free(command);
-    free(response);
-
     return err;
 }
 
 // AT+PIO0 -- Enable system key function on PIO0
-HM1X_error_t HM1X_BT::enableSystemKey(boolean enabled)
+HM1X_error_t HM1X_Core::enableSystemKey(boolean enabled)
 {
-    char * command;
-    char * response;
+    char argument[2];
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + 2] = "";
     char param;
     HM1X_error_t err;
+
+    HM1X_REQUIRE(HM1X_CAP_PIO);
     
     if (enabled)
     {
@@ -2132,34 +1608,25 @@ HM1X_error_t HM1X_BT::enableSystemKey(boolean enabled)
     }
 
     // Build command: e.g. AT+PIO01
-    command = (char *) calloc(strlen(HM1X_COMMAND_SYSTEM_KEY) + 2, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
-    sprintf(command, "%s%c", HM1X_COMMAND_SYSTEM_KEY, param);
+    sprintf(argument, "%c", param);
 
     // Build expected response: e.g. OK+Set:1
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_SET) + 2, sizeof(char));
-    if (response == NULL)
-    {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
-    }
-    sprintf(response, "%s%s%c", HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, param);
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM "%c"), HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, param);
     
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_SYSTEM_KEY, argument, response, HM1X_DEFAULT_TIMEOUT);
     
-    free(command);
-    free(response);
-
     return err;
 }
 
 // AT+POIO1 -- System LED, PIO1 control
-HM1X_error_t HM1X_BT::setLedMode(HM1X_led_mode_t mode)
+HM1X_error_t HM1X_Core::setLedMode(HM1X_led_mode_t mode)
 {
-    char * command;
-    char * response;
+    char argument[2];
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + 2] = "";
     char param;
     HM1X_error_t err;
+
+    HM1X_REQUIRE(HM1X_CAP_PIO);
     
     if (mode == BLINK_DISCONNECTED)
     {
@@ -2171,49 +1638,35 @@ HM1X_error_t HM1X_BT::setLedMode(HM1X_led_mode_t mode)
     }
 
     // Build command: e.g. AT+PIO11
-    command = (char *) calloc(strlen(HM1X_COMMAND_SYSTEM_LED) + 2, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
-    sprintf(command, "%s%c", HM1X_COMMAND_SYSTEM_LED, param);
+    sprintf(argument, "%c", param);
 
     // Build expected response: e.g. OK+Set:1
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_SET) + 2, sizeof(char));
-    if (response == NULL)
-    {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
-    }
-    sprintf(response, "%s%s%c", HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, param);
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM "%c"), HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, param);
     
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_SYSTEM_LED, argument, response, HM1X_DEFAULT_TIMEOUT);
     
-    free(command);
-    free(response);
-
     return err;
 }
 
 // AT+PIO -- Write/query PIO
-HM1X_error_t HM1X_BT::readPio(uint8_t pin, uint8_t * value)
+HM1X_error_t HM1X_Core::readPio(uint8_t pin, uint8_t * value)
 {
-    char * command;
-    char * response;
+    char argument[4];
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_GET) + 2] = "";
+
+    HM1X_REQUIRE(HM1X_CAP_PIO);
 
-    if ((pin != 2) && (pin != 3))
+    if (!supportsPio(pin))
     {
         return HM1X_UNEXPECTED_RESPONSE;
     }
 
-    // Set command string: "AT+PIO21""
-    command = (char *) calloc(strlen(HM1X_COMMAND_PIO_STATUS) + strlen(HM1X_QUERY_STRING) + 3, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
-    sprintf(command, "%s%d%s", HM1X_COMMAND_PIO_STATUS, pin, HM1X_QUERY_STRING);
-
-    response = (char *) calloc(sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_GET) + 2, sizeof(char));
-    if (response == NULL) return HM1X_OUT_OF_MEMORY;
+    // Set command string: "AT+PIO2?" -- pins above 9 are PIOA, PIOB
+    sprintf(argument, "%X%s", pin, HM1X_QUERY_STRING);
 
-    sendCommandWithTimeout(command, &response, HM1X_RESPONSE_TIMEOUT);
+    sendCommandWithTimeout(HM1X_COMMAND_PIO_STATUS, argument, response, sizeof(response), HM1X_RESPONSE_TIMEOUT);
 
-    strcpy(response, response + (strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_GET)));
+    strcpy(response, response + (strlen_P(HM1X_RESPONSE_OK) + strlen_P(HM1X_RESPONSE_GET)));
     
     if (strcmp(response, "0") == 0)
     {
@@ -2228,125 +1681,244 @@ HM1X_error_t HM1X_BT::readPio(uint8_t pin, uint8_t * value)
         return HM1X_UNEXPECTED_RESPONSE;
     }
 
-    free(response);
-    free(command);
-    
     return HM1X_SUCCESS;
 }
 
-HM1X_error_t HM1X_BT::writePio(uint8_t pin, uint8_t value)
+HM1X_error_t HM1X_Core::writePio(uint8_t pin, uint8_t value)
 {
-    char * command;
-    char * response;
+    char argument[4];
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + 2] = "";
     HM1X_error_t err;
     uint8_t writeVal = value;
 
-    if ((pin != 2) && (pin != 3))
+    HM1X_REQUIRE(HM1X_CAP_PIO);
+
+    if (!supportsPio(pin))
     {
         return HM1X_UNEXPECTED_RESPONSE;
     }
     if (writeVal >= 1) writeVal = 1;
 
-    // Build command: e.g. AT+PIO21
-    command = (char *) calloc(strlen(HM1X_COMMAND_PIO_STATUS) + 4, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
-    sprintf(command, "%s%d%d", HM1X_COMMAND_PIO_STATUS, pin, writeVal);
+    // Build command: e.g. AT+PIO21, AT+PIOB0
+    sprintf(argument, "%X%d", pin, writeVal);
 
     // Build expected response: e.g. OK+Set:11
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_SET) + 2, sizeof(char));
-    if (response == NULL)
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM "%d"), HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, value);
+    
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_PIO_STATUS, argument, response, HM1X_DEFAULT_TIMEOUT);
+    
+    return err;
+}
+
+HM1X_error_t HM1X_Core::setBaud(HM1X_baud_t atob)
+{
+    HM1X_error_t err;
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + 2] = "";
+    char baudChar[2];
+
+    if ((atob == HM1X_BAUD_INVALID) || (atob >= NUM_HM1X_BAUDS))
     {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
+        return HM1X_UNEXPECTED_RESPONSE;
+    }
+    baudChar[0] = btBaudCodes[_modelInfo->baudCodes][atob];
+    baudChar[1] = '\0';
+    if (baudChar[0] == 0)
+    {
+        return HM1X_ERROR_UNSUPPORTED;
+    }
+
+    // Build expected response: e.g. OK+Set:2
+    strcat_P(response, HM1X_RESPONSE_OK);
+    strcat_P(response, HM1X_RESPONSE_SET);
+    strcat(response, baudChar);
+
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_BAUD, baudChar, response, HM1X_DEFAULT_TIMEOUT);
+    if (err == HM1X_SUCCESS)
+    {
+        _baud = btBauds[atob]; // Takes effect on next reset
     }
-    sprintf(response, "%s%s%d", HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, value);
-    
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
     
-    free(command);
-    free(response);
+    return err;
+}
+
+HM1X_error_t HM1X_Core::setBaud(uint32_t baud)
+{
+    HM1X_baud_t index = baudIndex(baud);
 
+    if (index == HM1X_BAUD_INVALID)
+    {
+        return HM1X_UNEXPECTED_RESPONSE;
+    }
+    return setBaud(index);
+}
+
+const HM1X_Core::HM1X_model_info_t * HM1X_Core::modelInfo(HM1X_model_t model)
+{
+    if (model >= NUM_HM_MODELS)
+    {
+        return NULL;
+    }
+    return &btModels[model];
+}
+
+boolean HM1X_Core::supportsBaud(unsigned long baud)
+{
+    return (btBaudCodes[_modelInfo->baudCodes][baudIndex(baud)] != 0);
+}
+
+boolean HM1X_Core::supportsPio(uint8_t pin)
+{
+    return ((pin < 16) && (_modelInfo->pioPins & (1 << pin)));
+}
+
+HM1X_Core::HM1X_baud_t HM1X_Core::baudIndex(unsigned long baud)
+{
+    for (uint8_t i = HM1X_BAUD_4800; i < NUM_HM1X_BAUDS; i++)
+    {
+        if (btBauds[i] == (long) baud)
+        {
+            return (HM1X_baud_t) i;
+        }
+    }
+    return HM1X_BAUD_INVALID;
+}
+
+// AT+FIOW -- Hardware flow control
+HM1X_error_t HM1X_Core::enableFlowControl(boolean enabled)
+{
+    HM1X_error_t err;
+    char argument[2];
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + 2] = "";
+    char param;
+
+    HM1X_REQUIRE(HM1X_CAP_FLOW_CONTROL);
+
+    // Build command: e.g. AT+FIOW1
+    param = (enabled) ? '1' : '0';
+    sprintf(argument, "%c", param);
+
+    // Build expected response: e.g. OK+Set:1
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM "%c"), HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, param);
+
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_FLOW_CONTROL, argument, response, HM1X_DEFAULT_TIMEOUT);
+    
     return err;
 }
 
-HM1X_error_t HM1X_BT::setBaud(HM1X_baud_t atob)
+// AT+STOP -- Stop bits
+HM1X_error_t HM1X_Core::setStopBits(HM1X_stop_bits_t stopBits)
 {
     HM1X_error_t err;
-    char * command;
-    char * response;
-    char * hsParam;
-    char * baudChar;
+    char argument[2];
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + 2] = "";
+    char param;
 
-    if ((atob == HM1X_BAUD_INVALID) || (atob >= NUM_HM1X_BAUDS))
+    HM1X_REQUIRE(HM1X_CAP_FRAMING);
+
+    if ((stopBits != HM1X_STOP_BITS_1) && (stopBits != HM1X_STOP_BITS_2))
+    {
+        return HM1X_UNEXPECTED_RESPONSE;
+    }
+    // Only a host port with framing control can follow the module off of 8N1
+    if ((stopBits != HM1X_STOP_BITS_1) && !hwFramingSupported())
     {
         return HM1X_UNEXPECTED_RESPONSE;
     }
 
-    command = (char *) calloc(strlen(HM1X_COMMAND_BAUD) + 2, sizeof(char));
-    if (command == NULL) return HM1X_OUT_OF_MEMORY;
+    // Build command: e.g. AT+STOP1
+    param = (stopBits == HM1X_STOP_BITS_2) ? '1' : '0';
+    sprintf(argument, "%c", param);
 
-    // Build command: e.g. AT+BAUD2
-    switch (atob)
+    // Build expected response: e.g. OK+Set:1
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM "%c"), HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, param);
+
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_STOP_BITS, argument, response, HM1X_DEFAULT_TIMEOUT);
+    if (err == HM1X_SUCCESS)
     {
-        case HM1X_BAUD_4800:
-            baudChar = "1";
-            break;
-        case HM1X_BAUD_9600:
-            baudChar = "2";
-            break;
-        case HM1X_BAUD_19200:
-            baudChar = "3";
-            break;
-        case HM1X_BAUD_38400:
-            baudChar = "4";
-            break;
-        case HM1X_BAUD_57600:
-            baudChar = "5";
+        _stopBits = stopBits; // Takes effect on next reset
+    }
+    
+    return err;
+}
+
+// AT+PARI -- Parity bit
+HM1X_error_t HM1X_Core::setParity(HM1X_parity_t parity)
+{
+    HM1X_error_t err;
+    char argument[2];
+    char response[sizeof(HM1X_RESPONSE_OK) + sizeof(HM1X_RESPONSE_SET) + 2] = "";
+    char param;
+
+    HM1X_REQUIRE(HM1X_CAP_FRAMING);
+
+    switch (parity)
+    {
+        case HM1X_PARITY_NONE:
+            param = '0';
             break;
-        case HM1X_BAUD_115200:
-            baudChar = "6";
+        case HM1X_PARITY_EVEN:
+            param = '1';
             break;
-        case HM1X_BAUD_230400:
-            baudChar = "7";
+        case HM1X_PARITY_ODD:
+            param = '2';
             break;
         default:
-            baudChar = "2";
-            break;
+            return HM1X_UNEXPECTED_RESPONSE;
     }
-    strcpy(command, HM1X_COMMAND_BAUD);
-    strcat(command, baudChar);
-
-    // Build expected response: e.g. OK+Set:2
-    response = (char *) calloc(strlen(HM1X_RESPONSE_OK) + strlen(HM1X_RESPONSE_SET) + 2, sizeof(char));
-    if (response == NULL)
+    // Only a host port with framing control can follow the module off of 8N1
+    if ((parity != HM1X_PARITY_NONE) && !hwFramingSupported())
     {
-        free(command);
-        return HM1X_OUT_OF_MEMORY;
+        return HM1X_UNEXPECTED_RESPONSE;
     }
-    strcat(response, HM1X_RESPONSE_OK);
-    strcat(response, HM1X_RESPONSE_SET);
-    strcat(response, baudChar);
 
-    err = sendCommandWithResponseAndTimeout(command, response, HM1X_DEFAULT_TIMEOUT);
-    
-    free(command);
-    free(response);
+    // Build command: e.g. AT+PARI1
+    sprintf(argument, "%c", param);
+
+    // Build expected response: e.g. OK+Set:1
+    sprintf_P(response, PSTR(HM1X_PGM HM1X_PGM "%c"), HM1X_RESPONSE_OK, HM1X_RESPONSE_SET, param);
 
+    err = sendCommandWithResponseAndTimeout(HM1X_COMMAND_PARITY_BIT, argument, response, HM1X_DEFAULT_TIMEOUT);
+    if (err == HM1X_SUCCESS)
+    {
+        _parity = parity; // Takes effect on next reset
+    }
+    
     return err;
 }
 
+void HM1X_Core::setCtsPin(int pin)
+{
+    _ctsPin = pin;
+    if (_ctsPin >= 0)
+    {
+        pinMode(_ctsPin, INPUT);
+    }
+}
+
+void HM1X_Core::setFlowControlCallback(HM1X_cts_callback_t clearToSend, void * context)
+{
+    _ctsCallback = clearToSend;
+    _ctsContext = context;
+}
+
+void HM1X_Core::setWritePacing(uint8_t burstSize, uint16_t burstDelayUs)
+{
+    _paceBurstSize = burstSize;
+    _paceBurstDelay = burstDelayUs;
+}
+
 /////////////
 // Private //
 /////////////
 
-HM1X_error_t HM1X_BT::init(void)
+HM1X_error_t HM1X_Core::init(void)
 {
     HM1X_error_t err;  
 
     err = testOrDisconnect();
     if (err != HM1X_SUCCESS)
     {
-        delay(500); // AT may only disconnecte and not return "OK" response
+        HM1X_Clock::wait(500); // AT may only disconnecte and not return "OK" response
         err = testOrDisconnect();
         if (err != HM1X_SUCCESS) 
         {
@@ -2359,27 +1931,30 @@ HM1X_error_t HM1X_BT::init(void)
     return err;
 }
 
-HM1X_error_t HM1X_BT::sendCommandWithResponseAndTimeout(const char * command, char * expectedResponse, uint16_t commandTimeout)
+HM1X_error_t HM1X_Core::sendCommandWithResponseAndTimeout(const char * command, const char * argument, char * expectedResponse, uint16_t commandTimeout)
 {
-    unsigned long timeIn = millis();
-    char * response;
+    unsigned long timeIn = HM1X_Clock::now();
+    char response[HM1X_RESPONSE_LENGTH];
+    int avail;
 
-    sendCommand(command);
+    sendCommand(command, argument);
 
     // Wait until we've receved the requested number of characters
     while (hwAvailable() < strlen(expectedResponse))
     {
-        if (millis() > timeIn + commandTimeout)
+        if (HM1X_Clock::elapsed(timeIn) > commandTimeout)
         {
             return HM1X_ERROR_TIMEOUT;
         }
+        HM1X_Clock::idle();
     }
-    response = (char *) calloc(hwAvailable() + 1, sizeof(char));
-    if (response == NULL)
+    avail = hwAvailable();
+    avail -= readAvailable(response, sizeof(response) - 1);
+    // Anything that didn't fit can't match -- drop it with the rest
+    while (avail-- > 0)
     {
-        return HM1X_OUT_OF_MEMORY;
+        readChar();
     }
-    readAvailable(response);
     
     // Check for expected response
     if (strcmp(response, expectedResponse) == 0)
@@ -2392,112 +1967,219 @@ HM1X_error_t HM1X_BT::sendCommandWithResponseAndTimeout(const char * command, ch
     }
 }
 
-int HM1X_BT::sendCommandWithTimeout(const char * command, char ** responseDest, uint16_t commandTimeout)
+int HM1X_Core::sendCommandWithTimeout(const char * command, const char * argument, char * response, size_t size, uint16_t commandTimeout)
 {
-    unsigned long timeIn = millis();
-    char * response;
+    unsigned long timeIn = HM1X_Clock::now();
+    int avail;
     int retVal = 0;
 
-    sendCommand(command);
+    sendCommand(command, argument);
 
     // Wait for timeout to occur
     // TODO: Should this also check for an overflow of the serial buffer?
-    while (millis() < timeIn + commandTimeout)
-        ;
+    while (HM1X_Clock::elapsed(timeIn) < commandTimeout)
+    {
+        HM1X_Clock::idle();
+    }
 
-    // Read data into the response string
-    // TODO: Isn't it on the calling function to allocate memory for this read?
-    response = (char *) calloc(hwAvailable() + 1, sizeof(char));
-    if (response == NULL)
+    // Read data into the caller's response buffer, dropping what won't fit
+    avail = hwAvailable();
+    retVal = readAvailable(response, size - 1);
+    avail -= retVal;
+    while (avail-- > 0)
     {
-        return 0;
+        readChar();
     }
-    retVal = readAvailable(response);
-    strcpy(*responseDest, response);
     return retVal;
 }
 
-boolean HM1X_BT::sendCommand(const char * command)
+// Copy the value out of an OK+Get:<value> response into a caller's buffer
+// of maxLength + 1. A longer value (garbled, or not what was asked for)
+// is rejected rather than overrunning it.
+HM1X_error_t HM1X_Core::copyResponseValue(char * value, const char * response, size_t maxLength)
 {
-    if (strlen(command) == 0) // If string is not null it will include "+"
+    size_t prefixLength = strlen_P(HM1X_RESPONSE_OK) + strlen_P(HM1X_RESPONSE_GET);
+    size_t length = strlen(response);
+
+    value[0] = 0;
+    if (length <= prefixLength)
     {
-        hwPrint(HM1X_COMMAND_AT);
-        return true;
+        return HM1X_SUCCESS; // Nothing reported
     }
-    else
+    if (length - prefixLength > maxLength)
+    {
+        return HM1X_UNEXPECTED_RESPONSE;
+    }
+    strcpy(value, response + prefixLength);
+    return HM1X_SUCCESS;
+}
+
+HM1X_error_t HM1X_Core::sendCommandAndWaitFor(const char * command, const char * argument, const char * expectedResponse, uint16_t commandTimeout)
+{
+    unsigned long timeIn = HM1X_Clock::now();
+    size_t length = strlen(expectedResponse);
+    size_t matched = 0;
+    char c;
+
+    sendCommand(command, argument);
+
+    // Match it character by character, so nothing after it is consumed
+    while (matched < length)
     {
-        char * commandToSend;
-        commandToSend = (char *) calloc(strlen(HM1X_COMMAND_AT) + strlen(command) + 2, sizeof(char));
-        if (commandToSend == NULL)
+        if (hwAvailable() > 0)
         {
-            return false;
+            c = readChar();
+            if (c == expectedResponse[matched])
+            {
+                matched++;
+            }
+            else
+            {
+                matched = (c == expectedResponse[0]) ? 1 : 0;
+            }
+        }
+        else if (HM1X_Clock::elapsed(timeIn) > commandTimeout)
+        {
+            return HM1X_ERROR_TIMEOUT;
+        }
+        else
+        {
+            HM1X_Clock::idle();
         }
-        strcpy(commandToSend, HM1X_COMMAND_AT);
-        strcat(commandToSend, "+");
-        strcat(commandToSend, command);
+    }
+    return HM1X_SUCCESS;
+}
 
-        hwPrint(commandToSend);
-        free(commandToSend);
+boolean HM1X_Core::sendCommand(const char * command, const char * argument)
+{
+    char chunk[HM1X_COMMAND_CHUNK_LENGTH];
+    size_t len;
+    char c;
+
+    strcpy_P(chunk, HM1X_COMMAND_AT);
+    len = strlen_P(HM1X_COMMAND_AT);
+    if (command == NULL) // Just "AT"
+    {
+        return (hwWrite(chunk, len) == len);
     }
+    chunk[len++] = '+';
 
-    return true;
+    // Copy the command out of flash and the argument out of RAM, a chunk at
+    // a time, so neither is ever held whole in SRAM
+    for (const char * p = command; (c = pgm_read_byte(p)) != 0; p++)
+    {
+        if (len == sizeof(chunk))
+        {
+            if (hwWrite(chunk, len) != len) return false;
+            len = 0;
+        }
+        chunk[len++] = c;
+    }
+    for (const char * p = argument; (p != NULL) && (*p != 0); p++)
+    {
+        if (len == sizeof(chunk))
+        {
+            if (hwWrite(chunk, len) != len) return false;
+            len = 0;
+        }
+        chunk[len++] = *p;
+    }
+    return (hwWrite(chunk, len) == len);
 }
 
-/*void HM1X_BT::hwFlush(void)
+/*void HM1X_Core::hwFlush(void)
 {
     readAvailable();
 }*/
 
-size_t HM1X_BT::hwPrint(const char * s)
+size_t HM1X_Core::hwPrint(const char * s)
 {
-    if (0)
-    {
+    return hwWrite(s, strlen(s));
+}
 
-    }
-#ifdef HM1X_SOFTWARE_SERIAL_ENABLED
-    else if (_softSerial != NULL)
+size_t HM1X_Core::hwPacedWrite(Print * port, const char * buffer, size_t size)
+{
+    size_t written = 0;
+    uint8_t burst = 0;
+
+    // No pacing configured -- hand the whole buffer to the port
+    if (!hwPacing())
     {
-        return _softSerial->print(s);
+        return port->write((const uint8_t *) buffer, size);
     }
-#endif
-#ifdef HM1X_HARDWARE_SERIAL_ENABLED
-    else if (_serialPort != NULL)
+
+    while (written < size)
     {
-        return _serialPort->print(s);
+        if (!hwClearToSend())
+        {
+            break; // Module never released CTS, report what made it out
+        }
+        written += port->write((uint8_t) buffer[written]);
+        if ((_paceBurstSize > 0) && (++burst >= _paceBurstSize))
+        {
+            burst = 0;
+            delayMicroseconds(_paceBurstDelay);
+        }
     }
-#endif
-#ifdef HM1X_I2C_ENABLED
-    else if (_wirePort != NULL)
+    return written;
+}
+
+boolean HM1X_Core::hwClearToSend(void)
+{
+    unsigned long timeIn;
+
+    if (_ctsCallback != NULL)
     {
-        int charsToWrite = strlen(s);
-        int charsWritten = 0;
-        // ATtiny85 can only read/write 14 bytes at a time via I2C
-        // Need to split >14 writes into multiple transmissions
-        while (charsToWrite > 0)
+        timeIn = HM1X_Clock::now();
+        while (!_ctsCallback(_ctsContext))
         {
-            int toWrite;
-            if (charsToWrite > 14) toWrite = 14;
-            else toWrite = charsToWrite;
-            
-            _wirePort->beginTransmission(_wireAddress);
-            _wirePort->write(I2C_CMD_WRITE);
-            for (int i = 0; i < toWrite; i++)
+            if (HM1X_Clock::elapsed(timeIn) > HM1X_DEFAULT_TIMEOUT)
             {
-                _wirePort->write(s[i + charsWritten]);
+                return false;
             }
-            _wirePort->endTransmission(true);
-            charsToWrite -= toWrite;
-            charsWritten += toWrite;
+            HM1X_Clock::idle();
         }
-        return charsWritten;
     }
-#endif
-    return 0;
+
+    if (_ctsPin < 0)
+    {
+        return true;
+    }
+
+    // CTS is active low -- wait for the module to drain its buffer
+    timeIn = HM1X_Clock::now();
+    while (digitalRead(_ctsPin) != LOW)
+    {
+        if (HM1X_Clock::elapsed(timeIn) > HM1X_DEFAULT_TIMEOUT)
+        {
+            return false;
+        }
+        HM1X_Clock::idle();
+    }
+    return true;
 }
 
-int HM1X_BT::readAvailable(char * inString)
+int HM1X_Core::readAvailable(char * inString, int size)
 {
+    // Take what's available now, up to size bytes (inString holds size + 1)
+    int avail = hwAvailable();
     int len = 0;
+
+    if (avail > size)
+    {
+        avail = size;
+    }
+    while (len < avail)
+    {
+        inString[len++] = readChar();
+    }
+    inString[len] = 0;
+
+    return len;
+}
+
+size_t HM1X_BT::hwWrite(const char * buffer, size_t size)
+{
     if (0)
     {
 
@@ -2505,59 +2187,31 @@ int HM1X_BT::readAvailable(char * inString)
 #ifdef HM1X_SOFTWARE_SERIAL_ENABLED
     else if (_softSerial != NULL)
     {
-        while (_softSerial->available())
-        {
-            char c = (char)_softSerial->read();
-            inString[len++] = c;
-        }
-        inString[len] = 0;
+        return hwPacedWrite(_softSerial, buffer, size);
     }
 #endif
 #ifdef HM1X_HARDWARE_SERIAL_ENABLED
     else if (_serialPort != NULL)
     {
-        while (_serialPort->available())
-        {
-            char c = (char)_serialPort->read();
-            inString[len++] = c;
-        }
-        inString[len] = 0;
+        return hwPacedWrite(_serialPort, buffer, size);
     }
 #endif
 #ifdef HM1X_I2C_ENABLED
-    else if (_wirePort != NULL)
+    else if (_bridge.attached())
     {
-        int avail = hwAvailable();
-        int bytesToRead;
-        // I2C on the Tiny can only write out 14(?) bytes at a time.
-        // If there are more than 14 bytes to read, loop through
-        while (avail > 0)
-        {
-            if (avail > 14) bytesToRead = 14;
-            else bytesToRead = avail;
-
-            _wirePort->beginTransmission(_wireAddress);
-            _wirePort->write(I2C_CMD_READ);
-            _wirePort->write(bytesToRead);
-            _wirePort->endTransmission(false);
-            _wirePort->requestFrom(_wireAddress, (uint8_t)bytesToRead);
-            for (int i = 0; i < bytesToRead; i++)
-            {
-                char c = (char) _wirePort->read();
-                inString[len++] = c;
-            }
-            avail -= bytesToRead;
-        }
-        inString[len] = 0;
+        return _bridge.write((const uint8_t *) buffer, size);
     }
 #endif
-
-    return len;
+    else if (_stream != NULL)
+    {
+        return hwPacedWrite(_stream, buffer, size);
+    }
+    return (size_t) 0;
 }
 
 char HM1X_BT::readChar(void)
 {
-    char ret;
+    char ret = (char) -1;
 
     if (0)
     {
@@ -2576,18 +2230,15 @@ char HM1X_BT::readChar(void)
     }
 #endif
 #ifdef HM1X_I2C_ENABLED
-    else if (_wirePort != NULL)
+    else if (_bridge.attached())
     {
-        int avail = hwAvailable();
-
-        _wirePort->beginTransmission(_wireAddress);
-        _wirePort->write(I2C_CMD_READ);
-        _wirePort->write(1);
-        _wirePort->endTransmission(false);
-        _wirePort->requestFrom(_wireAddress, (uint8_t)avail);
-        ret = (char) _wirePort->read();
+        ret = (char)_bridge.read();
     }
 #endif
+    else if (_stream != NULL)
+    {
+        ret = (char)_stream->read();
+    }
 
     return ret;
 }
@@ -2611,101 +2262,101 @@ int HM1X_BT::hwAvailable(void)
     }
 #endif
 #ifdef HM1X_I2C_ENABLED
-    else if (_wirePort != NULL)
+    else if (_bridge.attached())
     {
-        _wirePort->beginTransmission(_wireAddress);
-        _wirePort->write(I2C_CMD_AVAILABLE);
-        _wirePort->endTransmission(false);
-        _wirePort->requestFrom(_wireAddress, (uint8_t)1);
-        int ret = _wirePort->read();
-        return ret;
+        return _bridge.available();
     }
 #endif
+    else if (_stream != NULL)
+    {
+        return _stream->available();
+    }
     return -1;
 }
 
-#ifdef HM1X_I2C_ENABLED
-void HM1X_BT::writeI2cBaud(uint8_t baudIndex)
+void HM1X_BT::hwBegin(unsigned long baud)
 {
-    _wirePort->beginTransmission(_wireAddress);
-    _wirePort->write(I2C_CMD_SET_BAUD);
-    _wirePort->write(baudIndex);
-    _wirePort->endTransmission(true);
-}
-#endif
+    _baud = baud;
 
+    if (0)
+    {
+
+    }
+#ifdef HM1X_SOFTWARE_SERIAL_ENABLED
+    else if (_softSerial != NULL)
+    {
+        _softSerial->begin(baud);
+    }
+#endif
+#ifdef HM1X_HARDWARE_SERIAL_ENABLED
+    else if (_serialPort != NULL)
+    {
+        HM1X_HardwareSerialTransport::begin(*_serialPort, baud, _stopBits, _parity);
+    }
+#endif
 #ifdef HM1X_I2C_ENABLED
-void HM1X_BT::setI2cAddress(uint8_t address)
-{
-    if ((address < 0x08) || (address > 0x77)) {
-        return;
+    else if (_bridge.attached())
+    {
+        HM1X_baud_t index = baudIndex(baud);
+        if (index != HM1X_BAUD_INVALID)
+        {
+            _bridge.setModuleBaud(index);
+        }
+    }
+#endif
+    else if ((_stream != NULL) && (_onBaud != NULL))
+    {
+        _onBaud(baud, _stopBits, _parity, _onBaudContext);
     }
-    _wirePort->beginTransmission(_wireAddress);
-    _wirePort->write(I2C_SET_ADDRESS);
-    _wirePort->write(address);
-    _wirePort->endTransmission(true);
-
 }
+
+boolean HM1X_BT::hwFramingSupported(void)
+{
+#ifdef HM1X_HARDWARE_SERIAL_ENABLED
+    if (_serialPort != NULL)
+    {
+        return true;
+    }
 #endif
+    // The driver's callback is trusted to follow stop bits and parity
+    return ((_stream != NULL) && (_onBaud != NULL));
+}
 
-HM1X_error_t HM1X_BT::forceBaud(unsigned long baud)
+HM1X_error_t HM1X_Core::forceBaud(unsigned long baud)
 {
     switch (baud) {
     case 4800:
-        forceBaud(HM1X_BAUD_4800);
-        break;
+        return forceBaud(HM1X_BAUD_4800);
     case 9600:
-        forceBaud(HM1X_BAUD_9600);
-        break;
+        return forceBaud(HM1X_BAUD_9600);
     case 19200:
-        forceBaud(HM1X_BAUD_19200);
-        break;
+        return forceBaud(HM1X_BAUD_19200);
     case 38400:
-        forceBaud(HM1X_BAUD_38400);
-        break;
+        return forceBaud(HM1X_BAUD_38400);
     case 57600:
-        forceBaud(HM1X_BAUD_57600);
-        break;
+        return forceBaud(HM1X_BAUD_57600);
     case 115200:
-        forceBaud(HM1X_BAUD_115200);
-        break;
+        return forceBaud(HM1X_BAUD_115200);
     case 230400:
-        forceBaud(HM1X_BAUD_230400);
-        break;
+        return forceBaud(HM1X_BAUD_230400);
     default:
         // Do nothing on unsupported baud
         break;
     }
+    return HM1X_UNEXPECTED_RESPONSE;
 }
 
-HM1X_error_t HM1X_BT::forceBaud(HM1X_baud_t baud)
+HM1X_error_t HM1X_Core::forceBaud(HM1X_baud_t baud)
 {    
-    HM1X_error_t err;
+    HM1X_error_t err = HM1X_ERROR_UNSUPPORTED;
 
     for (uint8_t i = HM1X_BAUD_4800; i < NUM_HM1X_BAUDS; i++) 
     {
-        if (0)
-        {
-            
-        }
-#ifdef HM1X_SOFTWARE_SERIAL_ENABLED
-        else if (_softSerial != NULL)
+        if (btBaudCodes[_modelInfo->baudCodes][i] == 0)
         {
-            _softSerial->begin(btBauds[i]);
+            continue; // The module can't be sitting at a rate it doesn't have
         }
-#endif
-#ifdef HM1X_I2C_ENABLED
-        else if (_wirePort != NULL)
-        {
-            writeI2cBaud(i);
-        }
-#endif
-#ifdef HM1X_HARDWARE_SERIAL_ENABLED
-        else if (_serialPort != NULL)
-        {
-            _serialPort->begin(btBauds[i]);
-        }
-#endif
+        hwBegin(btBauds[i]);
         err = setBaud(baud);
         if (err == HM1X_SUCCESS)
         {
@@ -31,47 +31,17 @@
 
 #pragma once
 
-#if (ARDUINO >= 100)
-#include "Arduino.h"
-#else
-#include "WProgram.h"
-#endif
-
-#ifdef ARDUINO_ARCH_AVR               // Arduino AVR boards (Uno, Pro Micro, etc.)
-#define HM1X_SOFTWARE_SERIAL_ENABLED // Enable software serial
-#define HM1X_HARDWARE_SERIAL_ENABLED // Enable hardware serial
-#define HM1X_I2C_ENABLED
-#endif
+#include "HM1X_Config.h"
+#include "HM1X_Clock.h"
+#include "HM1X_QwiicBridge.h"
 
-#ifdef ARDUINO_ARCH_SAMD              // Arduino SAMD boards (SAMD21, etc.)
-#define HM1X_SOFTWARE_SERIAL_ENABLEDx // Disable software serial
-#define HM1X_HARDWARE_SERIAL_ENABLED
-#define HM1X_I2C_ENABLED
-#endif
-
-#ifdef HM1X_I2C_ENABLED
-#include <Wire.h>
-#endif
-#ifdef HM1X_SOFTWARE_SERIAL_ENABLED
-#include <SoftwareSerial.h>
-#endif
+#define HM1X_ADDRESS_LENGTH 12 // Hex characters in a Bluetooth address
+#define HM1X_NAME_LENGTH 28    // Longest EDR/BLE name
+#define HM1X_UUID_LENGTH 32    // Hex characters in an iBeacon UUID
 
-#define QWIIC_BLUETOOTH_DEFAULT_ADDRESS 0x1B
-#define QWIIC_BLUETOOTH_JUMPED_ADDRESS 0x1C
-
-typedef enum {
-    HM1X_OUT_OF_MEMORY       = -8,
-    HM1X_RX_OVERFLOW         = -7,
-    HM1X_UNEXPECTED_RESPONSE = -6,
-    HM1X_ERROR_NO_CONNECTION = -5,
-    HM1X_ERROR_TRY_LATER     = -4,
-    HM1X_ERROR_READ_ERROR    = -3,
-    HM1X_ERROR_TIMEOUT       = -2,
-    HM1X_ERROR_ER            = -1,
-    HM1X_SUCCESS             = 0
-} HM1X_error_t;
-
-class HM1X_BT : public Print {
+// AT command layer, shared by every transport. HM1X_BT picks the transport
+// at run time; HM1X_BT_T (HM1X_BT_T.h) fixes it at compile time.
+class HM1X_Core : public Print {
 public:
     
     typedef enum {
@@ -88,27 +58,61 @@ public:
         NUM_HM_MODELS
     } HM1X_model_t;
 
-    HM1X_BT(HM1X_model_t type = HM13);
+    HM1X_Core(HM1X_model_t type = HM13);
+
+    // What a model supports, from its datasheet
+    typedef struct {
+        uint16_t capabilities; // HM1X_CAP_* flags
+        uint8_t baudCodes;     // Index into the AT+BAUD code tables
+        uint16_t pioPins;      // Bit n set: AT+PIOn is available (n in hex: 10 is PIOA)
+    } HM1X_model_info_t;
+
+    static const HM1X_model_info_t * modelInfo(HM1X_model_t model);
+    HM1X_model_t model(void) { return _btModel; };
+    // True if both the model and this build have every group in capability
+    boolean supports(uint16_t capability) {
+        return ((HM1X_CAPABILITIES & capability) == capability) && modelSupports(capability); };
+    boolean modelSupports(uint16_t capability) { return ((_modelInfo->capabilities & capability) == capability); };
+    boolean supportsBaud(unsigned long baud);
+    boolean supportsPio(uint8_t pin);
 
-    // Begin -- initialize BT module and ensure it's connected
-#ifdef HM1X_SOFTWARE_SERIAL_ENABLED
-    boolean begin(SoftwareSerial & softSerial, unsigned long baud = 9600);
-#endif
-#ifdef HM1X_HARDWARE_SERIAL_ENABLED
-    boolean begin(HardwareSerial &serialPort, unsigned long baud = 9600);
-#endif
-#ifdef HM1X_I2C_ENABLED
-    boolean begin(TwoWire &wirePort, uint8_t address);
-#endif
-    
     boolean connected(void) { return (_connectedBle || _connectedEdr);};
     boolean connectedEdr(void) { return _connectedEdr;};
     boolean connectedBle(void) { return _connectedBle;};
+    // Peer address from the last OK+CONN/OK+LOST notification. address
+    // needs HM1X_ADDRESS_LENGTH + 1 bytes.
+    void connectedEdrAddress(char * address) { strcpy(address, _edrAddress);};
+    void connectedBleAddress(char * address) { strcpy(address, _bleAddress);};
+#ifndef HM1X_NO_HEAP
+    String connectedEdrAddress(void) { return String(_edrAddress);};
+    String connectedBleAddress(void) { return String(_bleAddress);};
+#endif
+
+    typedef enum {
+        HM1X_NOTIFY_NONE,
+        HM1X_NOTIFY_INIT,
+        HM1X_NOTIFY_CONNECT_EDR,
+        HM1X_NOTIFY_CONNECT_BLE,
+        HM1X_NOTIFY_DISCONNECT_EDR,
+        HM1X_NOTIFY_DISCONNECT_BLE
+    } HM1X_notification_t;
 
     boolean setupPoll(void);
     boolean poll(void);
+    // After setupPoll(), available()/read() serve poll()'s buffer
+    boolean polling(void) { return _polling; };
+    // Update connection state from a message received while polling.
+    // Returns HM1X_NOTIFY_NONE if it isn't a notification (i.e. it's data).
+    HM1X_notification_t handleNotification(const char * response);
+#ifndef HM1X_NO_HEAP
+    HM1X_notification_t handleNotification(const String & response) { return handleNotification(response.c_str()); };
+#endif
+    // Classify a message without touching any state. address (at least
+    // HM1X_ADDRESS_LENGTH + 1 bytes, may be NULL) gets the peer's address.
+    static HM1X_notification_t parseNotification(const char * message, char * address = NULL);
     int available(void);
     char read(void);
+    size_t readBytes(char * buffer, size_t length);
 
     virtual size_t write(uint8_t c);
     virtual size_t write(const char *str);
@@ -137,21 +141,28 @@ public:
     HM1X_error_t notifyMode(boolean enabled = true);
     HM1X_error_t notify(boolean enabled = true, boolean withAddress = true);
 
-    // AT+NAME, AT+NAMB -- Set EDR/BLE name
+    // AT+NAME, AT+NAMB -- Set EDR/BLE name. Names are up to
+    // HM1X_NAME_LENGTH characters.
+#ifndef HM1X_NO_HEAP
     String getEdrName(void);
-    HM1X_error_t getEdrName(char * name);
     HM1X_error_t setEdrName(String name);
-    HM1X_error_t setEdrName(const char * name);
     String getBleName(void);
-    HM1X_error_t getBleName(char * name);
     HM1X_error_t setBleName(String name);
+#endif
+    HM1X_error_t getEdrName(char * name);
+    HM1X_error_t setEdrName(const char * name);
+    HM1X_error_t getBleName(char * name);
     HM1X_error_t setBleName(const char * name);
 
     // AT+ADDE -- EDR address
+#ifndef HM1X_NO_HEAP
     String edrAddress(void);
+#endif
     HM1X_error_t edrAddress(char * retAddress);
     // AT+ADDB -- BLE address
+#ifndef HM1X_NO_HEAP
     String bleAddress(void);
+#endif
     HM1X_error_t bleAddress(char * retAddress);
 
     // AT+RADE, AT+RADB -- Last connected EDR/BLE address
@@ -182,6 +193,14 @@ public:
     HM1X_error_t getBleMode(HM1X_ble_mode_t * mode);
     HM1X_error_t setBleMode(HM1X_ble_mode_t mode);
 
+    // AT+STARB, AT+STOPB -- Start/stop BLE work. In the central role that's
+    // discovery: the module reports each device it hears, and
+    // HM1X_BleScanner parses the reports. startBleWork() stops reading at
+    // its OK, leaving the reports in the port; stopBleWork() skips any
+    // still arriving.
+    HM1X_error_t startBleWork(void);
+    HM1X_error_t stopBleWork(void);
+
     // AT+HIGH -- Data transmission speed mode
     // Disabled: SPP and BLE speeds balanced
     // Enabled: SPP will go high speed
@@ -221,8 +240,11 @@ public:
     boolean iBeacon(boolean enable = true);
     HM1X_error_t enableiBeacon(boolean enabled = true);
 
-    // AT+IBE0, AT+IBE1, AT+IBE2, AT+IBE3 -- Get/Set iBeacon UUID
+    // AT+IBE0, AT+IBE1, AT+IBE2, AT+IBE3 -- Get/Set iBeacon UUID. A whole
+    // UUID needs HM1X_UUID_LENGTH + 1 bytes, a part 9.
+#ifndef HM1X_NO_HEAP
     String getiBeaconUUID(void);
+#endif
     HM1X_error_t getiBeaconUUID(char * uuid); 
     HM1X_error_t getiBeaconUUID(char * uuid, uint8_t position);
     HM1X_error_t setiBeaconUUID(char * first, char * second, char * third, char * fourth);
@@ -273,7 +295,7 @@ public:
     } HM1X_led_mode_t;
     HM1X_error_t setLedMode(HM1X_led_mode_t mode);
 
-    // AT+PIO -- Write/query PIO
+    // AT+PIO -- Write/query PIO. Pins 10 and 11 are PIOA and PIOB.
     HM1X_error_t readPio(uint8_t pin, uint8_t * value);
     HM1X_error_t writePio(uint8_t pin, uint8_t value);
 
@@ -291,53 +313,192 @@ public:
     } HM1X_baud_t;
     HM1X_error_t setBaud(HM1X_baud_t atob);
     HM1X_error_t setBaud(uint32_t baud);
+    // Table index of a baud rate, HM1X_BAUD_INVALID if the module can't run at it
+    static HM1X_baud_t baudIndex(unsigned long baud);
 
-private:
+    // AT+FIOW -- Hardware flow control
+    // Module holds off its TX on RTS and signals CTS when it can accept data.
+    // Pair with setCtsPin() (or setWritePacing()) so the host honors it.
+    HM1X_error_t enableFlowControl(boolean enabled = true);
+
+    // AT+STOP -- Stop bits
+    typedef enum {
+        HM1X_STOP_BITS_1,
+        HM1X_STOP_BITS_2,
+        HM1X_STOP_BITS_INVALID
+    } HM1X_stop_bits_t;
+    HM1X_error_t setStopBits(HM1X_stop_bits_t stopBits);
+
+    // AT+PARI -- Parity bit
+    typedef enum {
+        HM1X_PARITY_NONE,
+        HM1X_PARITY_EVEN,
+        HM1X_PARITY_ODD,
+        HM1X_PARITY_INVALID
+    } HM1X_parity_t;
+    HM1X_error_t setParity(HM1X_parity_t parity);
+
+    // Host-side pacing
+    // setCtsPin: module CTS output (active low) wired to a GPIO. Writes wait
+    // until it is asserted. Pass -1 to disable.
+    // setWritePacing: write at most burstSize bytes, then pause burstDelayUs.
+    // Pass 0 burstSize to disable.
+    void setCtsPin(int pin);
+    void setWritePacing(uint8_t burstSize, uint16_t burstDelayUs);
+    // setFlowControlCallback: for drivers that track CTS themselves. Writes
+    // wait until clearToSend(context) returns true. Pass NULL to disable.
+    typedef boolean (*HM1X_cts_callback_t)(void * context);
+    void setFlowControlCallback(HM1X_cts_callback_t clearToSend, void * context = NULL);
+
+    // Generic Stream ports -- called to move the host side of the link to a
+    // new baud rate and framing.
+    typedef void (*HM1X_baud_callback_t)(unsigned long baud, HM1X_stop_bits_t stopBits, HM1X_parity_t parity, void * context);
+
+protected:
     
     HM1X_model_t _btModel;
-
-#ifdef HM1X_HARDWARE_SERIAL_ENABLED
-    HardwareSerial * _serialPort;
-#endif
-#ifdef HM1X_SOFTWARE_SERIAL_ENABLED
-    SoftwareSerial * _softSerial;
-#endif
-#ifdef HM1X_I2C_ENABLED
-    TwoWire * _wirePort;
-    uint8_t _wireAddress;
-#endif
+    const HM1X_model_info_t * _modelInfo;
 
     boolean _connectedEdr;
     boolean _connectedBle;
-    String _edrAddress;
-    String _bleAddress;
+    char _edrAddress[HM1X_ADDRESS_LENGTH + 1];
+    char _bleAddress[HM1X_ADDRESS_LENGTH + 1];
 
-    String _response;
+    // Data poll() has received: _response[_responseRead.._responseLength)
+    char _response[HM1X_POLL_BUFFER_LENGTH + 1];
+    uint16_t _responseLength;
+    uint16_t _responseRead;
+    int responseAvailable(void) { return _responseLength - _responseRead; };
 
     boolean _polling;
 
+    unsigned long _baud;
+    HM1X_stop_bits_t _stopBits;
+    HM1X_parity_t _parity;
+
+    int _ctsPin;
+    HM1X_cts_callback_t _ctsCallback;
+    void * _ctsContext;
+    uint8_t _paceBurstSize;
+    uint16_t _paceBurstDelay;
+
+    // Transport primitives
+    virtual size_t hwWrite(const char * buffer, size_t size) = 0;
+    virtual int hwAvailable(void) = 0;
+    virtual char readChar(void) = 0;
+    // Follow the module to a new baud rate (and framing, where supported)
+    virtual void hwBegin(unsigned long baud) = 0;
+    virtual boolean hwFramingSupported(void) { return false; };
+
+    // Try init(). If the module doesn't answer and baud is non-zero, search
+    // for it and move it to baud.
+    boolean connect(unsigned long baud);
     HM1X_error_t init(void);
 
+    // command is an HM1X_COMMAND_* string in flash (NULL: just "AT");
+    // argument, in RAM, follows it -- e.g. "NAME" + "?" sends AT+NAME?
     // Send command with an expected response string/length -- e.g. "OK":
-    HM1X_error_t sendCommandWithResponseAndTimeout(const char * command, char * expectedResponse, uint16_t commandTimeout);
+    HM1X_error_t sendCommandWithResponseAndTimeout(const char * command, const char * argument, char * expectedResponse, uint16_t commandTimeout);
     // Send a command wait for a timeout, check for response -- e.g. "OK" or "OK+LSTE:001122334455"
-    int sendCommandWithTimeout(const char * command, char ** responseDest, uint16_t commandTimeout);
+    // response holds size bytes; anything longer is dropped.
+    int sendCommandWithTimeout(const char * command, const char * argument, char * response, size_t size, uint16_t commandTimeout);
 
-    // Send a command -- prepend AT
-    boolean sendCommand(const char * command);
+    // Copy the <value> of an OK+Get:<value> response, at most maxLength
+    // characters, into value
+    HM1X_error_t copyResponseValue(char * value, const char * response, size_t maxLength);
+
+    // Send a command and wait for expectedResponse, skipping anything
+    // that arrives ahead of it. Stops reading straight after it.
+    HM1X_error_t sendCommandAndWaitFor(const char * command, const char * argument, const char * expectedResponse, uint16_t commandTimeout);
+
+    // Send a command -- prepend AT+
+    boolean sendCommand(const char * command, const char * argument = NULL);
 
     /*void hwFlush(void); // Read and trash all bytes from serial buffer*/
     size_t hwPrint(const char * s);
+    boolean hwPacing(void) { return (_ctsPin >= 0) || (_ctsCallback != NULL) || (_paceBurstSize > 0); };
+    size_t hwPacedWrite(Print * port, const char * buffer, size_t size);
+    boolean hwClearToSend(void);
 
-    int readAvailable(char * inString);
-    char readChar(void);
-    int hwAvailable(void);
-    
-#ifdef HM1X_I2C_ENABLED
-    void writeI2cBaud(uint8_t baudIndex);
-    void setI2cAddress(uint8_t address);
-#endif
+    int readAvailable(char * inString, int size);
 
     HM1X_error_t forceBaud(unsigned long baud);
     HM1X_error_t forceBaud(HM1X_baud_t baud);
-};
\ No newline at end of file
+};
+
+// Run-time transport selection -- begin() with any supported port
+class HM1X_BT : public HM1X_Core {
+public:
+    HM1X_BT(HM1X_model_t type = HM13);
+
+    // Begin -- initialize BT module and ensure it's connected
+#ifdef HM1X_SOFTWARE_SERIAL_ENABLED
+    boolean begin(SoftwareSerial & softSerial, unsigned long baud = 9600);
+#endif
+#ifdef HM1X_HARDWARE_SERIAL_ENABLED
+    boolean begin(HardwareSerial &serialPort, unsigned long baud = 9600);
+#endif
+#ifdef HM1X_I2C_ENABLED
+    // intPin: optional bridge data-ready output (active low). When given,
+    // the bus is only touched while the line is asserted.
+    boolean begin(TwoWire &wirePort, uint8_t address, int intPin = -1, uint32_t clock = HM1X_I2C_CLOCK_STANDARD);
+#endif
+    // Any other serial driver (USB CDC, DMA UARTs, ...), already running at
+    // baud. With onBaud, begin() can search for a module at another rate and
+    // stop bit/parity changes are followed. Without it, the module is only
+    // checked at the current rate.
+    boolean begin(Stream &port, unsigned long baud = 0, HM1X_baud_callback_t onBaud = NULL, void * context = NULL);
+
+#ifdef HM1X_I2C_ENABLED
+    // Qwiic bridge -- see HM1X_QwiicBridge.h
+    HM1X_QwiicBridge & qwiicBridge(void) { return _bridge; };
+
+    void setI2cPollInterval(uint16_t ms) { _bridge.setPollInterval(ms); };
+    uint32_t i2cTransactions(void) { return _bridge.transactions(); };
+    uint32_t i2cBusBytes(void) { return _bridge.busBytes(); };
+    void clearI2cCounters(void) { _bridge.clearCounters(); };
+
+    uint8_t i2cBridgeVersion(void) { return _bridge.version(); };
+    uint8_t i2cBridgeCapabilities(void) { return _bridge.capabilities(); };
+    uint8_t i2cChunkSize(void) { return _bridge.chunkSize(); };
+
+    static uint8_t scanI2c(TwoWire &wirePort, uint8_t * addresses, uint8_t maxAddresses)
+    {
+        return HM1X_QwiicBridge::scan(wirePort, addresses, maxAddresses);
+    };
+    HM1X_error_t changeI2cAddress(uint8_t address) { return _bridge.changeAddress(address); };
+    uint8_t i2cAddress(void) { return _bridge.address(); };
+
+    void setI2cRecoveryPins(int sdaPin, int sclPin) { _bridge.setRecoveryPins(sdaPin, sclPin); };
+    uint32_t i2cErrors(void) { return _bridge.errors(); };
+    uint32_t i2cFailures(void) { return _bridge.failures(); };
+    uint32_t i2cBusRecoveries(void) { return _bridge.busRecoveries(); };
+
+    HM1X_error_t setI2cClock(uint32_t clock) { return _bridge.setClock(clock); };
+    uint32_t i2cClock(void) { return _bridge.clock(); };
+    uint32_t i2cBytesPerSecond(void) { return _bridge.bytesPerSecond(); };
+#endif
+
+private:
+
+#ifdef HM1X_HARDWARE_SERIAL_ENABLED
+    HardwareSerial * _serialPort;
+#endif
+#ifdef HM1X_SOFTWARE_SERIAL_ENABLED
+    SoftwareSerial * _softSerial;
+#endif
+#ifdef HM1X_I2C_ENABLED
+    HM1X_QwiicBridge _bridge;
+#endif
+    Stream * _stream;
+    HM1X_baud_callback_t _onBaud;
+    void * _onBaudContext;
+
+    size_t hwWrite(const char * buffer, size_t size);
+    int hwAvailable(void);
+    char readChar(void);
+    void hwBegin(unsigned long baud);
+    boolean hwFramingSupported(void);
+};
+
+#include "HM1X_BT_T.h"